@@ -185,6 +185,7 @@ option                (URHO3D_NAVIGATION         "Navigation subsystem enabled"
 option                (URHO3D_NETWORK            "Networking subsystem enabled"                          ${URHO3D_ENABLE_ALL})
 option                (URHO3D_PHYSICS            "Physics subsystem enabled"                             ${URHO3D_ENABLE_ALL})
 option                (URHO3D_STEAM_AUDIO        "Enable Steam Audio"                                    ${URHO3D_ENABLE_ALL}                                    )
+cmake_dependent_option(URHO3D_STEAM_AUDIO_EMBREE "Steam Audio Embree ray tracer, needs Embree 2.17 and ISPC" OFF            "URHO3D_STEAM_AUDIO;DESKTOP"    OFF)
 cmake_dependent_option(URHO3D_PROFILING          "Profiler support enabled"                              ${URHO3D_ENABLE_ALL} "NOT EMSCRIPTEN;NOT MINGW;NOT UWP"     OFF)
 cmake_dependent_option(URHO3D_PROFILING_FALLBACK "Profiler uses low-precision timer"                     OFF                  "URHO3D_PROFILING"              OFF)
 cmake_dependent_option(URHO3D_PROFILING_SYSTRACE "Profiler systrace support enabled"                     OFF                  "URHO3D_PROFILING"              OFF)
@@ -0,0 +1,189 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Audio/AudioBusGraph.h>
+#include <Urho3D/Audio/AudioDefs.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+TEST_CASE("AudioBusGraph is saved and loaded")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+
+    AudioBusDesc music;
+    music.name_ = SOUND_MUSIC;
+    music.parent_ = "World";
+    music.duckingSidechain_ = SOUND_VOICE;
+    music.duckingGain_ = 0.3f;
+
+    AudioBusDesc world;
+    world.name_ = "World";
+    world.lowPassFrequency_ = 4000.0f;
+
+    AudioBusDesc master;
+    master.name_ = SOUND_MASTER;
+    master.limiterThreshold_ = 0.9f;
+
+    auto graph = MakeShared<AudioBusGraph>(context);
+    graph->AddBus(music);
+    graph->AddBus(world);
+    graph->AddBus(master);
+    world.gain_ = 0.5f;
+    graph->AddBus(world);
+    REQUIRE(graph->GetBuses().size() == 3);
+
+    VectorBuffer buffer;
+    REQUIRE(graph->Save(buffer, InternalResourceFormat::Json));
+
+    auto loadedGraph = MakeShared<AudioBusGraph>(context);
+    MemoryBuffer source(buffer.GetBuffer());
+    REQUIRE(loadedGraph->Load(source));
+    REQUIRE(loadedGraph->GetBuses().size() == 3);
+
+    const AudioBusDesc* loadedMusic = loadedGraph->GetBus(SOUND_MUSIC);
+    REQUIRE(loadedMusic);
+    CHECK(loadedMusic->parent_ == "World");
+    CHECK(loadedMusic->duckingSidechain_ == SOUND_VOICE);
+    CHECK(loadedMusic->duckingGain_ == 0.3f);
+    CHECK(loadedMusic->gain_ == 1.0f);
+
+    const AudioBusDesc* loadedWorld = loadedGraph->GetBus("World");
+    REQUIRE(loadedWorld);
+    CHECK(loadedWorld->gain_ == 0.5f);
+    CHECK(loadedWorld->lowPassFrequency_ == 4000.0f);
+    CHECK(loadedWorld->parent_.empty());
+
+    const AudioBusDesc* loadedMaster = loadedGraph->GetBus(SOUND_MASTER);
+    REQUIRE(loadedMaster);
+    CHECK(loadedMaster->limiterThreshold_ == 0.9f);
+
+    loadedGraph->RemoveBus("World");
+    CHECK_FALSE(loadedGraph->GetBus("World"));
+}
+
+#if !URHO3D_STEAM_AUDIO
+
+#include <Urho3D/Audio/Audio.h>
+#include <Urho3D/Audio/Sound.h>
+#include <Urho3D/Audio/SoundSource.h>
+#include <Urho3D/Scene/Scene.h>
+
+namespace
+{
+
+/// Mix frames through Audio::MixOutput and return the peak level of the last output frame.
+float MixOutputFrames(Audio* audio, unsigned numFrames)
+{
+    const unsigned numChannels = AUDIO_NUM_CHANNELS[audio->GetSpeakerMode()];
+    const bool floatOutput = audio->GetSampleSize() == numChannels * sizeof(float);
+    ea::vector<unsigned char> output(numFrames * audio->GetSampleSize());
+    audio->MixOutput(output.data(), numFrames);
+
+    float peakLevel = 0.0f;
+    for (unsigned i = (numFrames - 1) * numChannels; i < numFrames * numChannels; ++i)
+    {
+        const float sample = floatOutput ? reinterpret_cast<const float*>(output.data())[i]
+                                         : reinterpret_cast<const short*>(output.data())[i] / 32768.0f;
+        peakLevel = Max(peakLevel, Abs(sample));
+    }
+    return peakLevel;
+}
+
+}
+
+TEST_CASE("Audio mixes sound types through the bus graph")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<Audio>();
+    if (!audio->IsInitialized())
+    {
+        WARN("No audio device, bus mixing is not tested");
+        return;
+    }
+    REQUIRE(audio->SetMode(100, 44100, SPK_STEREO));
+
+    AudioBusDesc voice;
+    voice.name_ = SOUND_VOICE;
+
+    AudioBusDesc music;
+    music.name_ = SOUND_MUSIC;
+    music.duckingSidechain_ = SOUND_VOICE;
+    music.duckingGain_ = 0.25f;
+    music.duckingAttack_ = 0.0f;
+
+    AudioBusDesc master;
+    master.name_ = SOUND_MASTER;
+    master.limiterThreshold_ = 0.3f;
+
+    auto graph = MakeShared<AudioBusGraph>(context);
+    graph->AddBus(voice);
+    graph->AddBus(music);
+    graph->AddBus(master);
+    audio->SetBusGraph(graph);
+
+    const ea::vector<short> data(4096, 8192);
+    auto sound = MakeShared<Sound>(context);
+    sound->SetFormat(44100, true, false);
+    sound->SetData(data.data(), data.size() * sizeof(short));
+    sound->SetLooped(true);
+
+    auto scene = MakeShared<Scene>(context);
+    auto musicSource = scene->CreateComponent<SoundSource>();
+    musicSource->SetSoundType(SOUND_MUSIC);
+    auto voiceSource = scene->CreateComponent<SoundSource>();
+    voiceSource->SetSoundType(SOUND_VOICE);
+
+    {
+        // Keep the device callback out while mixing by hand
+        MutexLock lock(audio->GetMutex());
+        static constexpr unsigned numFrames = 8192;
+
+        // Sound types mix into the bus of the same name only
+        musicSource->Play(sound, 44100.0f, 1.0f);
+        CHECK(MixOutputFrames(audio, numFrames) == Catch::Approx(0.25f).margin(0.01f));
+        CHECK(audio->GetBusLevel(SOUND_MUSIC) == Catch::Approx(0.25f).margin(0.01f));
+        CHECK(audio->GetBusLevel(SOUND_VOICE) == 0.0f);
+
+        // Voice above the sidechain threshold ducks music
+        voiceSource->Play(sound, 44100.0f, 0.8f);
+        CHECK(MixOutputFrames(audio, numFrames) == Catch::Approx(0.2f + 0.25f * 0.25f).margin(0.01f));
+        CHECK(audio->GetBusLevel(SOUND_VOICE) == Catch::Approx(0.2f).margin(0.01f));
+        CHECK(audio->GetBusLevel(SOUND_MUSIC) == Catch::Approx(0.25f * 0.25f).margin(0.01f));
+
+        // Master limiter keeps the output under its threshold
+        audio->SetBusGain(SOUND_MUSIC, 4.0f);
+        CHECK(audio->GetBusGain(SOUND_MUSIC) == 4.0f);
+        CHECK(MixOutputFrames(audio, numFrames) == Catch::Approx(0.3f).margin(0.01f));
+        CHECK(audio->GetBusLevel(SOUND_MASTER) <= 0.3f + 0.01f);
+
+        musicSource->Stop();
+        voiceSource->Stop();
+    }
+
+    scene = nullptr;
+    audio->SetBusGraph(nullptr);
+}
+
+#endif
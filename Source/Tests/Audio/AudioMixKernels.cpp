@@ -0,0 +1,210 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Audio/AudioMixKernels.h>
+#include <Urho3D/Audio/Sound.h>
+#include <Urho3D/Audio/SoundSource.h>
+#include <Urho3D/Scene/Scene.h>
+
+TEST_CASE("Audio mix kernels match scalar mixing")
+{
+    static constexpr unsigned numFrames = 67;
+
+    ea::vector<float> source(numFrames * 2);
+    for (unsigned i = 0; i < source.size(); ++i)
+        source[i] = Sin(i * 13.0f);
+
+    const float leftGains[MaxMixChannels] = {0.9f, 0.1f, 0.5f, -0.3f, 0.7f, 0.2f};
+    const float rightGains[MaxMixChannels] = {0.2f, 0.8f, -0.4f, 0.6f, 0.1f, 0.3f};
+    for (const unsigned numChannels : {1u, 2u, 4u, 6u})
+    {
+        ea::vector<float> mono(numFrames * numChannels, 0.25f);
+        ea::vector<float> stereo(numFrames * numChannels, 0.25f);
+        MixMonoFrames(mono.data(), source.data(), numFrames, numChannels, leftGains);
+        MixStereoFrames(stereo.data(), source.data(), numFrames, numChannels, leftGains, rightGains);
+
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            for (unsigned channel = 0; channel < numChannels; ++channel)
+            {
+                const float expectedMono = 0.25f + source[frame] * leftGains[channel];
+                const float expectedStereo =
+                    0.25f + source[frame * 2] * leftGains[channel] + source[frame * 2 + 1] * rightGains[channel];
+                CHECK(mono[frame * numChannels + channel] == Catch::Approx(expectedMono).margin(1e-5f));
+                CHECK(stereo[frame * numChannels + channel] == Catch::Approx(expectedStereo).margin(1e-5f));
+            }
+        }
+    }
+}
+
+TEST_CASE("Audio bus kernels ramp gains and measure peaks")
+{
+    static constexpr unsigned numFrames = 67;
+
+    for (const unsigned numChannels : {1u, 2u, 4u, 6u})
+    {
+        ea::vector<float> source(numFrames * numChannels);
+        for (unsigned i = 0; i < source.size(); ++i)
+            source[i] = Sin(i * 13.0f);
+
+        ea::vector<float> mixed(source.size(), 0.25f);
+        ea::vector<float> scaled = source;
+        MixGainRamp(mixed.data(), source.data(), numFrames, numChannels, 0.2f, 0.9f);
+        ApplyGainRamp(scaled.data(), numFrames, numChannels, 0.2f, 0.9f);
+
+        float peak = 0.0f;
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+        {
+            const float gain = Lerp(0.2f, 0.9f, static_cast<float>(frame) / numFrames);
+            for (unsigned channel = 0; channel < numChannels; ++channel)
+            {
+                const unsigned i = frame * numChannels + channel;
+                CHECK(mixed[i] == Catch::Approx(0.25f + source[i] * gain).margin(1e-5f));
+                CHECK(scaled[i] == Catch::Approx(source[i] * gain).margin(1e-5f));
+                peak = Max(peak, Abs(source[i]));
+            }
+        }
+        CHECK(GetPeakLevel(source.data(), source.size()) == peak);
+    }
+
+    // Low-pass settles at DC and removes alternating content
+    ea::vector<float> frames(2 * 256);
+    for (unsigned frame = 0; frame < 256; ++frame)
+    {
+        frames[2 * frame] = 0.5f;
+        frames[2 * frame + 1] = frame % 2 ? 0.5f : -0.5f;
+    }
+    float state[2]{};
+    LowPassFrames(frames.data(), 256, 2, 0.1f, state);
+    CHECK(frames[2 * 255] == Catch::Approx(0.5f).margin(1e-3f));
+    CHECK(Abs(frames[2 * 255 + 1]) < 0.05f);
+}
+
+TEST_CASE("Audio float samples saturate when converted to 16-bit")
+{
+    const float source[] = {0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 3.0f, -3.0f};
+    short dest[7]{};
+    ConvertSamples(dest, source, 7);
+    CHECK(dest[0] == 0);
+    CHECK(dest[1] == 16384);
+    CHECK(dest[2] == -16384);
+    CHECK(dest[3] == 32767);
+    CHECK(dest[4] == -32768);
+    CHECK(dest[5] == 32767);
+    CHECK(dest[6] == -32768);
+
+    float clamped[7]{};
+    ClampSamples(clamped, source, 7);
+    CHECK(clamped[5] == 1.0f);
+    CHECK(clamped[6] == -1.0f);
+}
+
+// Legacy sound sources need the Audio subsystem, which is replaced by SteamAudio
+#if !URHO3D_STEAM_AUDIO
+
+namespace
+{
+
+/// Create looped 16-bit sound holding a ramp.
+SharedPtr<Sound> CreateRampSound(Context* context, bool stereo)
+{
+    ea::vector<short> data(4096 * (stereo ? 2 : 1));
+    for (unsigned i = 0; i < data.size(); ++i)
+        data[i] = static_cast<short>((i * 37) % 32768 - 16384);
+
+    auto sound = MakeShared<Sound>(context);
+    sound->SetFormat(44100, true, stereo);
+    sound->SetData(data.data(), data.size() * sizeof(short));
+    sound->SetLooped(true);
+    return sound;
+}
+
+}
+
+TEST_CASE("SoundSource float mixer matches fixed point mixer")
+{
+    static constexpr unsigned numFrames = 1024;
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+
+    for (const bool stereo : {false, true})
+    {
+        const auto sound = CreateRampSound(context, stereo);
+        auto scene = MakeShared<Scene>(context);
+        auto fixedSource = scene->CreateComponent<SoundSource>();
+        auto floatSource = scene->CreateComponent<SoundSource>();
+        fixedSource->Play(sound, 44100.0f * 0.7f, 0.8f, 0.3f);
+        floatSource->Play(sound, 44100.0f * 0.7f, 0.8f, 0.3f);
+
+        ea::vector<int> fixedOutput(numFrames * 2);
+        ea::vector<float> floatOutput(numFrames * 2);
+        ea::vector<float> scratch(numFrames * 2);
+        fixedSource->Mix(fixedOutput.data(), numFrames, 44100, SPK_STEREO, true);
+        floatSource->Mix(floatOutput.data(), scratch.data(), numFrames, 44100, SPK_STEREO, true);
+
+        // Fixed point mixer truncates gains and interpolation weights
+        for (unsigned i = 0; i < fixedOutput.size(); ++i)
+            CHECK(floatOutput[i] * 32768.0f == Catch::Approx(fixedOutput[i]).margin(256.0f));
+    }
+}
+
+TEST_CASE("SoundSource mixer benchmark", "[.][benchmark]")
+{
+    static constexpr unsigned numFrames = 1024;
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    const auto sound = CreateRampSound(context, false);
+    auto scene = MakeShared<Scene>(context);
+
+    ea::vector<SoundSource*> sources;
+    ea::vector<int> fixedOutput(numFrames * 2);
+    ea::vector<float> floatOutput(numFrames * 2);
+    ea::vector<float> scratch(numFrames * 2);
+    for (const unsigned numSources : {64u, 256u, 1024u})
+    {
+        while (sources.size() < numSources)
+        {
+            auto source = scene->CreateComponent<SoundSource>();
+            source->Play(sound, 44100.0f * Random(0.5f, 1.5f), 0.01f, Random(-1.0f, 1.0f));
+            sources.push_back(source);
+        }
+
+        BENCHMARK(Format("Fixed point mix of {} sources", numSources).c_str())
+        {
+            ea::fill(fixedOutput.begin(), fixedOutput.end(), 0);
+            for (SoundSource* source : sources)
+                source->Mix(fixedOutput.data(), numFrames, 48000, SPK_STEREO, true);
+            return fixedOutput[0];
+        };
+
+        BENCHMARK(Format("Float mix of {} sources", numSources).c_str())
+        {
+            ea::fill(floatOutput.begin(), floatOutput.end(), 0.0f);
+            for (SoundSource* source : sources)
+                source->Mix(floatOutput.data(), scratch.data(), numFrames, 48000, SPK_STEREO, true);
+            return floatOutput[0];
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Audio/AudioResampler.h>
+#include <Urho3D/Math/MathDefs.h>
+
+namespace
+{
+
+/// Resample a sine wave in blocks and return the output.
+ea::vector<float> ResampleSine(float frequency, float inputRate, float outputRate, unsigned numBlocks, unsigned blockSize)
+{
+    const double step = inputRate / outputRate;
+    const ResamplerFilterBank* bank = ResamplerFilterBank::Get(step);
+
+    AudioResampler resampler;
+    resampler.Initialize(1, blockSize);
+
+    ea::vector<float> input;
+    ea::vector<float> output(numBlocks * blockSize);
+    unsigned inputPosition = 0;
+    for (unsigned block = 0; block < numBlocks; ++block)
+    {
+        input.resize(resampler.GetNumInputFramesNeeded(blockSize, step));
+        for (float& sample : input)
+            sample = Sin(360.0f * frequency * inputPosition++ / inputRate);
+        resampler.PushInput(input.data(), input.size());
+        resampler.Process(&output[block * blockSize], blockSize, step, bank);
+    }
+    return output;
+}
+
+/// Return number of rising zero crossings.
+unsigned CountCycles(const ea::vector<float>& samples, unsigned begin)
+{
+    unsigned count = 0;
+    for (unsigned i = begin + 1; i < samples.size(); ++i)
+    {
+        if (samples[i - 1] < 0.0f && samples[i] >= 0.0f)
+            ++count;
+    }
+    return count;
+}
+
+}
+
+TEST_CASE("AudioResampler preserves pitch and amplitude")
+{
+    static constexpr unsigned numBlocks = 16;
+    static constexpr unsigned blockSize = 1024;
+    static constexpr unsigned settleFrames = 64;
+
+    for (const float inputRate : {22050.0f, 44100.0f, 96000.0f})
+    {
+        const ea::vector<float> output = ResampleSine(1000.0f, inputRate, 44100.0f, numBlocks, blockSize);
+
+        // 1 kHz over the output duration, excluding the filter warm-up
+        const float duration = (numBlocks * blockSize - settleFrames) / 44100.0f;
+        CHECK(CountCycles(output, settleFrames) == Catch::Approx(1000.0f * duration).margin(2.0f));
+
+        float peak = 0.0f;
+        for (unsigned i = settleFrames; i < output.size(); ++i)
+            peak = Max(peak, Abs(output[i]));
+        CHECK(peak == Catch::Approx(1.0f).margin(0.02f));
+    }
+}
+
+TEST_CASE("AudioResampler removes content above output Nyquist frequency")
+{
+    // 20 kHz cannot be represented at 22050 Hz
+    const ea::vector<float> output = ResampleSine(20000.0f, 44100.0f, 22050.0f, 8, 1024);
+
+    float peak = 0.0f;
+    for (unsigned i = 64; i < output.size(); ++i)
+        peak = Max(peak, Abs(output[i]));
+    CHECK(peak < 0.05f);
+}
+
+TEST_CASE("AudioResampler benchmark", "[.][benchmark]")
+{
+    static constexpr unsigned blockSize = 1024;
+    static constexpr double step = 22050.0 / 48000.0 * 1.1;
+    const ResamplerFilterBank* bank = ResamplerFilterBank::Get(step);
+
+    AudioResampler resampler;
+    resampler.Initialize(2, blockSize);
+    ea::vector<float> input(2 * (static_cast<unsigned>(blockSize * AudioResampler::MaxStep) + ResamplerFilterBank::NumTaps), 0.5f);
+    ea::vector<float> output(2 * blockSize);
+
+    // Cost of one stereo source for one block
+    BENCHMARK("Resample stereo block per source")
+    {
+        resampler.PushInput(input.data(), resampler.GetNumInputFramesNeeded(blockSize, step));
+        resampler.Process(output.data(), blockSize, step, bank);
+        return output[0];
+    };
+}
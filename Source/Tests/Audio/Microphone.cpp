@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Audio/Microphone.h>
+#include <Urho3D/Core/Timer.h>
+
+namespace
+{
+
+/// Stand-in for a voice codec: stores samples as little-endian bytes.
+class RawMicrophoneEncoder : public MicrophoneEncoder
+{
+public:
+    explicit RawMicrophoneEncoder(unsigned frameSize) : frameSize_(frameSize) {}
+
+    unsigned GetFrameSize() const override { return frameSize_; }
+
+    bool Encode(ea::span<const int16_t> samples, ea::vector<unsigned char>& packet) override
+    {
+        for (int16_t sample : samples)
+        {
+            packet.push_back(static_cast<unsigned char>(sample & 0xff));
+            packet.push_back(static_cast<unsigned char>((sample >> 8) & 0xff));
+        }
+        return true;
+    }
+
+private:
+    unsigned frameSize_{};
+};
+
+void Capture(Microphone* microphone, int16_t first, unsigned count)
+{
+    ea::vector<int16_t> samples(count);
+    for (unsigned i = 0; i < count; ++i)
+        samples[i] = static_cast<int16_t>(first + i);
+    microphone->Update(reinterpret_cast<unsigned char*>(samples.data()), count * sizeof(int16_t));
+}
+
+}
+
+TEST_CASE("Microphone exposes captured samples without copying")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto microphone = MakeShared<Microphone>(context);
+    microphone->SetCaptureBufferSize(16);
+    microphone->SetStreaming(true);
+    microphone->SetEnabled(true);
+
+    Capture(microphone, 100, 10);
+    REQUIRE(microphone->GetNumCaptured() == 10);
+    REQUIRE(microphone->ConsumeCapture(8) == 8);
+
+    // Second write wraps around the end of the capture buffer and overflows it
+    Capture(microphone, 200, 16);
+    REQUIRE(microphone->GetNumCaptured() == 16);
+    REQUIRE(microphone->GetNumDroppedSamples() == 2);
+
+    const Microphone::CaptureSpans spans = microphone->PeekCapture();
+    REQUIRE(spans.first.size() == 8);
+    REQUIRE(spans.second.size() == 8);
+    REQUIRE(spans.first[0] == 108);
+    REQUIRE(spans.first[2] == 200);
+    REQUIRE(spans.second[7] == 213);
+    REQUIRE(microphone->ConsumeCapture(16) == 16);
+    REQUIRE(microphone->GetNumCaptured() == 0);
+    REQUIRE(microphone->GetData().empty());
+}
+
+TEST_CASE("Microphone encodes captured frames into packets")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto microphone = MakeShared<Microphone>(context);
+    microphone->SetCaptureBufferSize(16);
+    microphone->SetEncoder(MakeShared<RawMicrophoneEncoder>(6), false);
+    microphone->SetEnabled(true);
+
+    ea::vector<unsigned char> packet;
+    REQUIRE_FALSE(microphone->ReadPacket(packet));
+
+    Capture(microphone, 0, 10);
+    REQUIRE(microphone->EncodeCaptured() == 1);
+    REQUIRE(microphone->GetNumCaptured() == 4);
+
+    // Frame of samples 12..17 wraps around the capture buffer
+    Capture(microphone, 10, 10);
+    REQUIRE(microphone->EncodeCaptured() == 2);
+    REQUIRE(microphone->GetNumCaptured() == 2);
+
+    for (int16_t first : {0, 6, 12})
+    {
+        REQUIRE(microphone->ReadPacket(packet));
+        REQUIRE(packet.size() == 12);
+        for (unsigned i = 0; i < 6; ++i)
+            CHECK(static_cast<int16_t>(packet[i * 2] | (packet[i * 2 + 1] << 8)) == first + static_cast<int>(i));
+    }
+    REQUIRE_FALSE(microphone->ReadPacket(packet));
+    REQUIRE(microphone->GetNumDroppedPackets() == 0);
+
+    microphone->SetEncoder(nullptr);
+}
+
+#ifdef URHO3D_THREADING
+TEST_CASE("Microphone capture buffer is resized while the encoder thread runs")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto microphone = MakeShared<Microphone>(context);
+    microphone->SetCaptureBufferSize(16);
+    microphone->SetEncoder(MakeShared<RawMicrophoneEncoder>(4), true);
+    microphone->SetEnabled(true);
+
+    // Resizing pauses the encoder thread and restarts it afterwards
+    microphone->SetCaptureBufferSize(64);
+    REQUIRE(microphone->GetCaptureBufferSize() == 64);
+    Capture(microphone, 0, 40);
+
+    ea::vector<unsigned char> packet;
+    unsigned numPackets = 0;
+    for (unsigned i = 0; i < 200 && numPackets < 10; ++i)
+    {
+        if (microphone->ReadPacket(packet))
+            ++numPackets;
+        else
+            Time::Sleep(5);
+    }
+    CHECK(numPackets == 10);
+    CHECK(microphone->GetNumDroppedSamples() == 0);
+
+    microphone->SetEncoder(nullptr);
+}
+#endif
@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Audio/PrefetchSoundStream.h>
+
+namespace
+{
+
+/// 8-bit mono stream counting up from the play position, ending after a fixed number of samples.
+class CountingSoundStream : public SoundStream
+{
+public:
+    explicit CountingSoundStream(unsigned length) : length_(length)
+    {
+        SetFormat(44100, false, false);
+        SetStopAtEnd(true);
+    }
+
+    bool Seek(unsigned sample_number) override
+    {
+        position_ = Min(sample_number, length_);
+        return true;
+    }
+
+    unsigned GetData(signed char* dest, unsigned numBytes) override
+    {
+        const unsigned count = Min(numBytes, length_ - position_);
+        for (unsigned i = 0; i < count; ++i)
+            dest[i] = static_cast<signed char>(position_++ % 128);
+        return count;
+    }
+
+private:
+    unsigned length_{};
+    unsigned position_{};
+};
+
+}
+
+TEST_CASE("PrefetchSoundStream plays decoded data ahead of the stream")
+{
+    auto stream = MakeShared<PrefetchSoundStream>(new CountingSoundStream(1000), 256);
+    REQUIRE(stream->GetCapacity() == 256);
+    CHECK(stream->GetStopAtEnd());
+
+    // Buffer is primed on construction
+    CHECK(stream->GetNumBufferedBytes() == 256);
+
+    signed char data[200]{};
+    REQUIRE(stream->GetData(data, 200) == 200);
+    CHECK(data[0] == 0);
+    CHECK(data[199] == 199 % 128);
+
+    // Missing data is padded with silence instead of being decoded by the mixing thread
+    REQUIRE(stream->GetData(data, 200) == 200);
+    CHECK(data[55] == 255 % 128);
+    CHECK(data[56] == 0);
+    CHECK(data[199] == 0);
+    CHECK(stream->GetNumUnderruns() == 1);
+
+    // The decoder thread catches up
+    stream->Decode();
+    REQUIRE(stream->GetData(data, 200) == 200);
+    CHECK(data[0] == 256 % 128);
+    CHECK(stream->GetNumUnderruns() == 1);
+
+    // Data decoded before a seek is dropped, the seek decodes into the space left
+    REQUIRE(stream->Seek(900));
+    REQUIRE(stream->GetData(data, 200) == 100);
+    CHECK(data[0] == 900 % 128);
+    CHECK(data[99] == 999 % 128);
+
+    // Finished stream returns no more data
+    CHECK(stream->GetData(data, 200) == 0);
+    CHECK(stream->GetNumUnderruns() == 1);
+}
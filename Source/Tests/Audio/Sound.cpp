@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Audio/Sound.h>
+#include <Urho3D/Resource/ResourceCache.h>
+
+TEST_CASE("Sound builds deinterleaved float copy on demand")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+
+    const short data[] = {32767, 0, -32767, 16384, 0, -16384};
+    auto sound = MakeShared<Sound>(context);
+    sound->SetFormat(44100, true, true);
+    sound->SetData(data, sizeof(data));
+    const unsigned memoryUse = sound->GetMemoryUse();
+    REQUIRE_FALSE(sound->HasFloatData());
+
+    const auto floatData = sound->GetFloatData();
+    REQUIRE(floatData);
+    REQUIRE(floatData->numChannels_ == 2);
+    REQUIRE(floatData->numFrames_ == 3);
+    CHECK(floatData->GetChannel(0)[0] == Catch::Approx(1.0f));
+    CHECK(floatData->GetChannel(0)[1] == Catch::Approx(-1.0f));
+    CHECK(floatData->GetChannel(0)[2] == Catch::Approx(0.0f));
+    CHECK(floatData->GetChannel(1)[0] == Catch::Approx(0.0f));
+    CHECK(floatData->GetChannel(1)[1] == Catch::Approx(0.5f).margin(0.001f));
+    CHECK(floatData->GetChannel(1)[2] == Catch::Approx(-0.5f).margin(0.001f));
+    CHECK(sound->GetMemoryUse() == memoryUse + 6 * sizeof(float));
+    CHECK(sound->GetFloatData() == floatData);
+
+    // Users keep their copy after release
+    REQUIRE(sound->ReleaseCachedData());
+    CHECK_FALSE(sound->HasFloatData());
+    CHECK(sound->GetMemoryUse() == memoryUse);
+    CHECK(floatData->GetChannel(0)[0] == Catch::Approx(1.0f));
+}
+
+TEST_CASE("ResourceCache releases float copies of other sounds over memory budget")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto cache = context->GetSubsystem<ResourceCache>();
+
+    const ea::vector<short> data(1024);
+    ea::vector<SharedPtr<Sound>> sounds;
+    for (const char* name : {"Tests/FloatCacheSound0.wav", "Tests/FloatCacheSound1.wav"})
+    {
+        auto sound = MakeShared<Sound>(context);
+        sound->SetName(name);
+        sound->SetFormat(44100, true, false);
+        sound->SetData(data.data(), data.size() * sizeof(short));
+        REQUIRE(cache->AddManualResource(sound));
+        sounds.push_back(sound);
+    }
+
+    // Room for one float copy. Sounds in use can not be released, but float copies of other sounds can
+    cache->CheckMemoryBudget(Sound::GetTypeStatic());
+    const unsigned floatDataSize = data.size() * sizeof(float);
+    cache->SetMemoryBudget(Sound::GetTypeStatic(), cache->GetMemoryUse(Sound::GetTypeStatic()) + floatDataSize + 1);
+    CHECK(sounds[0]->GetFloatData());
+    CHECK(sounds[0]->HasFloatData());
+
+    // The budget is enforced before the copy is built, so the new copy is kept
+    CHECK(sounds[1]->GetFloatData());
+    CHECK(sounds[1]->HasFloatData());
+    CHECK_FALSE(sounds[0]->HasFloatData());
+    CHECK(cache->GetResource<Sound>("Tests/FloatCacheSound0.wav") == sounds[0]);
+
+    cache->SetMemoryBudget(Sound::GetTypeStatic(), 0);
+    cache->ReleaseResource(Sound::GetTypeStatic(), "Tests/FloatCacheSound0.wav", true);
+    cache->ReleaseResource(Sound::GetTypeStatic(), "Tests/FloatCacheSound1.wav", true);
+}
@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#if !URHO3D_STEAM_AUDIO
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Audio/Audio.h>
+#include <Urho3D/Audio/Sound.h>
+#include <Urho3D/Audio/SoundSource.h>
+#include <Urho3D/Scene/Scene.h>
+
+TEST_CASE("Audio keeps the most important sound sources audible over voice limits")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<Audio>();
+
+    const ea::vector<short> data(4096, 8192);
+    auto sound = MakeShared<Sound>(context);
+    sound->SetFormat(44100, true, false);
+    sound->SetData(data.data(), data.size() * sizeof(short));
+    sound->SetLooped(true);
+
+    auto scene = MakeShared<Scene>(context);
+    ea::vector<SoundSource*> sources;
+    for (const float gain : {0.2f, 0.8f, 0.4f, 0.6f})
+    {
+        auto source = scene->CreateComponent<SoundSource>();
+        source->Play(sound, 44100.0f, gain);
+        sources.push_back(source);
+    }
+
+    // Loudest sources win
+    audio->SetMaxVoices(2);
+    audio->UpdateVoices();
+    CHECK(sources[0]->IsVirtual());
+    CHECK_FALSE(sources[1]->IsVirtual());
+    CHECK(sources[2]->IsVirtual());
+    CHECK_FALSE(sources[3]->IsVirtual());
+    CHECK(audio->GetNumVirtualVoices() == 2);
+
+    // Priority wins over audibility
+    sources[0]->SetPriority(1);
+    audio->UpdateVoices();
+    CHECK_FALSE(sources[0]->IsVirtual());
+    CHECK_FALSE(sources[1]->IsVirtual());
+    CHECK(sources[3]->IsVirtual());
+
+    // Sound type limit applies on top of the global limit
+    sources[1]->SetSoundType(SOUND_AMBIENT);
+    sources[2]->SetSoundType(SOUND_AMBIENT);
+    audio->SetMaxVoices(3);
+    audio->SetMaxVoices(SOUND_AMBIENT, 1);
+    audio->UpdateVoices();
+    CHECK_FALSE(sources[0]->IsVirtual());
+    CHECK_FALSE(sources[1]->IsVirtual());
+    CHECK(sources[2]->IsVirtual());
+    CHECK_FALSE(sources[3]->IsVirtual());
+
+    // Virtual sources are not mixed but keep their play position moving
+    static constexpr unsigned numFrames = 4096;
+    ea::vector<float> output(numFrames * 2);
+    ea::vector<float> scratch(numFrames * 2);
+    audio->SetVoiceFadeTime(1024 / 44100.0f);
+    sources[1]->Mix(output.data(), scratch.data(), numFrames, 44100, SPK_STEREO, false);
+    sources[2]->Mix(output.data(), scratch.data(), numFrames, 44100, SPK_STEREO, false);
+    CHECK(output.back() == Catch::Approx(0.25f * 0.8f));
+
+    ea::fill(output.begin(), output.end(), 0.0f);
+    const auto position = sources[2]->GetPlayPosition();
+    sources[2]->Mix(output.data(), scratch.data(), 1024, 44100, SPK_STEREO, false);
+    CHECK(output[0] == 0.0f);
+    CHECK(sources[2]->GetPlayPosition() != position);
+
+    audio->SetMaxVoices(0);
+    audio->SetMaxVoices(SOUND_AMBIENT, 0);
+    audio->SetVoiceFadeTime(0.05f);
+    audio->UpdateVoices();
+    CHECK_FALSE(sources[2]->IsVirtual());
+    CHECK(audio->GetNumVirtualVoices() == 0);
+}
+
+#endif
@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "AudioUtils.h"
+
+#include "CommonUtils.h"
+#include "ModelUtils.h"
+
+#include <Urho3D/Core/StringUtils.h>
+
+namespace
+{
+
+/// Append a grid of quads spanning the parallelogram at origin with edges u and v.
+void AppendGrid(GeometryLODView& dest, const Vector3& origin, const Vector3& u, const Vector3& v, unsigned resolution)
+{
+    const Vector3 normal = u.CrossProduct(v).Normalized();
+    const unsigned baseIndex = dest.vertices_.size();
+    for (unsigned j = 0; j <= resolution; ++j)
+    {
+        for (unsigned i = 0; i <= resolution; ++i)
+        {
+            const Vector3 position = origin + u * (float(i) / resolution) + v * (float(j) / resolution);
+            dest.vertices_.push_back(Tests::MakeModelVertex(position, normal, Color::WHITE));
+        }
+    }
+
+    const unsigned stride = resolution + 1;
+    for (unsigned j = 0; j < resolution; ++j)
+    {
+        for (unsigned i = 0; i < resolution; ++i)
+        {
+            const unsigned corner = baseIndex + j * stride + i;
+            const unsigned indices[] = {corner, corner + stride, corner + 1, corner + 1, corner + stride, corner + stride + 1};
+            dest.indices_.insert(dest.indices_.end(), ea::begin(indices), ea::end(indices));
+        }
+    }
+}
+
+}
+
+namespace Tests
+{
+
+SharedPtr<Sound> CreateToneSound(Context* context, float amplitude)
+{
+    ea::vector<short> data(4410);
+    for (unsigned i = 0; i < data.size(); ++i)
+        data[i] = static_cast<short>(Sin(i * 4.0f) * amplitude * 32768.0f);
+
+    auto sound = MakeShared<Sound>(context);
+    sound->SetFormat(44100, true, false);
+    sound->SetData(data.data(), data.size() * sizeof(short));
+    return sound;
+}
+
+Model* GetRoomModel(Context* context, unsigned numTriangles)
+{
+    const unsigned resolution = CeilToInt(Sqrt(numTriangles / 12.0f));
+    return Tests::GetOrCreateResource<Model>(context, Format("Tests/SteamAudio/Room{}.mdl", numTriangles), [&](Context* context)
+    {
+        auto modelView = MakeShared<ModelView>(context);
+        auto& geometries = modelView->GetGeometries();
+        geometries.resize(1);
+        geometries[0].lods_.resize(1);
+        auto& lod = geometries[0].lods_[0];
+        lod.vertexFormat_ = Tests::GetVertexFormat();
+
+        const Vector3 min{-20.0f, 0.0f, -20.0f};
+        const Vector3 size{40.0f, 6.0f, 40.0f};
+        const Vector3 x{size.x_, 0.0f, 0.0f};
+        const Vector3 y{0.0f, size.y_, 0.0f};
+        const Vector3 z{0.0f, 0.0f, size.z_};
+        AppendGrid(lod, min, z, x, resolution);
+        AppendGrid(lod, min + y, x, z, resolution);
+        AppendGrid(lod, min, x, y, resolution);
+        AppendGrid(lod, min + z, y, x, resolution);
+        AppendGrid(lod, min, y, z, resolution);
+        AppendGrid(lod, min + x, z, y, resolution);
+
+        return modelView->ExportModel();
+    });
+}
+
+}
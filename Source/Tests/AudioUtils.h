@@ -0,0 +1,39 @@
+//
+// Copyright (c) 2017-2021 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Audio/Sound.h>
+#include <Urho3D/Graphics/Model.h>
+
+using namespace Urho3D;
+
+namespace Tests
+{
+
+/// Create 0.1 second 16-bit mono tone at 44100 Hz.
+SharedPtr<Sound> CreateToneSound(Context* context, float amplitude = 0.5f);
+
+/// Return 40x6x40 room model centered at the floor origin, with walls tessellated to at least the given number of triangles.
+Model* GetRoomModel(Context* context, unsigned numTriangles = 12);
+
+}
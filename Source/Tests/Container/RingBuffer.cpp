@@ -0,0 +1,124 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Container/RingBuffer.h>
+
+#include <thread>
+
+TEST_CASE("RingBuffer transfers elements in order")
+{
+    RingBuffer<int> buffer{5};
+    REQUIRE(buffer.GetCapacity() == 8);
+    REQUIRE(buffer.GetNumReadable() == 0);
+    REQUIRE(buffer.GetNumWritable() == 8);
+
+    const int input[] = {1, 2, 3, 4, 5, 6};
+    int output[8]{};
+
+    REQUIRE(buffer.Write(input, 6) == 6);
+    REQUIRE(buffer.Read(output, 4) == 4);
+    REQUIRE(output[0] == 1);
+    REQUIRE(output[3] == 4);
+
+    // Write wraps around the end of the storage
+    REQUIRE(buffer.Write(input, 6) == 6);
+    REQUIRE(buffer.GetNumReadable() == 8);
+    REQUIRE(buffer.Write(input, 1) == 0);
+
+    REQUIRE(buffer.Discard(1) == 1);
+    REQUIRE(buffer.Read(output, 8) == 7);
+    REQUIRE(output[0] == 6);
+    REQUIRE(output[1] == 1);
+    REQUIRE(output[6] == 6);
+    REQUIRE(buffer.Read(output, 1) == 0);
+}
+
+TEST_CASE("RingBuffer exposes readable elements in place")
+{
+    RingBuffer<int> buffer{4};
+    REQUIRE(buffer.Peek().first.empty());
+
+    const int input[] = {1, 2, 3, 4};
+    int output[4]{};
+    REQUIRE(buffer.Write(input, 3) == 3);
+    REQUIRE(buffer.Read(output, 2) == 2);
+    REQUIRE(buffer.Write(input, 3) == 3);
+
+    // Readable range is 3, 1, 2, 3 and wraps after the second element
+    const auto spans = buffer.Peek();
+    REQUIRE(spans.first.size() == 2);
+    REQUIRE(spans.second.size() == 2);
+    REQUIRE(spans.first[0] == 3);
+    REQUIRE(spans.first[1] == 1);
+    REQUIRE(spans.second[0] == 2);
+    REQUIRE(spans.second[1] == 3);
+    REQUIRE(buffer.GetNumReadable() == 4);
+
+    const auto partial = buffer.Peek(3);
+    REQUIRE(partial.first.size() == 2);
+    REQUIRE(partial.second.size() == 1);
+
+    REQUIRE(buffer.Discard(2) == 2);
+    const auto rest = buffer.Peek();
+    REQUIRE(rest.first.size() == 2);
+    REQUIRE(rest.second.empty());
+    REQUIRE(rest.first[0] == 2);
+}
+
+TEST_CASE("RingBuffer hands over all elements between threads")
+{
+    static constexpr unsigned numValues = 200000;
+    RingBuffer<unsigned> buffer{64};
+
+    std::thread producer([&]
+    {
+        unsigned chunk[7];
+        unsigned next = 0;
+        while (next != numValues)
+        {
+            unsigned count = 0;
+            while (count != 7 && next + count != numValues)
+            {
+                chunk[count] = next + count;
+                ++count;
+            }
+            next += buffer.Write(chunk, count);
+        }
+    });
+
+    unsigned expected = 0;
+    bool ordered = true;
+    unsigned chunk[5];
+    while (expected != numValues)
+    {
+        const unsigned count = buffer.Read(chunk, 5);
+        for (unsigned i = 0; i < count; ++i)
+            ordered &= chunk[i] == expected++;
+    }
+
+    producer.join();
+    REQUIRE(ordered);
+    REQUIRE(buffer.GetNumReadable() == 0);
+}
@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Container/TripleBuffer.h>
+
+#include <thread>
+
+TEST_CASE("TripleBuffer returns latest published value")
+{
+    TripleBuffer<int> buffer{0};
+    REQUIRE_FALSE(buffer.HasPending());
+    REQUIRE_FALSE(buffer.Update());
+    REQUIRE(buffer.GetFront() == 0);
+
+    buffer.Publish(1);
+    REQUIRE(buffer.HasPending());
+    REQUIRE(buffer.Update());
+    REQUIRE(buffer.GetFront() == 1);
+    REQUIRE_FALSE(buffer.Update());
+    REQUIRE(buffer.GetFront() == 1);
+
+    // Intermediate values are dropped
+    buffer.Publish(2);
+    buffer.Publish(3);
+    buffer.Publish(4);
+    REQUIRE(buffer.Read() == 4);
+    REQUIRE(buffer.Read() == 4);
+
+    // Front value is not touched by producer
+    buffer.GetBack() = 5;
+    REQUIRE(buffer.GetFront() == 4);
+    buffer.Publish();
+    REQUIRE(buffer.Read() == 5);
+}
+
+TEST_CASE("TripleBuffer hands over consistent values between threads")
+{
+    struct Value
+    {
+        unsigned a_{};
+        unsigned b_{};
+    };
+
+    static constexpr unsigned numValues = 100000;
+    TripleBuffer<Value> buffer;
+
+    std::thread producer([&]
+    {
+        for (unsigned i = 1; i <= numValues; ++i)
+        {
+            Value& value = buffer.GetBack();
+            value.a_ = i;
+            value.b_ = i * 2;
+            buffer.Publish();
+        }
+    });
+
+    unsigned lastValue = 0;
+    bool consistent = true;
+    bool monotonic = true;
+    while (lastValue != numValues)
+    {
+        const Value& value = buffer.Read();
+        consistent &= value.b_ == value.a_ * 2;
+        monotonic &= value.a_ >= lastValue;
+        lastValue = value.a_;
+    }
+
+    producer.join();
+    REQUIRE(consistent);
+    REQUIRE(monotonic);
+}
@@ -0,0 +1,221 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#if URHO3D_STEAM_AUDIO
+
+#include "../AudioUtils.h"
+#include "../CommonUtils.h"
+
+#include <Urho3D/Audio/Sound.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Math/RandomEngine.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/SteamAudio/SteamAudio.h>
+#include <Urho3D/SteamAudio/SteamSoundListener.h>
+#include <Urho3D/SteamAudio/SteamSoundSource.h>
+
+namespace
+{
+
+/// Effects enabled on benchmarked sound sources.
+struct EffectSet
+{
+    const char* name_;
+    bool distanceAttenuation_;
+    bool airAbsorption_;
+    bool occlusion_;
+    bool reflection_;
+    ReflectionEffectType reflectionType_;
+};
+
+const EffectSet effectSets[] = {
+    {"binaural", false, false, false, false},
+    {"direct", true, true, false, false},
+    {"occlusion", true, true, true, false},
+    {"reflection", false, false, false, true},
+};
+
+const EffectSet reverbSets[] = {
+    {"convolution reverb", false, false, false, true, RET_CONVOLUTION},
+    {"parametric reverb", false, false, false, true, RET_PARAMETRIC},
+    {"hybrid reverb", false, false, false, true, RET_HYBRID},
+};
+
+/// Synthetic scene rendered with the null device.
+struct BenchmarkScene
+{
+    BenchmarkScene(Context* context, unsigned numSources, const EffectSet& effects, unsigned numTriangles)
+        : audio_(context->GetSubsystem<SteamAudio>())
+        , scene_(MakeShared<Scene>(context))
+    {
+        // Every source is measured rendering in full
+        maxRealVoices_ = audio_->GetMaxRealVoices();
+        audio_->SetMaxRealVoices(0);
+        audio_->SetOutputDevice(ODT_NULL);
+        audio_->SetReflectionEffectType(effects.reflectionType_);
+        REQUIRE(audio_->SetMode(44100, SPK_STEREO));
+        audio_->SetReflectionSimulationActive(effects.reflection_);
+
+        ea::vector<short> data(44100);
+        for (unsigned i = 0; i < data.size(); ++i)
+            data[i] = static_cast<short>(Sin(i * 4.0f) * 8192.0f);
+        auto sound = MakeShared<Sound>(context);
+        sound->SetFormat(44100, true, false);
+        sound->SetData(data.data(), data.size() * sizeof(short));
+
+        // SteamSoundMesh.h clashes with Graphics/Material.h, go through attributes instead
+        Component* mesh = scene_->CreateChild("Room")->CreateComponent("SteamSoundMesh");
+        REQUIRE(mesh);
+        mesh->SetAttribute("Model", ResourceRef(Model::GetTypeStatic(), Tests::GetRoomModel(context, numTriangles)->GetName()));
+        mesh->SetAttribute("Static", true);
+
+        Node* listenerNode = scene_->CreateChild("Listener");
+        listenerNode->SetPosition({0.0f, 1.5f, 0.0f});
+        listenerNode->CreateComponent<SteamSoundListener>();
+
+        RandomEngine random(0);
+        for (unsigned i = 0; i < numSources; ++i)
+        {
+            Node* sourceNode = scene_->CreateChild("Source");
+            sourceNode->SetPosition({random.GetFloat(-18.0f, 18.0f), 1.5f, random.GetFloat(-18.0f, 18.0f)});
+            auto source = sourceNode->CreateComponent<SteamSoundSource>();
+            source->SetAttribute("Loop", true);
+            source->SetAttribute("Binaural", true);
+            source->SetAttribute("Distance Attenuation", effects.distanceAttenuation_);
+            source->SetAttribute("Air absorption", effects.airAbsorption_);
+            source->SetAttribute("Occlusion", effects.occlusion_);
+            source->SetAttribute("Transmission", effects.occlusion_);
+            source->SetAttribute("Reflection", effects.reflection_);
+            source->Play(sound);
+        }
+
+        // Create effects, the static batch and the first simulation results
+        SetSimulatedEveryBlock(true);
+        REQUIRE(audio_->RenderOffline(4, samples_));
+        buffer_.resize(audio_->GetFrameSize() * audio_->GetChannelCount());
+    }
+
+    ~BenchmarkScene()
+    {
+        scene_ = nullptr;
+        audio_->Close();
+        audio_->SetOutputDevice(ODT_SDL);
+        audio_->SetReflectionEffectType(RET_CONVOLUTION);
+        audio_->SetMaxRealVoices(maxRealVoices_);
+    }
+
+    /// Set whether simulations run in every rendered block or practically never.
+    void SetSimulatedEveryBlock(bool enable)
+    {
+        const float rate = enable ? 1000.0f : 0.001f;
+        audio_->SetSimulationRates(rate, rate);
+    }
+
+    /// Render one block including render update and due simulations.
+    void RenderBlock()
+    {
+        samples_.clear();
+        audio_->RenderOffline(1, samples_);
+    }
+
+    SharedPtr<SteamAudio> audio_;
+    SharedPtr<Scene> scene_;
+    ea::vector<float> samples_;
+    ea::vector<float> buffer_;
+    unsigned maxRealVoices_{};
+};
+
+/// Benchmark one scene. Simulation time is the difference between the first two benchmarks, mixing time is measured alone.
+void RunBenchmarks(BenchmarkScene& scene, const ea::string& name)
+{
+    const unsigned mixAllocations = scene.audio_->GetNumMixAllocations();
+
+    scene.SetSimulatedEveryBlock(true);
+    BENCHMARK(Format("{}: update, simulation and mix per block", name).c_str())
+    {
+        scene.RenderBlock();
+    };
+
+    scene.SetSimulatedEveryBlock(false);
+    scene.RenderBlock();
+    BENCHMARK(Format("{}: update and mix per block", name).c_str())
+    {
+        scene.RenderBlock();
+    };
+
+    BENCHMARK(Format("{}: mix per block", name).c_str())
+    {
+        scene.audio_->MixOutput(scene.buffer_.data());
+    };
+
+    // Steady-state mixing is expected to be allocation-free
+    INFO(name.c_str());
+    CHECK(scene.audio_->GetNumMixAllocations() - mixAllocations == 0);
+}
+
+}
+
+TEST_CASE("SteamAudio source count benchmark", "[.][benchmark]")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+
+    for (const EffectSet& effects : effectSets)
+    {
+        for (unsigned numSources : {1u, 10u, 100u, 1000u})
+        {
+            BenchmarkScene scene(context, numSources, effects, 1000);
+            RunBenchmarks(scene, Format("{} sources, {}", numSources, effects.name_));
+        }
+    }
+}
+
+TEST_CASE("SteamAudio scene size benchmark", "[.][benchmark]")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+
+    for (const EffectSet& effects : {effectSets[2], effectSets[3]})
+    {
+        for (unsigned numTriangles : {1000u, 10000u, 100000u, 1000000u})
+        {
+            BenchmarkScene scene(context, 32, effects, numTriangles);
+            RunBenchmarks(scene, Format("{} triangles, 32 sources, {}", numTriangles, effects.name_));
+        }
+    }
+}
+
+TEST_CASE("SteamAudio reverb mode benchmark", "[.][benchmark]")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+
+    // Per-source cost of each reflection algorithm is the mix time divided by the source count
+    for (const EffectSet& effects : reverbSets)
+    {
+        for (unsigned numSources : {1u, 10u, 100u})
+        {
+            BenchmarkScene scene(context, numSources, effects, 1000);
+            RunBenchmarks(scene, Format("{} sources, {}", numSources, effects.name_));
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,264 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#if URHO3D_STEAM_AUDIO
+
+#include "../AudioUtils.h"
+#include "../CommonUtils.h"
+
+#include <Urho3D/Audio/Sound.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/SteamAudio/SteamAudio.h>
+#include <Urho3D/SteamAudio/SteamAudioEvents.h>
+#include <Urho3D/SteamAudio/SteamSoundListener.h>
+#include <Urho3D/SteamAudio/SteamSoundSource.h>
+
+namespace
+{
+
+/// Render a looping tone next to the listener with the null device.
+ea::vector<float> RenderTone(Context* context, unsigned numBlocks)
+{
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO));
+
+    auto sound = Tests::CreateToneSound(context);
+
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateChild("Listener")->CreateComponent<SteamSoundListener>();
+    Node* sourceNode = scene->CreateChild("Source");
+    sourceNode->SetPosition({2.0f, 0.0f, 1.0f});
+    auto source = sourceNode->CreateComponent<SteamSoundSource>();
+    source->SetAttribute("Loop", true);
+    source->SetAttribute("Binaural", true);
+    source->SetAttribute("Distance Attenuation", true);
+    source->Play(sound);
+
+    ea::vector<float> samples;
+    REQUIRE(audio->RenderOffline(numBlocks, samples));
+    return samples;
+}
+
+}
+
+TEST_CASE("SteamAudio null device renders deterministically")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+
+    const unsigned numBlocks = 16;
+    const ea::vector<float> first = RenderTone(context, numBlocks);
+    const ea::vector<float> second = RenderTone(context, numBlocks);
+
+    REQUIRE(first.size() == numBlocks * audio->GetFrameSize() * 2);
+    CHECK(ea::any_of(first.begin(), first.end(), [](float sample) { return sample != 0.0f; }));
+    CHECK(first == second);
+
+    // Mixing is instrumented in offline rendering as well
+    const SteamAudioStats stats = audio->GetStats();
+    CHECK(stats.numBlocks_ >= 2 * numBlocks);
+    CHECK(stats.numActiveSources_ == 1);
+    CHECK(stats.blockDuration_ == Catch::Approx(1000.0f * audio->GetFrameSize() / 44100));
+
+    // Written WAV loads back as a sound of the same length
+    VectorBuffer wav;
+    REQUIRE(audio->RenderOfflineWav(numBlocks, wav));
+    MemoryBuffer wavSource(wav);
+    auto sound = MakeShared<Sound>(context);
+    REQUIRE(sound->LoadWav(wavSource));
+    CHECK(sound->IsStereo());
+    CHECK(sound->GetSampleSize() == 4);
+    CHECK(sound->GetDataSize() == numBlocks * audio->GetFrameSize() * 4);
+
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+}
+
+TEST_CASE("SteamAudio block size is configurable")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+
+    REQUIRE(audio->SetMode(48000, SPK_STEREO, 128));
+    CHECK(audio->GetFrameSize() == 128);
+    CHECK(audio->GetStats().blockDuration_ == Catch::Approx(1000.0f * 128 / 48000));
+
+    // Only the audio subsystem and its components update per rendered block
+    Serializable subscriber(context);
+    unsigned numRenderUpdates = 0;
+    unsigned numAudioUpdates = 0;
+    subscriber.SubscribeToEvent(E_RENDERUPDATE, [&](VariantMap&) { ++numRenderUpdates; });
+    subscriber.SubscribeToEvent(audio, E_STEAMAUDIOUPDATE, [&](VariantMap& eventData)
+    {
+        CHECK(eventData[SteamAudioUpdate::P_TIMESTEP].GetFloat() == Catch::Approx(128.0f / 48000));
+        ++numAudioUpdates;
+    });
+
+    ea::vector<float> samples;
+    REQUIRE(audio->RenderOffline(4, samples));
+    CHECK(samples.size() == 4 * 128 * 2);
+    CHECK(numRenderUpdates == 0);
+    CHECK(numAudioUpdates == 4);
+    subscriber.UnsubscribeFromAllEvents();
+
+    // Unsupported sizes are rounded up to a power of two
+    REQUIRE(audio->SetMode(48000, SPK_STEREO, 300));
+    CHECK(audio->GetFrameSize() == 512);
+    REQUIRE(audio->RefreshMode());
+    CHECK(audio->GetFrameSize() == 512);
+
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+}
+
+TEST_CASE("SteamAudio lowers effect LOD of distant sources")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO));
+    audio->SetEffectLodDistances(2.0f, 8.0f);
+
+    auto sound = Tests::CreateToneSound(context);
+
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateChild("Listener")->CreateComponent<SteamSoundListener>();
+    ea::vector<SteamSoundSource*> sources;
+    for (float distance : {1.0f, 4.0f, 16.0f})
+    {
+        Node* sourceNode = scene->CreateChild("Source");
+        sourceNode->SetPosition({distance, 0.0f, 0.0f});
+        auto source = sourceNode->CreateComponent<SteamSoundSource>();
+        source->SetAttribute("Loop", true);
+        source->SetAttribute("Binaural", true);
+        source->SetAttribute("Transmission", true);
+        source->Play(sound);
+        sources.push_back(source);
+    }
+
+    ea::vector<float> samples;
+    REQUIRE(audio->RenderOffline(8, samples));
+    CHECK(sources[0]->GetEffectLod() == ELOD_FULL);
+    CHECK(sources[1]->GetEffectLod() == ELOD_REDUCED);
+    CHECK(sources[2]->GetEffectLod() == ELOD_MINIMAL);
+    CHECK(ea::all_of(samples.begin(), samples.end(), [](float sample) { return std::isfinite(sample); }));
+
+    // Moving closer restores full effects
+    sources[2]->GetNode()->SetPosition({0.5f, 0.0f, 0.0f});
+    REQUIRE(audio->RenderOffline(2, samples));
+    CHECK(sources[2]->GetEffectLod() == ELOD_FULL);
+
+    audio->SetEffectLodDistances(0.0f, 0.0f);
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+}
+
+TEST_CASE("SteamAudio switches reflections to parametric reverb at reduced effect LOD")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+    audio->SetReflectionEffectType(RET_HYBRID);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO));
+    audio->SetEffectLodDistances(2.0f, 8.0f);
+
+    auto sound = Tests::CreateToneSound(context);
+
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateChild("Listener")->CreateComponent<SteamSoundListener>();
+    Node* sourceNode = scene->CreateChild("Source");
+    sourceNode->SetPosition({4.0f, 0.0f, 0.0f});
+    auto source = sourceNode->CreateComponent<SteamSoundSource>();
+    source->SetAttribute("Loop", true);
+    source->SetAttribute("Reflection", true);
+    source->SetReflectionType(RET_CONVOLUTION);
+    source->Play(sound);
+
+    // Both algorithms are rendered while the effect LOD changes back and forth
+    ea::vector<float> samples;
+    REQUIRE(audio->RenderOffline(4, samples));
+    CHECK(source->GetEffectLod() == ELOD_REDUCED);
+    for (float distance : {1.0f, 4.0f, 1.0f})
+    {
+        sourceNode->SetPosition({distance, 0.0f, 0.0f});
+        REQUIRE(audio->RenderOffline(2, samples));
+        CHECK(source->GetEffectLod() == (distance < 2.0f ? ELOD_FULL : ELOD_REDUCED));
+        CHECK(ea::all_of(samples.begin(), samples.end(), [](float sample) { return std::isfinite(sample); }));
+    }
+
+    scene = nullptr;
+    audio->SetEffectLodDistances(0.0f, 0.0f);
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+    audio->SetReflectionEffectType(RET_CONVOLUTION);
+}
+
+TEST_CASE("SteamAudio sound sources choose reflection algorithm under hybrid reverb")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+
+    // Other simulators only output what their algorithm needs
+    audio->SetReflectionEffectType(RET_PARAMETRIC);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO));
+    CHECK(audio->ResolveReflectionEffectType(RET_DEFAULT) == IPL_REFLECTIONEFFECTTYPE_PARAMETRIC);
+    CHECK(audio->ResolveReflectionEffectType(RET_CONVOLUTION) == IPL_REFLECTIONEFFECTTYPE_PARAMETRIC);
+
+    audio->SetReflectionEffectType(RET_HYBRID);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO));
+    CHECK(audio->ResolveReflectionEffectType(RET_DEFAULT) == IPL_REFLECTIONEFFECTTYPE_HYBRID);
+    CHECK(audio->ResolveReflectionEffectType(RET_CONVOLUTION) == IPL_REFLECTIONEFFECTTYPE_CONVOLUTION);
+    CHECK(audio->ResolveReflectionEffectType(RET_PARAMETRIC) == IPL_REFLECTIONEFFECTTYPE_PARAMETRIC);
+
+    auto sound = Tests::CreateToneSound(context);
+
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateChild("Listener")->CreateComponent<SteamSoundListener>();
+    for (ReflectionEffectType type : {RET_DEFAULT, RET_CONVOLUTION, RET_PARAMETRIC, RET_HYBRID})
+    {
+        Node* sourceNode = scene->CreateChild("Source");
+        sourceNode->SetPosition({2.0f, 0.0f, 1.0f});
+        auto source = sourceNode->CreateComponent<SteamSoundSource>();
+        source->SetAttribute("Loop", true);
+        source->SetAttribute("Reflection", true);
+        source->SetReflectionType(type);
+        source->SetHybridReverb(0.5f, 0.5f);
+        source->Play(sound);
+    }
+
+    ea::vector<float> samples;
+    REQUIRE(audio->RenderOffline(8, samples));
+    CHECK(ea::all_of(samples.begin(), samples.end(), [](float sample) { return std::isfinite(sample); }));
+
+    scene = nullptr;
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+    audio->SetReflectionEffectType(RET_CONVOLUTION);
+}
+
+#endif
@@ -0,0 +1,209 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#if URHO3D_STEAM_AUDIO
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Math/RandomEngine.h>
+#include <Urho3D/Math/Vector3.h>
+
+#include <phonon.h>
+
+namespace
+{
+
+/// Append an axis-aligned box to a triangle soup.
+void AddBox(ea::vector<IPLVector3>& vertices, ea::vector<IPLTriangle>& triangles, const Vector3& min, const Vector3& max)
+{
+    const int base = vertices.size();
+    for (unsigned i = 0; i < 8; ++i)
+        vertices.push_back({(i & 1) ? max.x_ : min.x_, (i & 2) ? max.y_ : min.y_, (i & 4) ? max.z_ : min.z_});
+
+    static const int faces[12][3] = {
+        {0, 2, 1}, {1, 2, 3}, {4, 5, 6}, {5, 7, 6},
+        {0, 1, 4}, {1, 5, 4}, {2, 6, 3}, {3, 6, 7},
+        {0, 4, 2}, {2, 4, 6}, {1, 3, 5}, {3, 7, 5}
+    };
+    for (const auto& face : faces)
+        triangles.push_back({base + face[0], base + face[1], base + face[2]});
+}
+
+/// Room with pillars and sound sources scattered in it.
+struct BenchmarkScene
+{
+    static constexpr unsigned NumSources = 32;
+
+    BenchmarkScene(IPLContext context, IPLSceneSettings sceneSettings)
+    {
+        // Walls, floor and ceiling of a 40x6x40 room plus a grid of pillars
+        ea::vector<IPLVector3> vertices;
+        ea::vector<IPLTriangle> triangles;
+        AddBox(vertices, triangles, {-20.0f, -1.0f, -20.0f}, {20.0f, 0.0f, 20.0f});
+        AddBox(vertices, triangles, {-20.0f, 6.0f, -20.0f}, {20.0f, 7.0f, 20.0f});
+        AddBox(vertices, triangles, {-21.0f, 0.0f, -20.0f}, {-20.0f, 6.0f, 20.0f});
+        AddBox(vertices, triangles, {20.0f, 0.0f, -20.0f}, {21.0f, 6.0f, 20.0f});
+        AddBox(vertices, triangles, {-20.0f, 0.0f, -21.0f}, {20.0f, 6.0f, -20.0f});
+        AddBox(vertices, triangles, {-20.0f, 0.0f, 20.0f}, {20.0f, 6.0f, 21.0f});
+        for (int x = -3; x <= 3; ++x)
+        {
+            for (int z = -3; z <= 3; ++z)
+            {
+                const Vector3 center{x * 5.0f + 2.5f, 3.0f, z * 5.0f + 2.5f};
+                AddBox(vertices, triangles, center - Vector3{0.5f, 3.0f, 0.5f}, center + Vector3{0.5f, 3.0f, 0.5f});
+            }
+        }
+
+        IPLMaterial material{{0.10f, 0.20f, 0.30f}, 0.05f, {0.100f, 0.050f, 0.030f}};
+        ea::vector<IPLint32> materialIndices(triangles.size(), 0);
+        IPLStaticMeshSettings staticMeshSettings {
+            .numVertices = static_cast<IPLint32>(vertices.size()),
+            .numTriangles = static_cast<IPLint32>(triangles.size()),
+            .numMaterials = 1,
+            .vertices = vertices.data(),
+            .triangles = triangles.data(),
+            .materialIndices = materialIndices.data(),
+            .materials = &material
+        };
+        iplSceneCreate(context, &sceneSettings, &scene_);
+        iplStaticMeshCreate(scene_, &staticMeshSettings, &staticMesh_);
+        iplStaticMeshAdd(staticMesh_, scene_);
+        iplSceneCommit(scene_);
+
+        IPLSimulationSettings simulationSettings {
+            .flags = static_cast<IPLSimulationFlags>(IPL_SIMULATIONFLAGS_DIRECT | IPL_SIMULATIONFLAGS_REFLECTIONS),
+            .sceneType = sceneSettings.type,
+            .reflectionType = IPL_REFLECTIONEFFECTTYPE_CONVOLUTION,
+            .maxNumOcclusionSamples = 16,
+            .maxNumRays = 4096,
+            .numDiffuseSamples = 32,
+            .maxDuration = 1.0f,
+            .maxOrder = 1,
+            .maxNumSources = NumSources,
+            .numThreads = 1,
+            .samplingRate = 48000,
+            .frameSize = 1024
+        };
+        iplSimulatorCreate(context, &simulationSettings, &simulator_);
+        iplSimulatorSetScene(simulator_, scene_);
+
+        // Sources between the pillars, occluded from the listener to varying degrees
+        RandomEngine random(0);
+        for (auto& source : sources_)
+        {
+            IPLSourceSettings sourceSettings {
+                .flags = simulationSettings.flags
+            };
+            iplSourceCreate(simulator_, &sourceSettings, &source);
+            iplSourceAdd(source, simulator_);
+
+            IPLSimulationInputs inputs {
+                .flags = simulationSettings.flags,
+                .directFlags = static_cast<IPLDirectSimulationFlags>(IPL_DIRECTSIMULATIONFLAGS_OCCLUSION | IPL_DIRECTSIMULATIONFLAGS_TRANSMISSION),
+                .source = {
+                    .right = {1.0f, 0.0f, 0.0f},
+                    .up = {0.0f, 1.0f, 0.0f},
+                    .ahead = {0.0f, 0.0f, -1.0f},
+                    .origin = {random.GetFloat(-18.0f, 18.0f), 1.5f, random.GetFloat(-18.0f, 18.0f)}
+                },
+                .occlusionType = IPL_OCCLUSIONTYPE_VOLUMETRIC,
+                .occlusionRadius = 1.0f,
+                .numOcclusionSamples = 16,
+                .reverbScale = {1.0f, 1.0f, 1.0f},
+                .numTransmissionRays = 4
+            };
+            iplSourceSetInputs(source, simulationSettings.flags, &inputs);
+        }
+        iplSimulatorCommit(simulator_);
+
+        IPLSimulationSharedInputs sharedInputs {
+            .listener = {
+                .right = {1.0f, 0.0f, 0.0f},
+                .up = {0.0f, 1.0f, 0.0f},
+                .ahead = {0.0f, 0.0f, -1.0f},
+                .origin = {0.0f, 1.5f, 0.0f}
+            },
+            .numRays = 4096,
+            .numBounces = 16,
+            .duration = 1.0f,
+            .order = 1,
+            .irradianceMinDistance = 1.0f
+        };
+        iplSimulatorSetSharedInputs(simulator_, simulationSettings.flags, &sharedInputs);
+    }
+
+    ~BenchmarkScene()
+    {
+        for (auto& source : sources_)
+        {
+            iplSourceRemove(source, simulator_);
+            iplSourceRelease(&source);
+        }
+        iplSimulatorRelease(&simulator_);
+        iplStaticMeshRelease(&staticMesh_);
+        iplSceneRelease(&scene_);
+    }
+
+    IPLScene scene_{};
+    IPLStaticMesh staticMesh_{};
+    IPLSimulator simulator_{};
+    ea::array<IPLSource, NumSources> sources_{};
+};
+
+}
+
+TEST_CASE("Steam Audio ray tracer benchmark", "[.][benchmark]")
+{
+    IPLContextSettings contextSettings {
+        .version = STEAMAUDIO_VERSION
+    };
+    IPLContext context{};
+    REQUIRE(iplContextCreate(&contextSettings, &context) == IPL_STATUS_SUCCESS);
+
+    // Embree is only available if Steam Audio was built with it
+    ea::vector<ea::pair<ea::string, IPLSceneSettings>> rayTracers;
+    rayTracers.emplace_back("Default", IPLSceneSettings{.type = IPL_SCENETYPE_DEFAULT});
+    IPLEmbreeDeviceSettings embreeDeviceSettings{};
+    IPLEmbreeDevice embreeDevice{};
+    if (iplEmbreeDeviceCreate(context, &embreeDeviceSettings, &embreeDevice) == IPL_STATUS_SUCCESS)
+        rayTracers.emplace_back("Embree", IPLSceneSettings{.type = IPL_SCENETYPE_EMBREE, .embreeDevice = embreeDevice});
+
+    for (const auto& [name, sceneSettings] : rayTracers)
+    {
+        BenchmarkScene scene(context, sceneSettings);
+
+        BENCHMARK(Format("{} occlusion and transmission, {} sources", name, BenchmarkScene::NumSources).c_str())
+        {
+            iplSimulatorRunDirect(scene.simulator_);
+        };
+        BENCHMARK(Format("{} reflections, {} sources", name, BenchmarkScene::NumSources).c_str())
+        {
+            iplSimulatorRunReflections(scene.simulator_);
+        };
+    }
+
+    iplEmbreeDeviceRelease(&embreeDevice);
+    iplContextRelease(&context);
+}
+
+#endif
@@ -0,0 +1,159 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#if URHO3D_STEAM_AUDIO
+
+#include "../AudioUtils.h"
+#include "../CommonUtils.h"
+
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/SteamAudio/SteamAudio.h>
+#include <Urho3D/SteamAudio/SteamSoundListener.h>
+#include <Urho3D/SteamAudio/SteamSoundSource.h>
+
+namespace
+{
+
+/// Render looping tones in a room with the null device. Reflections are rendered by the given algorithm and mixed as the given mode says.
+/// Without walls there is nothing to reflect the tones.
+ea::vector<float> RenderRoom(Context* context, ReflectionMixMode mixMode, bool reflections, ReflectionEffectType type = RET_CONVOLUTION, bool walls = true)
+{
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+    audio->SetReflectionEffectType(type);
+    audio->SetReflectionMixMode(mixMode);
+    audio->SetReflectionSimulationActive(true);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO));
+
+    auto sound = Tests::CreateToneSound(context);
+    auto scene = MakeShared<Scene>(context);
+
+    // SteamSoundMesh.h clashes with Graphics/Material.h, go through attributes instead
+    if (walls)
+    {
+        Component* mesh = scene->CreateChild("Room")->CreateComponent("SteamSoundMesh");
+        REQUIRE(mesh);
+        mesh->SetAttribute("Model", ResourceRef(Model::GetTypeStatic(), Tests::GetRoomModel(context)->GetName()));
+        mesh->SetAttribute("Static", true);
+    }
+
+    Node* listenerNode = scene->CreateChild("Listener");
+    listenerNode->SetPosition({0.0f, 1.5f, 0.0f});
+    listenerNode->CreateComponent<SteamSoundListener>();
+
+    for (const Vector3& position : {Vector3{5.0f, 1.5f, 5.0f}, Vector3{-5.0f, 1.5f, 5.0f}, Vector3{0.0f, 1.5f, -8.0f}})
+    {
+        Node* sourceNode = scene->CreateChild("Source");
+        sourceNode->SetPosition(position);
+        auto source = sourceNode->CreateComponent<SteamSoundSource>();
+        source->SetAttribute("Loop", true);
+        source->SetAttribute("Distance Attenuation", true);
+        source->SetAttribute("Reflection", reflections);
+        source->Play(sound);
+    }
+
+    ea::vector<float> samples;
+    REQUIRE(audio->RenderOffline(32, samples));
+
+    scene = nullptr;
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+    audio->SetReflectionSimulationActive(false);
+    audio->SetReflectionMixMode(RMM_PER_SOURCE);
+    audio->SetReflectionEffectType(RET_CONVOLUTION);
+    return samples;
+}
+
+/// Return energy of the difference between two renders.
+float GetDifferenceEnergy(const ea::vector<float>& lhs, const ea::vector<float>& rhs)
+{
+    REQUIRE(lhs.size() == rhs.size());
+    float energy = 0.0f;
+    for (unsigned i = 0; i < lhs.size(); ++i)
+        energy += (lhs[i] - rhs[i]) * (lhs[i] - rhs[i]);
+    return energy;
+}
+
+}
+
+TEST_CASE("SteamAudio mixes reflections of all sources through a shared bus")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+
+    const ea::vector<float> direct = RenderRoom(context, RMM_SHARED_BUS, false);
+    const ea::vector<float> perSource = RenderRoom(context, RMM_PER_SOURCE, true);
+    const ea::vector<float> shared = RenderRoom(context, RMM_SHARED_BUS, true);
+    CHECK(audio->GetReflectionMixMode() == RMM_PER_SOURCE);
+    REQUIRE(ea::all_of(shared.begin(), shared.end(), [](float sample) { return std::isfinite(sample); }));
+
+    // Decoding once per block carries the same reflections as decoding per source
+    const float perSourceReflections = GetDifferenceEnergy(perSource, direct);
+    const float sharedReflections = GetDifferenceEnergy(shared, direct);
+    REQUIRE(perSourceReflections > 0.0f);
+    CHECK(sharedReflections > perSourceReflections * 0.1f);
+    CHECK(sharedReflections < perSourceReflections * 10.0f);
+
+    // Changing the bus order recreates the bus
+    audio->SetReflectionMixMode(RMM_SHARED_BUS, 3);
+    CHECK(audio->GetReflectionBusOrder() == 3);
+    audio->SetReflectionMixMode(RMM_PER_SOURCE);
+}
+
+TEST_CASE("SteamAudio keeps the dry signal in both reflection mix modes")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+
+    // Without anything to reflect the tones only the dry signal is left, which must not depend on the mix mode
+    const ea::vector<float> perSource = RenderRoom(context, RMM_PER_SOURCE, true, RET_CONVOLUTION, false);
+    const ea::vector<float> shared = RenderRoom(context, RMM_SHARED_BUS, true, RET_CONVOLUTION, false);
+    const float dryEnergy = GetDifferenceEnergy(shared, ea::vector<float>(shared.size(), 0.0f));
+    REQUIRE(dryEnergy > 0.0f);
+    CHECK(GetDifferenceEnergy(perSource, shared) < dryEnergy * 0.01f);
+
+    // In a room both carry the dry signal and similar reflections
+    const ea::vector<float> perSourceRoom = RenderRoom(context, RMM_PER_SOURCE, true);
+    const ea::vector<float> sharedRoom = RenderRoom(context, RMM_SHARED_BUS, true);
+    CHECK(GetDifferenceEnergy(perSourceRoom, sharedRoom) < dryEnergy);
+}
+
+TEST_CASE("SteamAudio mixes parametric and hybrid reverb through a shared bus")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+
+    const ea::vector<float> direct = RenderRoom(context, RMM_SHARED_BUS, false);
+    for (ReflectionEffectType type : {RET_PARAMETRIC, RET_HYBRID})
+    {
+        const ea::vector<float> perSource = RenderRoom(context, RMM_PER_SOURCE, true, type);
+        const ea::vector<float> shared = RenderRoom(context, RMM_SHARED_BUS, true, type);
+        REQUIRE(ea::all_of(shared.begin(), shared.end(), [](float sample) { return std::isfinite(sample); }));
+
+        const float perSourceReflections = GetDifferenceEnergy(perSource, direct);
+        const float sharedReflections = GetDifferenceEnergy(shared, direct);
+        REQUIRE(perSourceReflections > 0.0f);
+        CHECK(sharedReflections > perSourceReflections * 0.1f);
+        CHECK(sharedReflections < perSourceReflections * 10.0f);
+    }
+}
+
+#endif
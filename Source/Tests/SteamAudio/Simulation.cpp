@@ -0,0 +1,150 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#if URHO3D_STEAM_AUDIO
+
+#include "../AudioUtils.h"
+#include "../CommonUtils.h"
+
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/SteamAudio/SteamAudio.h>
+
+TEST_CASE("SteamAudio runs queued simulation tasks in order without a simulation thread")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO));
+
+    ea::vector<int> order;
+    audio->QueueSimulationTask([&]
+    {
+        order.push_back(1);
+        audio->QueueSimulationTask([&] { order.push_back(4); });
+    });
+    audio->QueueSimulationTask([&] { order.push_back(2); });
+    CHECK(order.empty());
+
+    // Waiting runs pending tasks first, tasks queued meanwhile run on the next update
+    audio->RunSimulationTaskAndWait([&] { order.push_back(3); });
+    CHECK(order == ea::vector<int>{1, 2, 3});
+
+    ea::vector<float> samples;
+    REQUIRE(audio->RenderOffline(1, samples));
+    CHECK(order == ea::vector<int>{1, 2, 3, 4});
+
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+}
+
+TEST_CASE("SteamAudio runs simulation tasks on the simulation thread")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetSimulationThreaded(true);
+    audio->SetSimulationRates(30.0f, 5.0f);
+    CHECK(audio->GetDirectSimulationRate() == 30.0f);
+    CHECK(audio->GetReflectionSimulationRate() == 5.0f);
+    audio->SetSimulationRates(60.0f, 10.0f);
+    if (!audio->SetMode(44100, SPK_STEREO))
+    {
+        WARN("No audio device, the simulation thread is not tested");
+        return;
+    }
+
+    bool queuedTaskRan = false;
+    bool ranAfterQueuedTask = false;
+    bool ranOnMainThread = true;
+    audio->QueueSimulationTask([&] { queuedTaskRan = true; });
+    audio->RunSimulationTaskAndWait([&]
+    {
+        ranAfterQueuedTask = queuedTaskRan;
+        ranOnMainThread = Thread::IsMainThread();
+    });
+    CHECK(ranAfterQueuedTask);
+    CHECK_FALSE(ranOnMainThread);
+
+    audio->Close();
+}
+
+TEST_CASE("SteamAudio coalesces and throttles scene commits of moving meshes")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO, 1024));
+
+    // SteamSoundMesh.h clashes with Graphics/Material.h, go through attributes instead
+    auto scene = MakeShared<Scene>(context);
+    Node* meshNode = scene->CreateChild("Door");
+    Component* mesh = meshNode->CreateComponent("SteamSoundMesh");
+    REQUIRE(mesh);
+    mesh->SetAttribute("Model", ResourceRef(Model::GetTypeStatic(), Tests::GetRoomModel(context)->GetName()));
+
+    ea::vector<float> samples;
+    REQUIRE(audio->RenderOffline(2, samples));
+    unsigned numCommits = audio->GetNumSceneCommits();
+
+    // Movements within the tolerance are not committed
+    audio->SetTransformTolerance(0.1f, 5.0f);
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        meshNode->SetPosition({0.02f * i, 0.0f, 0.0f});
+        REQUIRE(audio->RenderOffline(1, samples));
+    }
+    CHECK(audio->GetNumSceneCommits() == numCommits);
+
+    // Every frame commits once at most, however often the mesh moved
+    audio->SetSceneCommitRate(1000.0f);
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        for (unsigned j = 0; j < 5; ++j)
+            meshNode->Translate({1.0f, 0.0f, 0.0f});
+        REQUIRE(audio->RenderOffline(1, samples));
+    }
+    REQUIRE(audio->RenderOffline(1, samples));
+    CHECK(audio->GetNumSceneCommits() == numCommits + 4);
+    CHECK(audio->GetLastSceneCommitTime() >= 0.0f);
+    numCommits = audio->GetNumSceneCommits();
+
+    // Commits of a mesh moving every frame are limited to the commit rate
+    audio->SetSceneCommitRate(10.0f);
+    const unsigned numBlocks = 43;
+    for (unsigned i = 0; i < numBlocks; ++i)
+    {
+        meshNode->Rotate(Quaternion(10.0f, Vector3::UP));
+        REQUIRE(audio->RenderOffline(1, samples));
+    }
+    const unsigned numThrottledCommits = audio->GetNumSceneCommits() - numCommits;
+    CHECK(numThrottledCommits > 0);
+    CHECK(numThrottledCommits <= 11);
+
+    scene = nullptr;
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+    audio->SetSceneCommitRate(20.0f);
+    audio->SetTransformTolerance(0.01f, 0.5f);
+}
+
+#endif
@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#if URHO3D_STEAM_AUDIO
+
+#include "../CommonUtils.h"
+#include "../ModelUtils.h"
+
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/SteamAudio/SteamAudio.h>
+#include <Urho3D/SteamAudio/SteamSoundListener.h>
+
+namespace
+{
+
+/// Return model of two 1x1 quads.
+Model* GetTwoQuadsModel(Context* context)
+{
+    return Tests::GetOrCreateResource<Model>(context, "Tests/SteamAudio/TwoQuads.mdl", [](Context* context)
+    {
+        auto modelView = MakeShared<ModelView>(context);
+        auto& geometries = modelView->GetGeometries();
+        geometries.resize(1);
+        geometries[0].lods_.resize(1);
+        auto& lod = geometries[0].lods_[0];
+        lod.vertexFormat_ = Tests::GetVertexFormat();
+        Tests::AppendQuad(lod, {0.0f, 0.0f, 0.0f}, Quaternion::IDENTITY, {1.0f, 1.0f}, Color::WHITE);
+        Tests::AppendQuad(lod, {0.0f, 1.0f, 0.0f}, Quaternion::IDENTITY, {1.0f, 1.0f}, Color::WHITE);
+        return modelView->ExportModel();
+    });
+}
+
+Node* CreateStaticMesh(Scene* scene, Model* model, const Vector3& position)
+{
+    Node* node = scene->CreateChild("Mesh");
+    node->SetPosition(position);
+    // SteamSoundMesh.h clashes with Graphics/Material.h, go through attributes instead
+    Component* mesh = node->CreateComponent("SteamSoundMesh");
+    REQUIRE(mesh);
+    mesh->SetAttribute("Model", ResourceRef(Model::GetTypeStatic(), model->GetName()));
+    mesh->SetAttribute("Static", true);
+    return node;
+}
+
+}
+
+TEST_CASE("SteamAudio static batch rebuild reuses model geometry")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO));
+
+    Model* model = GetTwoQuadsModel(context);
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateChild("Listener")->CreateComponent<SteamSoundListener>();
+    CreateStaticMesh(scene, model, {-2.0f, 0.0f, 0.0f});
+    Node* movingNode = CreateStaticMesh(scene, model, {2.0f, 0.0f, 0.0f});
+
+    // Both meshes share the geometry extracted from the model
+    ea::vector<float> samples;
+    const unsigned numRebuilds = audio->GetNumStaticBatchRebuilds();
+    REQUIRE(audio->RenderOffline(1, samples));
+    CHECK(audio->GetNumStaticBatchRebuilds() == numRebuilds + 1);
+    CHECK(audio->GetNumStaticSourceTriangles() == 8);
+    CHECK(audio->GetNumCachedStaticGeometries() == 1);
+
+    // Moving a mesh rebuilds the batch from the cached geometry
+    movingNode->SetPosition({4.0f, 0.0f, 0.0f});
+    REQUIRE(audio->RenderOffline(1, samples));
+    CHECK(audio->GetNumStaticBatchRebuilds() == numRebuilds + 2);
+    CHECK(audio->GetNumStaticSourceTriangles() == 8);
+    CHECK(audio->GetNumCachedStaticGeometries() == 1);
+
+    // Geometry is forgotten once no static mesh uses the model
+    scene->RemoveAllChildren();
+    REQUIRE(audio->RenderOffline(1, samples));
+    CHECK(audio->GetNumStaticSourceTriangles() == 0);
+    CHECK(audio->GetNumCachedStaticGeometries() == 0);
+
+    scene = nullptr;
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+}
+
+#endif
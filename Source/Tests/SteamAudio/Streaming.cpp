@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#if URHO3D_STEAM_AUDIO
+
+#include "../CommonUtils.h"
+
+#include <Urho3D/Audio/BufferedSoundStream.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/SteamAudio/SteamAudio.h>
+#include <Urho3D/SteamAudio/SteamSoundListener.h>
+#include <Urho3D/SteamAudio/SteamSoundSource.h>
+
+namespace
+{
+
+/// Append 16-bit mono tone of the given length in sample frames.
+void AddTone(BufferedSoundStream* stream, unsigned numFrames)
+{
+    ea::vector<short> data(numFrames);
+    for (unsigned i = 0; i < data.size(); ++i)
+        data[i] = static_cast<short>(Sin(i * 4.0f) * 16384.0f);
+    stream->AddData(data.data(), data.size() * sizeof(short));
+}
+
+/// 16-bit mono tone of fixed length that stops at its end and can be seeked.
+class ToneSoundStream : public SoundStream
+{
+public:
+    explicit ToneSoundStream(unsigned numFrames) : numFrames_(numFrames)
+    {
+        SetFormat(44100, true, false);
+        SetStopAtEnd(true);
+    }
+
+    bool Seek(unsigned sample_number) override
+    {
+        position_ = Min(sample_number, numFrames_);
+        return true;
+    }
+
+    unsigned GetData(signed char* dest, unsigned numBytes) override
+    {
+        auto data = reinterpret_cast<short*>(dest);
+        const unsigned count = Min(numBytes / sizeof(short), numFrames_ - position_);
+        for (unsigned i = 0; i < count; ++i, ++position_)
+            data[i] = static_cast<short>(Sin(position_ * 4.0f) * 16384.0f);
+        return count * sizeof(short);
+    }
+
+private:
+    unsigned numFrames_{};
+    unsigned position_{};
+};
+
+/// Return energy of rendered blocks in the range [firstBlock, lastBlock).
+float GetBlockEnergy(const ea::vector<float>& samples, unsigned blockSize, unsigned firstBlock, unsigned lastBlock)
+{
+    float energy = 0.0f;
+    for (unsigned i = firstBlock * blockSize; i < lastBlock * blockSize; ++i)
+        energy += samples[i] * samples[i];
+    return energy;
+}
+
+}
+
+TEST_CASE("SteamAudio plays sound streams decoded ahead of playback")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO, 1024));
+    const unsigned blockSize = 1024 * 2;
+
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateChild("Listener")->CreateComponent<SteamSoundListener>();
+    Node* sourceNode = scene->CreateChild("Source");
+    sourceNode->SetPosition({1.0f, 0.0f, 0.0f});
+    auto source = sourceNode->CreateComponent<SteamSoundSource>();
+
+    // Quarter of a second of data, then the stream runs dry
+    auto stream = MakeShared<BufferedSoundStream>();
+    stream->SetFormat(44100, true, false);
+    AddTone(stream, 11025);
+    source->Play(stream);
+    CHECK(source->IsPlaying());
+
+    ea::vector<float> samples;
+    REQUIRE(audio->RenderOffline(24, samples));
+    REQUIRE(ea::all_of(samples.begin(), samples.end(), [](float sample) { return std::isfinite(sample); }));
+    CHECK(GetBlockEnergy(samples, blockSize, 0, 12) > 0.0f);
+    CHECK(GetBlockEnergy(samples, blockSize, 16, 24) == 0.0f);
+
+    // Playback resumes once the stream is fed again
+    AddTone(stream, 11025);
+    samples.clear();
+    REQUIRE(audio->RenderOffline(8, samples));
+    CHECK(GetBlockEnergy(samples, blockSize, 0, 8) > 0.0f);
+
+    // Streams set to stop at their end finish playback
+    stream->SetStopAtEnd(true);
+    samples.clear();
+    REQUIRE(audio->RenderOffline(24, samples));
+    CHECK(GetBlockEnergy(samples, blockSize, 16, 24) == 0.0f);
+    CHECK(stream->GetBufferNumBytes() == 0);
+
+    scene = nullptr;
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+}
+
+TEST_CASE("SteamAudio plays a finished sound stream again from its start")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO, 1024));
+    const unsigned blockSize = 1024 * 2;
+
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateChild("Listener")->CreateComponent<SteamSoundListener>();
+    Node* sourceNode = scene->CreateChild("Source");
+    sourceNode->SetPosition({1.0f, 0.0f, 0.0f});
+    auto source = sourceNode->CreateComponent<SteamSoundSource>();
+
+    auto stream = MakeShared<ToneSoundStream>(11025);
+    source->Play(stream);
+
+    ea::vector<float> samples;
+    REQUIRE(audio->RenderOffline(24, samples));
+    CHECK(GetBlockEnergy(samples, blockSize, 16, 24) == 0.0f);
+    CHECK(source->IsFinished());
+
+    // Same stream is rewound and played again
+    source->Play(stream);
+    samples.clear();
+    REQUIRE(audio->RenderOffline(8, samples));
+    CHECK(GetBlockEnergy(samples, blockSize, 0, 8) > 0.0f);
+    CHECK_FALSE(source->IsFinished());
+
+    scene = nullptr;
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+}
+
+#endif
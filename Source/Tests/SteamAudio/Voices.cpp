@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#if URHO3D_STEAM_AUDIO
+
+#include "../AudioUtils.h"
+#include "../CommonUtils.h"
+
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/SteamAudio/SteamAudio.h>
+#include <Urho3D/SteamAudio/SteamSoundListener.h>
+#include <Urho3D/SteamAudio/SteamSoundSource.h>
+
+namespace
+{
+
+SteamSoundSource* CreateSimulatedSource(Scene* scene, Sound* sound, const Vector3& position)
+{
+    Node* sourceNode = scene->CreateChild("Source");
+    sourceNode->SetPosition(position);
+    auto source = sourceNode->CreateComponent<SteamSoundSource>();
+    source->SetAttribute("Loop", true);
+    source->SetAttribute("Distance Attenuation", true);
+    source->SetAttribute("Reflection", true);
+    source->Play(sound);
+    return source;
+}
+
+}
+
+TEST_CASE("SteamAudio grows the simulator while sources play")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+    audio->SetReflectionSimulationActive(true);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO, 256));
+    const unsigned initialCapacity = audio->GetSimulatorCapacity();
+
+    auto sound = Tests::CreateToneSound(context);
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateChild("Listener")->CreateComponent<SteamSoundListener>();
+    for (unsigned i = 0; i < initialCapacity / 2; ++i)
+        CreateSimulatedSource(scene, sound, {1.0f + i, 0.0f, 1.0f});
+
+    ea::vector<float> samples;
+    REQUIRE(audio->RenderOffline(4, samples));
+    CHECK(audio->GetSimulatorCapacity() == initialCapacity);
+
+    // Sources added to a simulator with published outputs need two grows
+    for (unsigned i = 0; i < initialCapacity * 2; ++i)
+        CreateSimulatedSource(scene, sound, {-1.0f - i, 0.0f, 1.0f});
+
+    samples.clear();
+    REQUIRE(audio->RenderOffline(8, samples));
+    CHECK(audio->GetSimulatorCapacity() == initialCapacity * 4);
+    CHECK(ea::all_of(samples.begin(), samples.end(), [](float sample) { return std::isfinite(sample); }));
+    CHECK(ea::any_of(samples.begin(), samples.end(), [](float sample) { return sample != 0.0f; }));
+
+    scene = nullptr;
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+    audio->SetReflectionSimulationActive(false);
+}
+
+TEST_CASE("SteamAudio virtualizes the least audible sources over the voice limit")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO, 256));
+    audio->SetMaxRealVoices(2);
+
+    auto sound = Tests::CreateToneSound(context);
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateChild("Listener")->CreateComponent<SteamSoundListener>();
+    ea::vector<SteamSoundSource*> sources;
+    for (float distance : {1.0f, 16.0f, 2.0f, 32.0f})
+        sources.push_back(CreateSimulatedSource(scene, sound, {distance, 0.0f, 0.0f}));
+
+    ea::vector<float> samples;
+    REQUIRE(audio->RenderOffline(4, samples));
+    CHECK(audio->GetNumVirtualVoices() == 2);
+    CHECK_FALSE(sources[0]->IsVirtual());
+    CHECK(sources[1]->IsVirtual());
+    CHECK_FALSE(sources[2]->IsVirtual());
+    CHECK(sources[3]->IsVirtual());
+
+    // Higher priority wins over audibility
+    sources[3]->SetAttribute("Priority", 1);
+    REQUIRE(audio->RenderOffline(1, samples));
+    CHECK_FALSE(sources[3]->IsVirtual());
+    CHECK(sources[2]->IsVirtual());
+
+    audio->SetMaxRealVoices(0);
+    REQUIRE(audio->RenderOffline(1, samples));
+    CHECK(audio->GetNumVirtualVoices() == 0);
+
+    scene = nullptr;
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+}
+
+TEST_CASE("SteamAudio gives the voice of a finished sound to another source")
+{
+    auto context = Tests::GetOrCreateContext(Tests::CreateCompleteContext);
+    auto audio = context->GetSubsystem<SteamAudio>();
+    audio->SetOutputDevice(ODT_NULL);
+    REQUIRE(audio->SetMode(44100, SPK_STEREO, 256));
+    audio->SetMaxRealVoices(1);
+
+    // The tone lasts about 17 blocks
+    auto sound = Tests::CreateToneSound(context);
+    auto scene = MakeShared<Scene>(context);
+    scene->CreateChild("Listener")->CreateComponent<SteamSoundListener>();
+    SteamSoundSource* oneShot = CreateSimulatedSource(scene, sound, {1.0f, 0.0f, 0.0f});
+    oneShot->SetAttribute("Loop", false);
+    SteamSoundSource* looping = CreateSimulatedSource(scene, sound, {8.0f, 0.0f, 0.0f});
+
+    ea::vector<float> samples;
+    REQUIRE(audio->RenderOffline(4, samples));
+    CHECK_FALSE(oneShot->IsFinished());
+    CHECK_FALSE(oneShot->IsVirtual());
+    CHECK(looping->IsVirtual());
+
+    REQUIRE(audio->RenderOffline(24, samples));
+    CHECK(oneShot->IsPlaying());
+    CHECK(oneShot->IsFinished());
+    CHECK_FALSE(looping->IsFinished());
+    CHECK_FALSE(looping->IsVirtual());
+    CHECK(audio->GetNumVirtualVoices() == 0);
+
+    // Playing again takes the voice back
+    oneShot->Play(sound);
+    REQUIRE(audio->RenderOffline(2, samples));
+    CHECK_FALSE(oneShot->IsFinished());
+    CHECK_FALSE(oneShot->IsVirtual());
+    CHECK(looping->IsVirtual());
+
+    audio->SetMaxRealVoices(0);
+    scene = nullptr;
+    audio->Close();
+    audio->SetOutputDevice(ODT_SDL);
+}
+
+#endif
@@ -23,7 +23,9 @@
 #include "../Precompiled.h"
 
 #include "../Audio/Audio.h"
+#include "../Audio/AudioMixKernels.h"
 #include "../Audio/Microphone.h"
+#include "../Audio/PrefetchSoundStream.h"
 #include "../Audio/Sound.h"
 #include "../Audio/SoundListener.h"
 #include "../Audio/SoundSource3D.h"
@@ -31,10 +33,15 @@
 #include "../Core/CoreEvents.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/Timer.h"
 #include "../IO/Log.h"
+#include "../Resource/ResourceEvents.h"
 
 #include <SDL.h>
 
+#include <EASTL/sort.h>
+
 #include "../DebugNew.h"
 
 #ifdef _MSC_VER
@@ -88,6 +95,26 @@ static const char* SPEAKER_MODE_NAMES[] = {
     "5.1 Surround",
 };
 
+class Audio::StreamDecoderThread : public Thread
+{
+public:
+    explicit StreamDecoderThread(Audio* audio) : Thread("Audio Stream Decoder"), audio_(audio) {}
+
+    void ThreadFunction() override
+    {
+        URHO3D_PROFILE_THREAD(name_.c_str());
+        while (shouldRun_)
+        {
+            // Buffers hold several fragments, polling keeps the mixing thread free of wake-ups
+            audio_->DecodeStreams();
+            Time::Sleep(5);
+        }
+    }
+
+private:
+    Audio* audio_;
+};
+
 Audio::Audio(Context* context) :
     Object(context)
 {
@@ -113,6 +140,7 @@ Audio::~Audio()
 #endif
 
     Release();
+    streamDecoderThread_.reset();
     context_->ReleaseSDL();
 }
 
@@ -132,7 +160,7 @@ bool Audio::SetMode(int bufferLengthMSec, int mixRate, SpeakerMode speakerMode,
 
     desired.freq = mixRate;
 
-    desired.format = AUDIO_S16;
+    desired.format = AUDIO_F32;
     desired.callback = SDLAudioCallback;
     desired.userdata = this;
 
@@ -142,23 +170,17 @@ bool Audio::SetMode(int bufferLengthMSec, int mixRate, SpeakerMode speakerMode,
     if (Abs((int)desired.samples / 2 - bufferSamples) < Abs((int)desired.samples - bufferSamples))
         desired.samples /= 2;
 
-        // Intentionally disallow format change so that the obtained format will always be the desired format, even though that format
-    // is not matching the device format, however in doing it will enable the SDL's internal audio stream with audio conversion
-
+    // Mix directly to float and 16-bit devices. Other formats get float samples through SDL's internal audio stream with audio conversion
     auto TryOpenAudioDevice = [](const SDL_AudioSpec& desired, SDL_AudioSpec& obtained, bool canChangeChannels) -> unsigned {
-        int allowedChanges = SDL_AUDIO_ALLOW_ANY_CHANGE & ~SDL_AUDIO_ALLOW_FORMAT_CHANGE;
+        int allowedChanges = SDL_AUDIO_ALLOW_ANY_CHANGE;
         if (!canChangeChannels)
             allowedChanges &= ~SDL_AUDIO_ALLOW_CHANNELS_CHANGE;
 
         unsigned deviceID = SDL_OpenAudioDevice(nullptr, SDL_FALSE, &desired, &obtained, allowedChanges);
-        if (!deviceID)
-            return 0;
-
-        if (obtained.format != AUDIO_S16)
+        if (deviceID && obtained.format != AUDIO_F32 && obtained.format != AUDIO_S16)
         {
-            URHO3D_LOGERROR("Could not initialize audio output, 16-bit buffer format not supported");
             SDL_CloseAudioDevice(deviceID);
-            return 0;
+            deviceID = SDL_OpenAudioDevice(nullptr, SDL_FALSE, &desired, &obtained, allowedChanges & ~SDL_AUDIO_ALLOW_FORMAT_CHANGE);
         }
 
         return deviceID;
@@ -208,15 +230,18 @@ bool Audio::SetMode(int bufferLengthMSec, int mixRate, SpeakerMode speakerMode,
         return false;
     }
 
-    sampleSize_ = sizeof(short) * AUDIO_NUM_CHANNELS[speakerMode_];
+    floatOutput_ = obtained.format == AUDIO_F32;
+    sampleSize_ = (floatOutput_ ? sizeof(float) : sizeof(short)) * AUDIO_NUM_CHANNELS[speakerMode_];
     // Guarantee a fragment size that is low enough so that Vorbis decoding buffers do not wrap
     fragmentSize_ = Min(NextPowerOfTwo((unsigned)mixRate >> 6u), (unsigned)obtained.samples);
     mixRate_ = obtained.freq;
     interpolation_ = interpolation;
-    clipBuffer_.reset(new int[fragmentSize_ * AUDIO_NUM_CHANNELS[speakerMode_]]);
+    mixBuffer_.reset(new float[fragmentSize_ * AUDIO_NUM_CHANNELS[speakerMode_]]);
+    sourceBuffer_.reset(new float[fragmentSize_ * 2]);
+    UpdateBuses();
 
     URHO3D_LOGINFO("Set audio mode " + ea::to_string(mixRate_) + " Hz " + SPEAKER_MODE_NAMES[speakerMode_] + " " +
-            (interpolation_ ? "interpolated" : ""));
+            (floatOutput_ ? "float " : "16-bit ") + (interpolation_ ? "interpolated" : ""));
 
     return Play();
 }
@@ -321,6 +346,69 @@ void Audio::StopSound(Sound* sound)
     }
 }
 
+void Audio::SetMaxVoices(unsigned maxVoices)
+{
+    MutexLock lock(audioMutex_);
+    maxVoices_ = maxVoices;
+}
+
+void Audio::SetMaxVoices(const ea::string& type, unsigned maxVoices)
+{
+    MutexLock lock(audioMutex_);
+    const StringHash typeHash(type);
+    auto limitIt = ea::find_if(maxTypeVoices_.begin(), maxTypeVoices_.end(),
+        [&](const ea::pair<StringHash, unsigned>& limit) { return limit.first == typeHash; });
+    if (limitIt != maxTypeVoices_.end())
+    {
+        if (maxVoices)
+            limitIt->second = maxVoices;
+        else
+            maxTypeVoices_.erase(limitIt);
+    }
+    else if (maxVoices)
+        maxTypeVoices_.emplace_back(typeHash, maxVoices);
+
+    // Counts are indexed like the limits so that the mixing thread does not allocate
+    typeVoiceCounts_.resize(maxTypeVoices_.size());
+}
+
+void Audio::SetVoiceFadeTime(float time)
+{
+    voiceFadeTime_ = Max(time, 0.0f);
+}
+
+void Audio::SetStreamPrefetchFragments(unsigned numFragments)
+{
+    streamPrefetchFragments_ = numFragments;
+}
+
+void Audio::SetStreamDecoderPriority(int priority)
+{
+    streamDecoderPriority_ = priority;
+    if (streamDecoderThread_)
+        streamDecoderThread_->SetPriority(priority);
+}
+
+void Audio::SetBusGraph(AudioBusGraph* graph)
+{
+    if (busGraph_)
+        UnsubscribeFromEvent(busGraph_, E_RELOADFINISHED);
+
+    busGraph_ = graph;
+    if (busGraph_)
+        SubscribeToEvent(busGraph_, E_RELOADFINISHED, URHO3D_HANDLER(Audio, HandleBusGraphReloadFinished));
+
+    UpdateBuses();
+}
+
+void Audio::SetBusGain(const ea::string& name, float gain)
+{
+    MutexLock lock(audioMutex_);
+    auto findIt = busIndices_.find(name);
+    if (findIt != busIndices_.end())
+        buses_[findIt->second].desc_.gain_ = Max(gain, 0.0f);
+}
+
 float Audio::GetMasterGain(const ea::string& type) const
 {
     // By definition previously unknown types return full volume
@@ -336,6 +424,28 @@ bool Audio::IsSoundTypePaused(const ea::string& type) const
     return pausedSoundTypes_.contains(type);
 }
 
+float Audio::GetBusGain(const ea::string& name) const
+{
+    MutexLock lock(audioMutex_);
+    auto findIt = busIndices_.find(name);
+    return findIt != busIndices_.end() ? buses_[findIt->second].desc_.gain_ : 1.0f;
+}
+
+float Audio::GetBusLevel(const ea::string& name) const
+{
+    MutexLock lock(audioMutex_);
+    auto findIt = busIndices_.find(name);
+    return findIt != busIndices_.end() ? buses_[findIt->second].peakLevel_ : 0.0f;
+}
+
+unsigned Audio::GetMaxVoices(const ea::string& type) const
+{
+    const StringHash typeHash(type);
+    auto findIt = ea::find_if(maxTypeVoices_.begin(), maxTypeVoices_.end(),
+        [&](const ea::pair<StringHash, unsigned>& limit) { return limit.first == typeHash; });
+    return findIt != maxTypeVoices_.end() ? findIt->second : 0;
+}
+
 SoundListener* Audio::GetListener() const
 {
     return listener_;
@@ -345,6 +455,7 @@ void Audio::AddSoundSource(SoundSource* soundSource)
 {
     MutexLock lock(audioMutex_);
     soundSources_.push_back(soundSource);
+    voices_.reserve(soundSources_.size());
 }
 
 void Audio::RemoveSoundSource(SoundSource* soundSource)
@@ -383,25 +494,31 @@ void SDLAudioCallback(void* userdata, Uint8* stream, int len)
 
 void Audio::MixOutput(void* dest, unsigned samples)
 {
-    if (!playing_ || !clipBuffer_)
+    if (!playing_ || !mixBuffer_)
     {
         memset(dest, 0, samples * (size_t)sampleSize_);
         return;
     }
 
+    UpdateVoices();
+
     while (samples)
     {
-        // If sample count exceeds the fragment (clip buffer) size, split the work
+        // If sample count exceeds the fragment (mix buffer) size, split the work
         unsigned workSamples = Min(samples, fragmentSize_);
-        unsigned clipSamples = workSamples;
-        if (speakerMode_ != SPK_MONO)
-            clipSamples = AUDIO_NUM_CHANNELS[speakerMode_] * fragmentSize_;
+        unsigned mixSamples = AUDIO_NUM_CHANNELS[speakerMode_] * workSamples;
 
-        // Clear clip buffer
-        int* clipPtr = clipBuffer_.get();
-        memset(clipPtr, 0, clipSamples * sizeof(int));
+        // Clear mix buffer, or the bus buffers when mixing through buses
+        float* mixPtr = mixBuffer_.get();
+        if (buses_.empty())
+            memset(mixPtr, 0, mixSamples * sizeof(float));
+        for (AudioBus& bus : buses_)
+        {
+            memset(bus.buffer_.data(), 0, mixSamples * sizeof(float));
+            bus.active_ = false;
+        }
 
-        // Mix samples to clip buffer
+        // Mix samples to mix buffer
         for (auto i = soundSources_.begin(); i != soundSources_.end(); ++i)
         {
             SoundSource* source = *i;
@@ -409,21 +526,296 @@ void Audio::MixOutput(void* dest, unsigned samples)
             // Check for pause if necessary
             if (!pausedSoundTypes_.empty())
             {
-                if (pausedSoundTypes_.contains(source->GetSoundType()))
+                if (pausedSoundTypes_.contains(source->GetSoundTypeHash()))
                     continue;
             }
 
-            source->Mix(clipPtr, workSamples, mixRate_, speakerMode_, interpolation_);
+            float* sourceDest = mixPtr;
+            if (!buses_.empty())
+            {
+                AudioBus& bus = buses_[GetBusIndex(source->GetSoundTypeHash())];
+                bus.active_ = true;
+                sourceDest = bus.buffer_.data();
+            }
+            source->Mix(sourceDest, sourceBuffer_.get(), workSamples, mixRate_, speakerMode_, interpolation_);
+        }
+
+        // Run bus effects once per bus, children first. The master bus ends up holding the output
+        if (!buses_.empty())
+        {
+            for (AudioBus& bus : buses_)
+                ProcessBus(bus, workSamples);
+            mixPtr = buses_.back().buffer_.data();
         }
-        // Copy output from clip buffer to destination
-        auto* destPtr = (short*)dest;
-        while (clipSamples--)
-            *destPtr++ = (short)Clamp(*clipPtr++, -32768, 32767);
+        // Clip and convert output from mix buffer to destination
+        if (floatOutput_)
+            ClampSamples((float*)dest, mixPtr, mixSamples);
+        else
+            ConvertSamples((short*)dest, mixPtr, mixSamples);
         samples -= workSamples;
         ((unsigned char*&)dest) += sampleSize_ * workSamples;
     }
 }
 
+void Audio::UpdateVoices()
+{
+    voices_.clear();
+    for (SoundSource* source : soundSources_)
+    {
+        if (!source->IsPlaying() || (!pausedSoundTypes_.empty() && pausedSoundTypes_.contains(source->GetSoundTypeHash())))
+            continue;
+
+        if (!maxVoices_ && maxTypeVoices_.empty())
+            source->SetVirtual(false);
+        else
+            voices_.push_back({source, source->GetPriority(), source->GetAudibility(), source->IsVirtual()});
+    }
+
+    numVirtualVoices_ = 0;
+    if (voices_.empty())
+        return;
+
+    // Keep the most important sources audible. Audible sources win ties so that equal sources do not swap back and forth
+    ea::sort(voices_.begin(), voices_.end(), [](const Voice& lhs, const Voice& rhs)
+    {
+        if (lhs.priority_ != rhs.priority_)
+            return lhs.priority_ > rhs.priority_;
+        if (lhs.audibility_ != rhs.audibility_)
+            return lhs.audibility_ > rhs.audibility_;
+        return !lhs.virtual_ && rhs.virtual_;
+    });
+
+    ea::fill(typeVoiceCounts_.begin(), typeVoiceCounts_.end(), 0u);
+    unsigned numVoices = 0;
+    for (const Voice& voice : voices_)
+    {
+        SoundSource* source = voice.source_;
+        bool audible = voice.audibility_ > 0.0f && (!maxVoices_ || numVoices < maxVoices_);
+        unsigned* typeVoiceCount = nullptr;
+        if (audible && !maxTypeVoices_.empty())
+        {
+            const StringHash typeHash = source->GetSoundTypeHash();
+            for (unsigned i = 0; i < maxTypeVoices_.size(); ++i)
+            {
+                if (maxTypeVoices_[i].first == typeHash)
+                {
+                    typeVoiceCount = &typeVoiceCounts_[i];
+                    audible = *typeVoiceCount < maxTypeVoices_[i].second;
+                    break;
+                }
+            }
+        }
+
+        if (audible)
+        {
+            ++numVoices;
+            if (typeVoiceCount)
+                ++*typeVoiceCount;
+        }
+        else
+            ++numVirtualVoices_;
+
+        source->SetVirtual(!audible);
+    }
+}
+
+SharedPtr<SoundStream> Audio::CreatePrefetchStream(SoundStream* stream)
+{
+    if (!stream || !streamPrefetchFragments_)
+        return SharedPtr<SoundStream>(stream);
+
+    if (!streamDecoderThread_)
+    {
+        streamDecoderThread_ = ea::make_unique<StreamDecoderThread>(this);
+        if (!streamDecoderThread_->Run())
+        {
+            URHO3D_LOGWARNING("Could not start stream decoder thread, decoding in the mixing thread");
+            streamPrefetchFragments_ = 0;
+            streamDecoderThread_.reset();
+            return SharedPtr<SoundStream>(stream);
+        }
+        if (streamDecoderPriority_)
+            streamDecoderThread_->SetPriority(streamDecoderPriority_);
+    }
+
+    // Hold whole mix fragments at the stream's rate, and no less than SoundSource requests at once
+    const unsigned frequency = stream->GetIntFrequency();
+    const unsigned fragmentFrames = mixRate_ ? fragmentSize_ * frequency / mixRate_ : 0;
+    const unsigned minFrames = frequency * STREAM_BUFFER_LENGTH / 1000;
+    const unsigned capacity = Max(streamPrefetchFragments_ * fragmentFrames, minFrames) * stream->GetSampleSize();
+
+    auto prefetchStream = MakeShared<PrefetchSoundStream>(stream, capacity);
+    MutexLock lock(prefetchStreamsMutex_);
+    prefetchStreams_.push_back(prefetchStream);
+    return prefetchStream;
+}
+
+void Audio::DecodeStreams()
+{
+    URHO3D_PROFILE("DecodeSoundStreams");
+
+    MutexLock lock(prefetchStreamsMutex_);
+    for (unsigned i = 0; i < prefetchStreams_.size();)
+    {
+        // Streams only referenced from here are no longer played
+        if (prefetchStreams_[i]->Refs() == 1)
+        {
+            prefetchStreams_.erase_at(i);
+            continue;
+        }
+
+        prefetchStreams_[i]->Decode();
+        ++i;
+    }
+}
+
+void Audio::UpdateBuses()
+{
+    MutexLock lock(audioMutex_);
+    buses_.clear();
+    busIndices_.clear();
+    if (!busGraph_)
+        return;
+
+    const ea::vector<AudioBusDesc>& descs = busGraph_->GetBuses();
+    auto findDesc = [&](const ea::string& name) -> const AudioBusDesc*
+    {
+        const AudioBusDesc* desc = busGraph_->GetBus(name);
+        return desc && desc->name_ != SOUND_MASTER ? desc : nullptr;
+    };
+
+    // Sort buses by their distance from the master bus, so that children are processed before their parents
+    ea::vector<ea::pair<unsigned, const AudioBusDesc*>> orderedDescs;
+    for (const AudioBusDesc& desc : descs)
+    {
+        if (desc.name_ == SOUND_MASTER || desc.name_.empty())
+            continue;
+
+        unsigned depth = 1;
+        for (const AudioBusDesc* parent = findDesc(desc.parent_); parent; parent = findDesc(parent->parent_))
+        {
+            if (++depth > descs.size())
+            {
+                URHO3D_LOGWARNING("Audio bus {} is part of a cycle, mixing it into the master bus", desc.name_);
+                depth = 1;
+                break;
+            }
+        }
+        orderedDescs.emplace_back(depth, &desc);
+    }
+    ea::stable_sort(orderedDescs.begin(), orderedDescs.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+    for (const auto& [depth, desc] : orderedDescs)
+    {
+        busIndices_[desc->name_] = buses_.size();
+        buses_.emplace_back().desc_ = *desc;
+    }
+
+    const AudioBusDesc* masterDesc = busGraph_->GetBus(SOUND_MASTER);
+    const unsigned masterIndex = buses_.size();
+    busIndices_[SOUND_MASTER] = masterIndex;
+    AudioBus& master = buses_.emplace_back();
+    if (masterDesc)
+        master.desc_ = *masterDesc;
+    master.desc_.name_ = SOUND_MASTER;
+    master.desc_.parent_.clear();
+
+    // Resolve links. Buses in a cycle or with unknown parents mix into the master bus
+    const unsigned numSamples = fragmentSize_ * AUDIO_NUM_CHANNELS[speakerMode_];
+    for (AudioBus& bus : buses_)
+    {
+        if (&bus != &master)
+        {
+            const auto parentIt = busIndices_.find(bus.desc_.parent_);
+            const unsigned index = static_cast<unsigned>(&bus - buses_.data());
+            bus.parent_ = parentIt != busIndices_.end() && parentIt->second > index ? parentIt->second : masterIndex;
+        }
+
+        if (!bus.desc_.duckingSidechain_.empty())
+        {
+            const auto sidechainIt = busIndices_.find(bus.desc_.duckingSidechain_);
+            if (sidechainIt != busIndices_.end())
+                bus.sidechain_ = sidechainIt->second;
+            else
+                URHO3D_LOGWARNING("Audio bus {} is ducked by unknown bus {}", bus.desc_.name_, bus.desc_.duckingSidechain_);
+        }
+
+        bus.buffer_.resize(numSamples);
+    }
+}
+
+void Audio::HandleBusGraphReloadFinished(StringHash eventType, VariantMap& eventData)
+{
+    UpdateBuses();
+}
+
+unsigned Audio::GetBusIndex(StringHash soundType) const
+{
+    auto findIt = busIndices_.find(soundType);
+    return findIt != busIndices_.end() ? findIt->second : buses_.size() - 1;
+}
+
+void Audio::ProcessBus(AudioBus& bus, unsigned numFrames)
+{
+    const AudioBusDesc& desc = bus.desc_;
+    const unsigned numChannels = AUDIO_NUM_CHANNELS[speakerMode_];
+    const float blockTime = static_cast<float>(numFrames) / mixRate_;
+    const auto smoothing = [&](float time) { return time > 0.0f ? 1.0f - expf(-blockTime / time) : 1.0f; };
+    float* buffer = bus.buffer_.data();
+
+    // Ducking follows the sidechain level of this fragment if the sidechain was processed first, otherwise of the last one
+    float duckingTarget = 1.0f;
+    if (bus.sidechain_ != M_MAX_UNSIGNED && buses_[bus.sidechain_].peakLevel_ > desc.duckingThreshold_)
+        duckingTarget = desc.duckingGain_;
+    const float duckingTime = duckingTarget < bus.duckingGain_ ? desc.duckingAttack_ : desc.duckingRelease_;
+    bus.duckingGain_ += (duckingTarget - bus.duckingGain_) * smoothing(duckingTime);
+
+    float peakLevel = 0.0f;
+    if (bus.active_)
+    {
+        if (desc.lowPassFrequency_ > 0.0f)
+        {
+            const float cutoff = Min(desc.lowPassFrequency_, mixRate_ * 0.5f);
+            LowPassFrames(buffer, numFrames, numChannels, 1.0f - expf(-2.0f * M_PI * cutoff / mixRate_), bus.lowPassState_);
+        }
+        peakLevel = GetPeakLevel(buffer, numFrames * numChannels);
+    }
+    else
+        ea::fill(ea::begin(bus.lowPassState_), ea::end(bus.lowPassState_), 0.0f);
+
+    // The limiter reduces gain at once and recovers slowly
+    float fromGain = bus.outputGain_;
+    float gain = desc.gain_ * bus.duckingGain_;
+    if (desc.limiterThreshold_ > 0.0f)
+    {
+        const float level = peakLevel * gain;
+        const float limiterTarget = level > desc.limiterThreshold_ ? desc.limiterThreshold_ / level : 1.0f;
+        if (limiterTarget < bus.limiterGain_)
+        {
+            bus.limiterGain_ = limiterTarget;
+            fromGain = Min(fromGain, gain * limiterTarget);
+        }
+        else
+            bus.limiterGain_ += (limiterTarget - bus.limiterGain_) * smoothing(desc.limiterRelease_);
+        gain *= bus.limiterGain_;
+    }
+
+    bus.peakLevel_ = peakLevel * Max(fromGain, gain);
+    bus.outputGain_ = gain;
+    if (!bus.active_)
+        return;
+
+    if (bus.parent_ == M_MAX_UNSIGNED)
+        ApplyGainRamp(buffer, numFrames, numChannels, fromGain, gain);
+    else
+    {
+        AudioBus& parent = buses_[bus.parent_];
+        MixGainRamp(parent.buffer_.data(), buffer, numFrames, numChannels, fromGain, gain);
+        parent.active_ = true;
+    }
+}
+
 void Audio::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
 {
     using namespace RenderUpdate;
@@ -443,7 +835,8 @@ void Audio::Release()
     {
         SDL_CloseAudioDevice(deviceID_);
         deviceID_ = 0;
-        clipBuffer_.reset();
+        mixBuffer_.reset();
+        sourceBuffer_.reset();
     }
 }
 
@@ -591,6 +984,7 @@ void Audio::CloseMicrophoneForLoss(unsigned which)
 
 void RegisterAudioLibrary(Context* context)
 {
+    AudioBusGraph::RegisterObject(context);
     Sound::RegisterObject(context);
     SoundSource::RegisterObject(context);
     SoundSource3D::RegisterObject(context);
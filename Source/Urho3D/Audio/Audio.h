@@ -25,6 +25,7 @@
 #include <EASTL/unique_ptr.h>
 #include <EASTL/hash_set.h>
 
+#include "../Audio/AudioBusGraph.h"
 #include "../Audio/AudioDefs.h"
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
@@ -34,9 +35,11 @@ namespace Urho3D
 
 class AudioImpl;
 class Microphone;
+class PrefetchSoundStream;
 class Sound;
 class SoundListener;
 class SoundSource;
+class SoundStream;
 
 /// %Audio subsystem.
 class URHO3D_API Audio : public Object
@@ -75,11 +78,33 @@ public:
     void SetListener(SoundListener* listener);
     /// Stop any sound source playing a certain sound clip.
     void StopSound(Sound* sound);
+    /// Set maximum number of sound sources mixed at once. Sources over the limit with the lowest priority and audibility become virtual and are not mixed. 0 is unlimited.
+    /// @property
+    void SetMaxVoices(unsigned maxVoices);
+    /// Set maximum number of sound sources of a specific sound type mixed at once. 0 is unlimited.
+    void SetMaxVoices(const ea::string& type, unsigned maxVoices);
+    /// Set time in seconds to fade sound sources out when they become virtual and in when they become audible again.
+    /// @property
+    void SetVoiceFadeTime(float time);
+    /// Set number of mix fragments compressed sounds are decoded ahead of playback by the stream decoder thread. 0 decodes them in the mixing thread.
+    /// @property
+    void SetStreamPrefetchFragments(unsigned numFragments);
+    /// Set operating system priority of the stream decoder thread.
+    /// @property
+    void SetStreamDecoderPriority(int priority);
+    /// Set submix bus graph. Sound types mix into the bus with the same name and bus effects run once per bus. Null mixes all sound sources directly to the output.
+    /// @property
+    void SetBusGraph(AudioBusGraph* graph);
+    /// Set gain of a submix bus until the bus graph is set or reloaded again.
+    void SetBusGain(const ea::string& name, float gain);
 
     /// Return byte size of one sample.
     /// @property
     unsigned GetSampleSize() const { return sampleSize_; }
 
+    /// Return whether the device takes float samples instead of 16-bit samples.
+    bool IsFloatOutput() const { return floatOutput_; }
+
     /// Return mixing rate.
     /// @property
     int GetMixRate() const { return mixRate_; }
@@ -111,6 +136,39 @@ public:
     /// Return whether specific sound type has been paused.
     bool IsSoundTypePaused(const ea::string& type) const;
 
+    /// Return maximum number of sound sources mixed at once.
+    /// @property
+    unsigned GetMaxVoices() const { return maxVoices_; }
+
+    /// Return maximum number of sound sources of a specific sound type mixed at once.
+    unsigned GetMaxVoices(const ea::string& type) const;
+
+    /// Return voice fade time in seconds.
+    /// @property
+    float GetVoiceFadeTime() const { return voiceFadeTime_; }
+
+    /// Return number of playing sound sources that were virtual in the last mix.
+    /// @property
+    unsigned GetNumVirtualVoices() const { return numVirtualVoices_; }
+
+    /// Return number of mix fragments compressed sounds are decoded ahead of playback.
+    /// @property
+    unsigned GetStreamPrefetchFragments() const { return streamPrefetchFragments_; }
+
+    /// Return operating system priority of the stream decoder thread.
+    /// @property
+    int GetStreamDecoderPriority() const { return streamDecoderPriority_; }
+
+    /// Return submix bus graph.
+    /// @property
+    AudioBusGraph* GetBusGraph() const { return busGraph_; }
+
+    /// Return gain of a submix bus, 1 if not found.
+    float GetBusGain(const ea::string& name) const;
+
+    /// Return peak output level of a submix bus in the last mix, 0 if not found.
+    float GetBusLevel(const ea::string& name) const;
+
     /// Return active sound listener.
     /// @property
     SoundListener* GetListener() const;
@@ -134,6 +192,12 @@ public:
 
     /// Mix sound sources into the buffer.
     void MixOutput(void* dest, unsigned samples);
+    /// Rank playing sound sources by priority and audibility and make those over the voice limits virtual. Called by MixOutput.
+    void UpdateVoices();
+    /// Return a stream playing the given stream decoded ahead by the stream decoder thread, or the stream itself if prefetching is disabled. Usable by any consumer of sound streams.
+    SharedPtr<SoundStream> CreatePrefetchStream(SoundStream* stream);
+    /// Decode prefetched streams and drop the ones no longer played. Called from the stream decoder thread.
+    void DecodeStreams();
 
     /// Returns a pretty-name list of all attached microphones.
     StringVector EnumerateMicrophones() const;
@@ -143,24 +207,51 @@ public:
     void CloseMicrophoneForLoss(unsigned which);
 
 private:
+    class StreamDecoderThread;
+
+    /// Playing sound source considered by voice management.
+    struct Voice
+    {
+        /// Sound source.
+        SoundSource* source_{};
+        /// Priority, higher is kept audible first.
+        int priority_{};
+        /// Estimated loudness, evaluated once per update.
+        float audibility_{};
+        /// Whether the source was virtual before the update.
+        bool virtual_{};
+    };
+
     /// Handle render update event.
     void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
     /// Stop sound output and release the sound buffer.
     void Release();
     /// Actually update sound sources with the specific timestep. Called internally.
     void UpdateInternal(float timeStep);
+    /// Rebuild submix buses from the bus graph and size their buffers for the current mode.
+    void UpdateBuses();
+    /// Handle bus graph reload.
+    void HandleBusGraphReloadFinished(StringHash eventType, VariantMap& eventData);
+    /// Return index of the submix bus a sound type mixes into.
+    unsigned GetBusIndex(StringHash soundType) const;
+    /// Apply effects of a submix bus and mix it into its parent. The master bus is processed in place.
+    void ProcessBus(AudioBus& bus, unsigned numFrames);
 
-    /// Clipping buffer for mixing.
-    ea::unique_ptr<int[]> clipBuffer_;
-    /// Audio thread mutex.
-    Mutex audioMutex_;
+    /// Float buffer sound sources are mixed into. Clipped once when converted to the output format.
+    ea::unique_ptr<float[]> mixBuffer_;
+    /// Scratch buffer for resampled frames of one sound source.
+    ea::unique_ptr<float[]> sourceBuffer_;
+    /// Audio thread mutex. Also locked by const accessors of state written by the audio thread.
+    mutable Mutex audioMutex_;
     /// SDL audio device ID.
     unsigned deviceID_{};
     /// Sample size.
     unsigned sampleSize_{};
-    /// Clip buffer size in samples.
+    /// Whether the device takes float samples.
+    bool floatOutput_{};
+    /// Mix buffer size in samples.
     unsigned fragmentSize_{};
-    /// Clip buffer size in milliseconds.
+    /// Mix buffer size in milliseconds.
     unsigned bufferLengthMSec_{};
     /// Mixing rate.
     int mixRate_{};
@@ -176,6 +267,34 @@ private:
     ea::hash_set<StringHash> pausedSoundTypes_;
     /// Sound sources.
     ea::vector<SoundSource*> soundSources_;
+    /// Maximum number of mixed sound sources, 0 is unlimited.
+    unsigned maxVoices_{};
+    /// Maximum number of mixed sound sources by sound type.
+    ea::vector<ea::pair<StringHash, unsigned>> maxTypeVoices_;
+    /// Voice fade time in seconds.
+    float voiceFadeTime_{0.05f};
+    /// Playing sound sources sorted by priority and audibility. Reserved for all sound sources and reused between mixes.
+    ea::vector<Voice> voices_;
+    /// Number of audible sound sources for each entry of maxTypeVoices_. Reused between mixes.
+    ea::vector<unsigned> typeVoiceCounts_;
+    /// Number of virtual sound sources in the last mix.
+    unsigned numVirtualVoices_{};
+    /// Number of mix fragments to decode ahead, 0 if disabled.
+    unsigned streamPrefetchFragments_{4};
+    /// Stream decoder thread priority.
+    int streamDecoderPriority_{};
+    /// Stream decoder thread. Started with the first prefetched stream.
+    ea::unique_ptr<StreamDecoderThread> streamDecoderThread_;
+    /// Prefetched stream list mutex. Held by the stream decoder thread while decoding.
+    Mutex prefetchStreamsMutex_;
+    /// Streams kept decoded ahead of playback.
+    ea::vector<SharedPtr<PrefetchSoundStream>> prefetchStreams_;
+    /// Submix bus graph.
+    SharedPtr<AudioBusGraph> busGraph_;
+    /// Submix buses with children before their parents. The master bus is last.
+    ea::vector<AudioBus> buses_;
+    /// Submix bus indices by name.
+    ea::unordered_map<StringHash, unsigned> busIndices_;
     /// Sound listener.
     WeakPtr<SoundListener> listener_;
     /// List of microphones being tracked.
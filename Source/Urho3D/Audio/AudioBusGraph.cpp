@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Audio/AudioBusGraph.h"
+#include "../Core/Context.h"
+#include "../IO/ArchiveSerialization.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+void AudioBusDesc::SerializeInBlock(Archive& archive)
+{
+    const AudioBusDesc defaults;
+    SerializeValue(archive, "name", name_);
+    SerializeOptionalValue(archive, "parent", parent_, defaults.parent_);
+    SerializeOptionalValue(archive, "gain", gain_, defaults.gain_);
+    SerializeOptionalValue(archive, "lowPassFrequency", lowPassFrequency_, defaults.lowPassFrequency_);
+    SerializeOptionalValue(archive, "duckingSidechain", duckingSidechain_, defaults.duckingSidechain_);
+    SerializeOptionalValue(archive, "duckingThreshold", duckingThreshold_, defaults.duckingThreshold_);
+    SerializeOptionalValue(archive, "duckingGain", duckingGain_, defaults.duckingGain_);
+    SerializeOptionalValue(archive, "duckingAttack", duckingAttack_, defaults.duckingAttack_);
+    SerializeOptionalValue(archive, "duckingRelease", duckingRelease_, defaults.duckingRelease_);
+    SerializeOptionalValue(archive, "limiterThreshold", limiterThreshold_, defaults.limiterThreshold_);
+    SerializeOptionalValue(archive, "limiterRelease", limiterRelease_, defaults.limiterRelease_);
+}
+
+AudioBusGraph::AudioBusGraph(Context* context) :
+    BaseClassName(context)
+{
+}
+
+AudioBusGraph::~AudioBusGraph() = default;
+
+void AudioBusGraph::RegisterObject(Context* context)
+{
+    context->AddFactoryReflection<AudioBusGraph>();
+}
+
+void AudioBusGraph::SerializeInBlock(Archive& archive)
+{
+    SerializeVectorAsObjects(archive, "buses", buses_, "bus");
+}
+
+void AudioBusGraph::AddBus(const AudioBusDesc& bus)
+{
+    for (AudioBusDesc& existing : buses_)
+    {
+        if (existing.name_ == bus.name_)
+        {
+            existing = bus;
+            return;
+        }
+    }
+    buses_.push_back(bus);
+}
+
+void AudioBusGraph::RemoveBus(const ea::string& name)
+{
+    ea::erase_if(buses_, [&](const AudioBusDesc& bus) { return bus.name_ == name; });
+}
+
+const AudioBusDesc* AudioBusGraph::GetBus(const ea::string& name) const
+{
+    for (const AudioBusDesc& bus : buses_)
+    {
+        if (bus.name_ == name)
+            return &bus;
+    }
+    return nullptr;
+}
+
+}
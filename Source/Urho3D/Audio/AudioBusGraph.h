@@ -0,0 +1,124 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Audio/AudioMixKernels.h"
+#include "../Resource/Resource.h"
+
+#include <EASTL/vector.h>
+
+namespace Urho3D
+{
+
+/// Description of a submix bus.
+struct URHO3D_API AudioBusDesc
+{
+    /// Bus name. Sound sources of the sound type with the same name mix into the bus. The bus named by SOUND_MASTER configures the master bus.
+    ea::string name_;
+    /// Name of the bus this bus mixes into. Empty for the master bus.
+    ea::string parent_;
+    /// Gain.
+    float gain_{1.0f};
+    /// Low-pass cutoff frequency in Hz, 0 if disabled.
+    float lowPassFrequency_{};
+    /// Name of the bus whose level ducks this bus, empty if disabled.
+    ea::string duckingSidechain_;
+    /// Sidechain peak level above which this bus is ducked.
+    float duckingThreshold_{0.1f};
+    /// Gain while ducked.
+    float duckingGain_{0.5f};
+    /// Time in seconds to duck.
+    float duckingAttack_{0.05f};
+    /// Time in seconds to recover from ducking.
+    float duckingRelease_{0.5f};
+    /// Peak level the limiter keeps the bus output under, 0 if disabled.
+    float limiterThreshold_{};
+    /// Time in seconds for the limiter to recover.
+    float limiterRelease_{0.2f};
+
+    /// Serialize content from/to archive. May throw ArchiveException.
+    void SerializeInBlock(Archive& archive);
+};
+
+/// Submix bus graph resource. Sound types mix into buses, buses mix into their parents and finally the master bus.
+class URHO3D_API AudioBusGraph : public SimpleResource
+{
+    URHO3D_OBJECT(AudioBusGraph, SimpleResource);
+
+public:
+    /// Construct.
+    explicit AudioBusGraph(Context* context);
+    /// Destruct.
+    ~AudioBusGraph() override;
+    /// Register object factory.
+    /// @nobind
+    static void RegisterObject(Context* context);
+
+    /// Serialize content from/to archive. May throw ArchiveException.
+    void SerializeInBlock(Archive& archive) override;
+
+    /// Add bus, replacing the bus with the same name.
+    void AddBus(const AudioBusDesc& bus);
+    /// Remove bus by name.
+    void RemoveBus(const ea::string& name);
+
+    /// Return buses.
+    const ea::vector<AudioBusDesc>& GetBuses() const { return buses_; }
+    /// Return bus by name, or null if not found.
+    const AudioBusDesc* GetBus(const ea::string& name) const;
+
+protected:
+    /// Implement SimpleResource.
+    const char* GetRootBlockName() const override { return "audioBusGraph"; }
+
+private:
+    /// Buses.
+    ea::vector<AudioBusDesc> buses_;
+};
+
+/// Mixing state of a submix bus. Owned by Audio and accessed from the mixing thread.
+struct AudioBus
+{
+    /// Description.
+    AudioBusDesc desc_;
+    /// Index of the bus this bus mixes into, M_MAX_UNSIGNED for the master bus.
+    unsigned parent_{M_MAX_UNSIGNED};
+    /// Index of the bus whose level ducks this bus, M_MAX_UNSIGNED if none.
+    unsigned sidechain_{M_MAX_UNSIGNED};
+    /// Interleaved mix of the fragment.
+    ea::vector<float> buffer_;
+    /// Whether anything was mixed into the buffer this fragment.
+    bool active_{};
+    /// Last low-pass output per channel.
+    float lowPassState_[MaxMixChannels]{};
+    /// Current ducking gain.
+    float duckingGain_{1.0f};
+    /// Current limiter gain.
+    float limiterGain_{1.0f};
+    /// Total gain at the end of the last fragment.
+    float outputGain_{1.0f};
+    /// Peak output level of the last processed fragment.
+    float peakLevel_{};
+};
+
+}
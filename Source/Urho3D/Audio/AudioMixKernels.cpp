@@ -0,0 +1,424 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Audio/AudioMixKernels.h"
+#include "../Math/MathDefs.h"
+
+#if defined(URHO3D_SSE)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Scale of 16-bit samples.
+const float shortScale = 1.0f / 32768.0f;
+/// Scale of 8-bit samples.
+const float byteScale = 1.0f / 128.0f;
+
+/// Accumulate mono frames into any number of channels.
+void MixMonoFramesGeneric(float* dest, const float* source, unsigned numFrames, unsigned numChannels, const float* gains)
+{
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        const float sample = source[i];
+        for (unsigned channel = 0; channel < numChannels; ++channel)
+            dest[channel] += sample * gains[channel];
+        dest += numChannels;
+    }
+}
+
+/// Accumulate stereo frames into any number of channels.
+void MixStereoFramesGeneric(float* dest, const float* source, unsigned numFrames, unsigned numChannels, const float* leftGains, const float* rightGains)
+{
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        const float left = source[2 * i];
+        const float right = source[2 * i + 1];
+        for (unsigned channel = 0; channel < numChannels; ++channel)
+            dest[channel] += left * leftGains[channel] + right * rightGains[channel];
+        dest += numChannels;
+    }
+}
+
+/// Scale or accumulate interleaved frames with a gain ramp.
+template <bool Accumulate>
+void ProcessGainRamp(float* dest, const float* source, unsigned numFrames, unsigned numChannels, float fromGain, float toGain)
+{
+    const float step = (toGain - fromGain) / numFrames;
+    const unsigned numSamples = numFrames * numChannels;
+    unsigned i = 0;
+#if defined(URHO3D_SSE) || defined(__ARM_NEON)
+    // Four samples hold whole frames for up to four channels. Lanes of the same frame share a gain
+    if (numChannels <= 4 && 4 % numChannels == 0)
+    {
+        float laneGains[4];
+        for (unsigned lane = 0; lane < 4; ++lane)
+            laneGains[lane] = fromGain + step * (lane / numChannels);
+        const float vectorStep = step * (4 / numChannels);
+#if defined(URHO3D_SSE)
+        __m128 gain = _mm_loadu_ps(laneGains);
+        const __m128 gainStep = _mm_set1_ps(vectorStep);
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            __m128 value = _mm_mul_ps(_mm_loadu_ps(source + i), gain);
+            if (Accumulate)
+                value = _mm_add_ps(_mm_loadu_ps(dest + i), value);
+            _mm_storeu_ps(dest + i, value);
+            gain = _mm_add_ps(gain, gainStep);
+        }
+#else
+        float32x4_t gain = vld1q_f32(laneGains);
+        const float32x4_t gainStep = vdupq_n_f32(vectorStep);
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            float32x4_t value = vmulq_f32(vld1q_f32(source + i), gain);
+            if (Accumulate)
+                value = vaddq_f32(vld1q_f32(dest + i), value);
+            vst1q_f32(dest + i, value);
+            gain = vaddq_f32(gain, gainStep);
+        }
+#endif
+    }
+#endif
+    for (; i < numSamples; ++i)
+    {
+        const float value = source[i] * (fromGain + step * (i / numChannels));
+        dest[i] = Accumulate ? dest[i] + value : value;
+    }
+}
+
+}
+
+void MixMonoFrames(float* dest, const float* source, unsigned numFrames, unsigned numChannels, const float* gains)
+{
+    unsigned i = 0;
+#if defined(URHO3D_SSE)
+    switch (numChannels)
+    {
+    case 1:
+    {
+        const __m128 gain = _mm_set1_ps(gains[0]);
+        for (; i + 4 <= numFrames; i += 4)
+            _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i), _mm_mul_ps(_mm_loadu_ps(source + i), gain)));
+        break;
+    }
+    case 2:
+    {
+        // Duplicate each sample to both channels of its frame
+        const __m128 gain = _mm_setr_ps(gains[0], gains[1], gains[0], gains[1]);
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            const __m128 samples = _mm_loadu_ps(source + i);
+            float* frames = dest + 2 * i;
+            _mm_storeu_ps(frames, _mm_add_ps(_mm_loadu_ps(frames), _mm_mul_ps(_mm_unpacklo_ps(samples, samples), gain)));
+            _mm_storeu_ps(frames + 4, _mm_add_ps(_mm_loadu_ps(frames + 4), _mm_mul_ps(_mm_unpackhi_ps(samples, samples), gain)));
+        }
+        break;
+    }
+    case 4:
+    {
+        const __m128 gain = _mm_loadu_ps(gains);
+        for (; i < numFrames; ++i)
+        {
+            float* frame = dest + 4 * i;
+            _mm_storeu_ps(frame, _mm_add_ps(_mm_loadu_ps(frame), _mm_mul_ps(_mm_set1_ps(source[i]), gain)));
+        }
+        break;
+    }
+    case 6:
+    {
+        // Two frames make three vectors
+        const __m128 gain0 = _mm_loadu_ps(gains);
+        const __m128 gain1 = _mm_setr_ps(gains[4], gains[5], gains[0], gains[1]);
+        const __m128 gain2 = _mm_loadu_ps(gains + 2);
+        for (; i + 2 <= numFrames; i += 2)
+        {
+            const __m128 first = _mm_set1_ps(source[i]);
+            const __m128 second = _mm_set1_ps(source[i + 1]);
+            float* frames = dest + 6 * i;
+            _mm_storeu_ps(frames, _mm_add_ps(_mm_loadu_ps(frames), _mm_mul_ps(first, gain0)));
+            _mm_storeu_ps(frames + 4, _mm_add_ps(_mm_loadu_ps(frames + 4), _mm_mul_ps(_mm_shuffle_ps(first, second, 0), gain1)));
+            _mm_storeu_ps(frames + 8, _mm_add_ps(_mm_loadu_ps(frames + 8), _mm_mul_ps(second, gain2)));
+        }
+        break;
+    }
+    default:
+        break;
+    }
+#elif defined(__ARM_NEON)
+    switch (numChannels)
+    {
+    case 1:
+    {
+        const float32x4_t gain = vdupq_n_f32(gains[0]);
+        for (; i + 4 <= numFrames; i += 4)
+            vst1q_f32(dest + i, vmlaq_f32(vld1q_f32(dest + i), vld1q_f32(source + i), gain));
+        break;
+    }
+    case 2:
+    {
+        const float32x4_t gain = {gains[0], gains[1], gains[0], gains[1]};
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            const float32x4x2_t samples = vzipq_f32(vld1q_f32(source + i), vld1q_f32(source + i));
+            float* frames = dest + 2 * i;
+            vst1q_f32(frames, vmlaq_f32(vld1q_f32(frames), samples.val[0], gain));
+            vst1q_f32(frames + 4, vmlaq_f32(vld1q_f32(frames + 4), samples.val[1], gain));
+        }
+        break;
+    }
+    case 4:
+    {
+        const float32x4_t gain = vld1q_f32(gains);
+        for (; i < numFrames; ++i)
+        {
+            float* frame = dest + 4 * i;
+            vst1q_f32(frame, vmlaq_n_f32(vld1q_f32(frame), gain, source[i]));
+        }
+        break;
+    }
+    default:
+        break;
+    }
+#endif
+    MixMonoFramesGeneric(dest + i * numChannels, source + i, numFrames - i, numChannels, gains);
+}
+
+void MixStereoFrames(float* dest, const float* source, unsigned numFrames, unsigned numChannels, const float* leftGains, const float* rightGains)
+{
+    unsigned i = 0;
+#if defined(URHO3D_SSE)
+    switch (numChannels)
+    {
+    case 1:
+    {
+        const __m128 leftGain = _mm_set1_ps(leftGains[0]);
+        const __m128 rightGain = _mm_set1_ps(rightGains[0]);
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            // Separate left and right samples of four frames
+            const __m128 first = _mm_loadu_ps(source + 2 * i);
+            const __m128 second = _mm_loadu_ps(source + 2 * i + 4);
+            const __m128 left = _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 right = _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+            const __m128 mixed = _mm_add_ps(_mm_mul_ps(left, leftGain), _mm_mul_ps(right, rightGain));
+            _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i), mixed));
+        }
+        break;
+    }
+    case 2:
+    {
+        // Each output channel takes its own input channel and the swapped one
+        const __m128 directGain = _mm_setr_ps(leftGains[0], rightGains[1], leftGains[0], rightGains[1]);
+        const __m128 crossGain = _mm_setr_ps(rightGains[0], leftGains[1], rightGains[0], leftGains[1]);
+        for (; i + 2 <= numFrames; i += 2)
+        {
+            const __m128 frames = _mm_loadu_ps(source + 2 * i);
+            const __m128 swapped = _mm_shuffle_ps(frames, frames, _MM_SHUFFLE(2, 3, 0, 1));
+            const __m128 mixed = _mm_add_ps(_mm_mul_ps(frames, directGain), _mm_mul_ps(swapped, crossGain));
+            _mm_storeu_ps(dest + 2 * i, _mm_add_ps(_mm_loadu_ps(dest + 2 * i), mixed));
+        }
+        break;
+    }
+    case 4:
+    {
+        const __m128 leftGain = _mm_loadu_ps(leftGains);
+        const __m128 rightGain = _mm_loadu_ps(rightGains);
+        for (; i < numFrames; ++i)
+        {
+            float* frame = dest + 4 * i;
+            const __m128 mixed = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(source[2 * i]), leftGain), _mm_mul_ps(_mm_set1_ps(source[2 * i + 1]), rightGain));
+            _mm_storeu_ps(frame, _mm_add_ps(_mm_loadu_ps(frame), mixed));
+        }
+        break;
+    }
+    default:
+        break;
+    }
+#elif defined(__ARM_NEON)
+    switch (numChannels)
+    {
+    case 1:
+    {
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            const float32x4x2_t frames = vld2q_f32(source + 2 * i);
+            const float32x4_t mixed = vmlaq_n_f32(vmulq_n_f32(frames.val[0], leftGains[0]), frames.val[1], rightGains[0]);
+            vst1q_f32(dest + i, vaddq_f32(vld1q_f32(dest + i), mixed));
+        }
+        break;
+    }
+    case 2:
+    {
+        for (; i + 4 <= numFrames; i += 4)
+        {
+            const float32x4x2_t frames = vld2q_f32(source + 2 * i);
+            float32x4x2_t output = vld2q_f32(dest + 2 * i);
+            output.val[0] = vmlaq_n_f32(vmlaq_n_f32(output.val[0], frames.val[0], leftGains[0]), frames.val[1], rightGains[0]);
+            output.val[1] = vmlaq_n_f32(vmlaq_n_f32(output.val[1], frames.val[0], leftGains[1]), frames.val[1], rightGains[1]);
+            vst2q_f32(dest + 2 * i, output);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+#endif
+    MixStereoFramesGeneric(dest + i * numChannels, source + 2 * i, numFrames - i, numChannels, leftGains, rightGains);
+}
+
+void ApplyGainRamp(float* buffer, unsigned numFrames, unsigned numChannels, float fromGain, float toGain)
+{
+    ProcessGainRamp<false>(buffer, buffer, numFrames, numChannels, fromGain, toGain);
+}
+
+void MixGainRamp(float* dest, const float* source, unsigned numFrames, unsigned numChannels, float fromGain, float toGain)
+{
+    ProcessGainRamp<true>(dest, source, numFrames, numChannels, fromGain, toGain);
+}
+
+void LowPassFrames(float* buffer, unsigned numFrames, unsigned numChannels, float coefficient, float* state)
+{
+    // Recursive in time, so only the channels of a frame are independent
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        for (unsigned channel = 0; channel < numChannels; ++channel)
+        {
+            state[channel] += coefficient * (buffer[channel] - state[channel]);
+            buffer[channel] = state[channel];
+        }
+        buffer += numChannels;
+    }
+}
+
+float GetPeakLevel(const float* source, unsigned numSamples)
+{
+    unsigned i = 0;
+    float peak = 0.0f;
+#if defined(URHO3D_SSE)
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 peaks = _mm_setzero_ps();
+    for (; i + 4 <= numSamples; i += 4)
+        peaks = _mm_max_ps(peaks, _mm_and_ps(_mm_loadu_ps(source + i), absMask));
+    peaks = _mm_max_ps(peaks, _mm_movehl_ps(peaks, peaks));
+    peaks = _mm_max_ss(peaks, _mm_shuffle_ps(peaks, peaks, 1));
+    peak = _mm_cvtss_f32(peaks);
+#elif defined(__ARM_NEON)
+    float32x4_t peaks = vdupq_n_f32(0.0f);
+    for (; i + 4 <= numSamples; i += 4)
+        peaks = vmaxq_f32(peaks, vabsq_f32(vld1q_f32(source + i)));
+    const float32x2_t pairs = vmax_f32(vget_low_f32(peaks), vget_high_f32(peaks));
+    peak = Max(vget_lane_f32(pairs, 0), vget_lane_f32(pairs, 1));
+#endif
+    for (; i < numSamples; ++i)
+        peak = Max(peak, Abs(source[i]));
+    return peak;
+}
+
+void ConvertSamples(float* dest, const short* source, unsigned numSamples)
+{
+    unsigned i = 0;
+#if defined(URHO3D_SSE)
+    const __m128 scale = _mm_set1_ps(shortScale);
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        // Sign extend by unpacking into the high halves and shifting back
+        const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const int16x8_t samples = vld1q_s16(source + i);
+        vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))), shortScale));
+        vst1q_f32(dest + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples))), shortScale));
+    }
+#endif
+    for (; i < numSamples; ++i)
+        dest[i] = source[i] * shortScale;
+}
+
+void ConvertSamples(float* dest, const signed char* source, unsigned numSamples)
+{
+    for (unsigned i = 0; i < numSamples; ++i)
+        dest[i] = source[i] * byteScale;
+}
+
+void ConvertSamples(short* dest, const float* source, unsigned numSamples)
+{
+    unsigned i = 0;
+#if defined(URHO3D_SSE)
+    // Pack saturates, only the float to int conversion needs clamping
+    const __m128 minValue = _mm_set1_ps(-32768.0f);
+    const __m128 maxValue = _mm_set1_ps(32767.0f);
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const __m128 low = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(source + i), scale), minValue), maxValue);
+        const __m128 high = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(source + i + 4), scale), minValue), maxValue);
+        const __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), packed);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const int32x4_t low = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(source + i), 32768.0f));
+        const int32x4_t high = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(source + i + 4), 32768.0f));
+        vst1q_s16(dest + i, vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    }
+#endif
+    for (; i < numSamples; ++i)
+        dest[i] = static_cast<short>(Clamp(RoundToInt(source[i] * 32768.0f), -32768, 32767));
+}
+
+void ClampSamples(float* dest, const float* source, unsigned numSamples)
+{
+    unsigned i = 0;
+#if defined(URHO3D_SSE)
+    const __m128 minValue = _mm_set1_ps(-1.0f);
+    const __m128 maxValue = _mm_set1_ps(1.0f);
+    for (; i + 4 <= numSamples; i += 4)
+        _mm_storeu_ps(dest + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i), minValue), maxValue));
+#elif defined(__ARM_NEON)
+    const float32x4_t minValue = vdupq_n_f32(-1.0f);
+    const float32x4_t maxValue = vdupq_n_f32(1.0f);
+    for (; i + 4 <= numSamples; i += 4)
+        vst1q_f32(dest + i, vminq_f32(vmaxq_f32(vld1q_f32(source + i), minValue), maxValue));
+#endif
+    for (; i < numSamples; ++i)
+        dest[i] = Clamp(source[i], -1.0f, 1.0f);
+}
+
+}
@@ -0,0 +1,56 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Urho3D.h"
+
+namespace Urho3D
+{
+
+/// Maximum number of interleaved output channels of the mix kernels.
+static constexpr unsigned MaxMixChannels = 6;
+
+/// Accumulate mono frames into interleaved output frames, with a gain per output channel.
+URHO3D_API void MixMonoFrames(float* dest, const float* source, unsigned numFrames, unsigned numChannels, const float* gains);
+/// Accumulate interleaved stereo frames into interleaved output frames, with gains per output channel for the left and the right input channel.
+URHO3D_API void MixStereoFrames(float* dest, const float* source, unsigned numFrames, unsigned numChannels, const float* leftGains, const float* rightGains);
+
+/// Scale interleaved frames in place by a gain that moves linearly from one value to another.
+URHO3D_API void ApplyGainRamp(float* buffer, unsigned numFrames, unsigned numChannels, float fromGain, float toGain);
+/// Accumulate interleaved frames into frames of the same layout, with a gain that moves linearly from one value to another.
+URHO3D_API void MixGainRamp(float* dest, const float* source, unsigned numFrames, unsigned numChannels, float fromGain, float toGain);
+/// Filter interleaved frames in place with a one-pole low-pass per channel. State holds the last output of each channel.
+URHO3D_API void LowPassFrames(float* buffer, unsigned numFrames, unsigned numChannels, float coefficient, float* state);
+/// Return largest absolute sample value.
+URHO3D_API float GetPeakLevel(const float* source, unsigned numSamples);
+
+/// Convert 16-bit samples to float samples in [-1, 1).
+URHO3D_API void ConvertSamples(float* dest, const short* source, unsigned numSamples);
+/// Convert 8-bit samples to float samples in [-1, 1).
+URHO3D_API void ConvertSamples(float* dest, const signed char* source, unsigned numSamples);
+/// Convert float samples to 16-bit samples, saturating outside of [-1, 1].
+URHO3D_API void ConvertSamples(short* dest, const float* source, unsigned numSamples);
+/// Copy float samples, clamping them to [-1, 1].
+URHO3D_API void ClampSamples(float* dest, const float* source, unsigned numSamples);
+
+}
@@ -0,0 +1,261 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Audio/AudioResampler.h"
+#include "../Math/MathDefs.h"
+
+#include <EASTL/unique_ptr.h>
+#include <EASTL/unordered_map.h>
+
+#include <mutex>
+
+#if defined(URHO3D_SSE)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+namespace
+{
+
+/// Kaiser window shape parameter, trades main lobe width for stop band attenuation.
+const double kaiserBeta = 8.0;
+/// Cutoff relative to the lower of both Nyquist frequencies, leaves room for the transition band.
+const double cutoffRolloff = 0.9;
+/// Number of cached cutoff steps.
+const int numCutoffSteps = 64;
+
+/// Return zeroth order modified Bessel function of the first kind.
+double BesselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50 && term > sum * 1e-12; ++k)
+    {
+        const double factor = x / (2.0 * k);
+        term *= factor * factor;
+        sum += term;
+    }
+    return sum;
+}
+
+/// Return dot products of data with two coefficient sets.
+inline void DotProducts(const float* data, const float* first, const float* second, float& firstResult, float& secondResult)
+{
+    static constexpr unsigned numTaps = ResamplerFilterBank::NumTaps;
+#if defined(URHO3D_SSE)
+    __m128 firstSum = _mm_setzero_ps();
+    __m128 secondSum = _mm_setzero_ps();
+    for (unsigned i = 0; i < numTaps; i += 4)
+    {
+        const __m128 samples = _mm_loadu_ps(data + i);
+        firstSum = _mm_add_ps(firstSum, _mm_mul_ps(samples, _mm_loadu_ps(first + i)));
+        secondSum = _mm_add_ps(secondSum, _mm_mul_ps(samples, _mm_loadu_ps(second + i)));
+    }
+
+    // Horizontal sums of both accumulators at once
+    const __m128 low = _mm_unpacklo_ps(firstSum, secondSum);
+    const __m128 high = _mm_unpackhi_ps(firstSum, secondSum);
+    const __m128 pairs = _mm_add_ps(low, high);
+    const __m128 sums = _mm_add_ps(pairs, _mm_movehl_ps(pairs, pairs));
+    firstResult = _mm_cvtss_f32(sums);
+    secondResult = _mm_cvtss_f32(_mm_shuffle_ps(sums, sums, _MM_SHUFFLE(1, 1, 1, 1)));
+#elif defined(__ARM_NEON)
+    float32x4_t firstSum = vdupq_n_f32(0.0f);
+    float32x4_t secondSum = vdupq_n_f32(0.0f);
+    for (unsigned i = 0; i < numTaps; i += 4)
+    {
+        const float32x4_t samples = vld1q_f32(data + i);
+        firstSum = vmlaq_f32(firstSum, samples, vld1q_f32(first + i));
+        secondSum = vmlaq_f32(secondSum, samples, vld1q_f32(second + i));
+    }
+
+    const float32x2_t sums = vpadd_f32(
+        vadd_f32(vget_low_f32(firstSum), vget_high_f32(firstSum)), vadd_f32(vget_low_f32(secondSum), vget_high_f32(secondSum)));
+    firstResult = vget_lane_f32(sums, 0);
+    secondResult = vget_lane_f32(sums, 1);
+#else
+    float firstSum = 0.0f;
+    float secondSum = 0.0f;
+    for (unsigned i = 0; i < numTaps; ++i)
+    {
+        firstSum += data[i] * first[i];
+        secondSum += data[i] * second[i];
+    }
+    firstResult = firstSum;
+    secondResult = secondSum;
+#endif
+}
+
+}
+
+ResamplerFilterBank::ResamplerFilterBank(float cutoff)
+    : cutoff_(cutoff)
+{
+    // Tap NumTaps / 2 - 1 is centered on the output sample at phase 0
+    const double center = NumTaps / 2 - 1;
+    const double halfLength = NumTaps / 2;
+    const double windowScale = 1.0 / BesselI0(kaiserBeta);
+
+    coefficients_.resize((NumPhases + 1) * NumTaps);
+    for (unsigned phase = 0; phase <= NumPhases; ++phase)
+    {
+        float* coefficients = &coefficients_[phase * NumTaps];
+        const double offset = center + static_cast<double>(phase) / NumPhases;
+
+        double sum = 0.0;
+        for (unsigned tap = 0; tap < NumTaps; ++tap)
+        {
+            const double distance = tap - offset;
+            const double x = M_PI * cutoff_ * distance;
+            const double sinc = Abs(x) < 1e-9 ? 1.0 : sin(x) / x;
+            const double t = distance / halfLength;
+            const double window = BesselI0(kaiserBeta * sqrt(Max(0.0, 1.0 - t * t))) * windowScale;
+            coefficients[tap] = static_cast<float>(sinc * window);
+            sum += coefficients[tap];
+        }
+
+        // Normalize every phase to unity gain at DC
+        for (unsigned tap = 0; tap < NumTaps; ++tap)
+            coefficients[tap] = static_cast<float>(coefficients[tap] / sum);
+    }
+}
+
+const ResamplerFilterBank* ResamplerFilterBank::Get(double step)
+{
+    static std::mutex mutex;
+    static ea::unordered_map<int, ea::unique_ptr<ResamplerFilterBank>> banks;
+
+    // Downsampling lowers the cutoff to the output Nyquist frequency
+    const int cutoffStep = Clamp(RoundToInt(static_cast<float>(numCutoffSteps / Max(step, 1.0))), 1, numCutoffSteps);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& bank = banks[cutoffStep];
+    if (!bank)
+        bank = ea::make_unique<ResamplerFilterBank>(static_cast<float>(cutoffRolloff * cutoffStep / numCutoffSteps));
+    return bank.get();
+}
+
+void AudioResampler::Initialize(unsigned numChannels, unsigned maxOutputFrames)
+{
+    numChannels_ = numChannels;
+    capacity_ = ResamplerFilterBank::NumTaps + static_cast<unsigned>(ceil(maxOutputFrames * MaxStep)) + 1;
+    buffer_.resize(numChannels_ * capacity_);
+    Reset();
+}
+
+void AudioResampler::Reset()
+{
+    // Pad with silence so the first output frame is centered on the first input frame
+    numFrames_ = ResamplerFilterBank::NumTaps / 2 - 1;
+    position_ = 0;
+    ea::fill(buffer_.begin(), buffer_.end(), 0.0f);
+}
+
+unsigned AudioResampler::GetNumInputFramesNeeded(unsigned numOutputFrames, double step) const
+{
+    if (!numOutputFrames)
+        return 0;
+
+    const unsigned long long lastPosition = position_ + (numOutputFrames - 1) * ToFixed(step);
+    const unsigned framesNeeded = static_cast<unsigned>(lastPosition >> FractionBits) + ResamplerFilterBank::NumTaps;
+    return framesNeeded > numFrames_ ? framesNeeded - numFrames_ : 0;
+}
+
+void AudioResampler::PushInput(const float* data, unsigned numFrames)
+{
+    numFrames = Min(numFrames, capacity_ - numFrames_);
+    for (unsigned channel = 0; channel < numChannels_; ++channel)
+    {
+        float* dest = &buffer_[channel * capacity_ + numFrames_];
+        for (unsigned frame = 0; frame < numFrames; ++frame)
+            dest[frame] = data[frame * numChannels_ + channel];
+    }
+    numFrames_ += numFrames;
+}
+
+void AudioResampler::Process(float* output, unsigned numOutputFrames, double step, const ResamplerFilterBank* bank)
+{
+    static constexpr unsigned phaseBits = 7;
+    static_assert(1u << phaseBits == ResamplerFilterBank::NumPhases, "Phase bits must match number of phases");
+    static constexpr unsigned weightBits = FractionBits - phaseBits;
+    static constexpr float weightScale = 1.0f / (1u << weightBits);
+
+    // Never read past buffered input, missing frames are treated as silence
+    const unsigned long long fixedStep = ToFixed(step);
+    const unsigned missingFrames = GetNumInputFramesNeeded(numOutputFrames, step);
+    if (missingFrames)
+    {
+        for (unsigned channel = 0; channel < numChannels_; ++channel)
+            ea::fill_n(&buffer_[channel * capacity_ + numFrames_], Min(missingFrames, capacity_ - numFrames_), 0.0f);
+        numFrames_ = Min(numFrames_ + missingFrames, capacity_);
+    }
+
+    for (unsigned frame = 0; frame < numOutputFrames; ++frame)
+    {
+        const unsigned index = static_cast<unsigned>(position_ >> FractionBits);
+        const unsigned fraction = static_cast<unsigned>(position_);
+        const unsigned phase = fraction >> weightBits;
+        const float weight = (fraction & ((1u << weightBits) - 1)) * weightScale;
+        const float* first = bank->GetPhase(phase);
+        const float* second = bank->GetPhase(phase + 1);
+
+        // Interpolate between the two nearest phases
+        for (unsigned channel = 0; channel < numChannels_; ++channel)
+        {
+            float firstResult;
+            float secondResult;
+            DotProducts(&buffer_[channel * capacity_ + index], first, second, firstResult, secondResult);
+            output[frame * numChannels_ + channel] = firstResult + (secondResult - firstResult) * weight;
+        }
+
+        position_ += fixedStep;
+    }
+
+    // Drop input frames no longer covered by the filter
+    const unsigned consumedFrames = Min(static_cast<unsigned>(position_ >> FractionBits), numFrames_);
+    if (consumedFrames)
+    {
+        for (unsigned channel = 0; channel < numChannels_; ++channel)
+        {
+            float* data = &buffer_[channel * capacity_];
+            ea::copy(data + consumedFrames, data + numFrames_, data);
+        }
+        numFrames_ -= consumedFrames;
+        position_ -= static_cast<unsigned long long>(consumedFrames) << FractionBits;
+    }
+}
+
+unsigned long long AudioResampler::ToFixed(double step)
+{
+    return static_cast<unsigned long long>(Clamp(step, 1.0 / 1024.0, MaxStep) * (1ull << FractionBits));
+}
+
+}
@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Urho3D.h"
+
+#include <EASTL/vector.h>
+
+namespace Urho3D
+{
+
+/// Kaiser windowed sinc filter bank for polyphase resampling. Banks are cached per cutoff and never released.
+class URHO3D_API ResamplerFilterBank
+{
+public:
+    /// Number of filter taps.
+    static constexpr unsigned NumTaps = 32;
+    /// Number of filter phases between two input samples.
+    static constexpr unsigned NumPhases = 128;
+
+    /// Construct for cutoff frequency relative to the input Nyquist frequency.
+    explicit ResamplerFilterBank(float cutoff);
+
+    /// Return bank suitable for a resampling step, in input samples per output sample. Thread safe, may allocate.
+    static const ResamplerFilterBank* Get(double step);
+
+    /// Return coefficients of a phase. Phase NumPhases is the first phase of the next input sample.
+    const float* GetPhase(unsigned phase) const { return &coefficients_[phase * NumTaps]; }
+    /// Return cutoff frequency relative to the input Nyquist frequency.
+    float GetCutoff() const { return cutoff_; }
+
+private:
+    /// Cutoff frequency relative to the input Nyquist frequency.
+    float cutoff_{};
+    /// Coefficients of NumPhases + 1 phases.
+    ea::vector<float> coefficients_;
+};
+
+/// Streaming polyphase sample rate converter with per-instance history. Processing never allocates.
+class URHO3D_API AudioResampler
+{
+public:
+    /// Largest supported step, in input samples per output sample.
+    static constexpr double MaxStep = 4.0;
+
+    /// Allocate history for channels and the largest block of output frames, then reset.
+    void Initialize(unsigned numChannels, unsigned maxOutputFrames);
+    /// Forget history. The first output frame is centered on the next input frame.
+    void Reset();
+
+    /// Return number of input frames that must be pushed before processing output frames at a step.
+    unsigned GetNumInputFramesNeeded(unsigned numOutputFrames, double step) const;
+    /// Append interleaved input frames.
+    void PushInput(const float* data, unsigned numFrames);
+    /// Produce interleaved output frames at a step, consuming input frames that are no longer needed.
+    void Process(float* output, unsigned numOutputFrames, double step, const ResamplerFilterBank* bank);
+
+    /// Return number of channels.
+    unsigned GetNumChannels() const { return numChannels_; }
+
+private:
+    /// Number of fractional bits of fixed point positions.
+    static constexpr unsigned FractionBits = 32;
+
+    /// Convert step to fixed point.
+    static unsigned long long ToFixed(double step);
+
+    /// Number of channels.
+    unsigned numChannels_{};
+    /// Frames each channel can hold.
+    unsigned capacity_{};
+    /// Buffered input frames, one contiguous range per channel.
+    ea::vector<float> buffer_;
+    /// Number of buffered frames.
+    unsigned numFrames_{};
+    /// Fixed point position of the first tap of the next output frame within the buffer.
+    unsigned long long position_{};
+};
+
+}
@@ -25,6 +25,9 @@
 #include "Microphone.h"
 
 #include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/Timer.h"
 #include "../IO/Log.h"
 
 #include "AudioEvents.h"
@@ -36,6 +39,34 @@
 namespace Urho3D
 {
 
+namespace
+{
+
+/// Size of the encoded packet buffer in bytes.
+const unsigned PACKET_BUFFER_SIZE = 64 * 1024;
+
+}
+
+class Microphone::EncoderThread : public Thread
+{
+public:
+    explicit EncoderThread(Microphone* microphone) : Thread("Microphone Encoder"), microphone_(microphone) {}
+
+    void ThreadFunction() override
+    {
+        URHO3D_PROFILE_THREAD(name_.c_str());
+        while (shouldRun_)
+        {
+            // Encoder frames are usually 10-20 ms long, polling bounds added latency without waking the capture thread
+            microphone_->EncodeCaptured();
+            Time::Sleep(5);
+        }
+    }
+
+private:
+    Microphone* microphone_;
+};
+
 Microphone::Microphone(Context* ctx) : Object(ctx),
     micID_(0),
     which_(0),
@@ -50,6 +81,8 @@ Microphone::~Microphone()
     if (micID_ != 0)
         SDL_CloseAudioDevice(micID_);
     micID_ = 0;
+
+    StopEncoderThread();
 }
 
 void Microphone::RegisterObject(Context* ctx)
@@ -81,6 +114,10 @@ void Microphone::Init(const ea::string& name, SDL_AudioDeviceID id, int bufferSi
     frequency_ = frequency;
     buffer_.reserve(bufferSize);
 
+    // Hold at least half a second so that a stalled consumer does not drop samples right away
+    if (!captureBuffer_.GetCapacity())
+        captureBuffer_.Resize(Max(static_cast<unsigned>(bufferSize) * 4, frequency / 2));
+
     SetEnabled(true);
 }
 
@@ -126,36 +163,139 @@ void Microphone::Update(unsigned char* rawData, int rawDataLen)
     if (!enabled_)
         return;
 
-    if (wakeThreshold_ != UINT_MAX)
-    {
-        int16_t* data = (int16_t*)rawData;
-        const int sampleCt = rawDataLen / sizeof(int16_t);
+    const int16_t* data = reinterpret_cast<const int16_t*>(rawData);
+    const unsigned sampleCt = rawDataLen / sizeof(int16_t);
 
+    const unsigned wakeThreshold = wakeThreshold_;
+    if (wakeThreshold != UINT_MAX)
+    {
         bool needsWake = false;
-        for (int i = 0; i < sampleCt; ++i)
-            needsWake |= abs(data[i]) > wakeThreshold_;
+        for (unsigned i = 0; i < sampleCt; ++i)
+            needsWake |= static_cast<unsigned>(abs(data[i])) > wakeThreshold;
 
         if (!needsWake)
         {
             isSleeping_ = true;
             return;
         }
-        isSleeping_ = false;
     }
 
-    MutexLock lockHandle(lock_);
+    // Never wait for the consumer here, drop what does not fit
+    const unsigned numWritten = captureBuffer_.Write(data, sampleCt);
+    if (numWritten != sampleCt)
+        numDroppedSamples_.fetch_add(sampleCt - numWritten, std::memory_order_relaxed);
 
-    unsigned sz = buffer_.size();
-    buffer_.resize(sz + rawDataLen / sizeof(int16_t));
+    isDirty_ = true;
+    isSleeping_ = false;
+}
 
-    auto buffPtr = buffer_.data();
-    memcpy(buffPtr + sz, rawData, rawDataLen);
+void Microphone::SetCaptureBufferSize(unsigned numSamples)
+{
+    // The capture thread produces and the encoder thread consumes, both must be stopped while the buffer is replaced
+    const bool restartEncoderThread = encoderThread_ != nullptr;
+    StopEncoderThread();
 
-    if (linkedStream_)
-        linkedStream_->AddData(rawData, rawDataLen);
+    if (micID_ != 0)
+        SDL_LockAudioDevice(micID_);
 
-    isDirty_ = true;
-    isSleeping_ = false;
+    captureBuffer_.Resize(numSamples);
+
+    if (micID_ != 0)
+        SDL_UnlockAudioDevice(micID_);
+
+    if (restartEncoderThread)
+        SetEncoder(encoder_, true);
+}
+
+void Microphone::SetEncoder(MicrophoneEncoder* encoder, bool threaded)
+{
+    StopEncoderThread();
+
+    encoder_ = encoder;
+    if (!encoder_)
+        return;
+
+    if (!packetBuffer_.GetCapacity())
+        packetBuffer_.Resize(PACKET_BUFFER_SIZE);
+
+    if (threaded)
+    {
+        encoderThread_ = ea::make_unique<EncoderThread>(this);
+        if (!encoderThread_->Run())
+        {
+            URHO3D_LOGWARNING("Could not start microphone encoder thread, encoding on audio update");
+            encoderThread_.reset();
+        }
+    }
+}
+
+unsigned Microphone::EncodeCaptured()
+{
+    const unsigned frameSize = encoder_ ? encoder_->GetFrameSize() : 0;
+    if (!frameSize)
+        return 0;
+
+    unsigned numPackets = 0;
+    while (captureBuffer_.GetNumReadable() >= frameSize)
+    {
+        // Encode in place unless the frame wraps around the capture buffer
+        const CaptureSpans spans = captureBuffer_.Peek(frameSize);
+        ea::span<const int16_t> frame = spans.first;
+        if (!spans.second.empty())
+        {
+            encoderFrame_.assign(spans.first.begin(), spans.first.end());
+            encoderFrame_.insert(encoderFrame_.end(), spans.second.begin(), spans.second.end());
+            frame = encoderFrame_;
+        }
+
+        encoderPacket_.clear();
+        const bool encoded = encoder_->Encode(frame, encoderPacket_);
+        captureBuffer_.Discard(frameSize);
+        if (!encoded)
+            continue;
+
+        const unsigned packetSize = encoderPacket_.size();
+        if (packetBuffer_.GetNumWritable() < sizeof(packetSize) + packetSize)
+        {
+            numDroppedPackets_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        packetBuffer_.Write(reinterpret_cast<const unsigned char*>(&packetSize), sizeof(packetSize));
+        packetBuffer_.Write(encoderPacket_.data(), packetSize);
+        ++numPackets;
+    }
+    return numPackets;
+}
+
+bool Microphone::ReadPacket(ea::vector<unsigned char>& packet)
+{
+    unsigned packetSize = 0;
+    const auto header = packetBuffer_.Peek(sizeof(packetSize));
+    if (header.first.size() + header.second.size() != sizeof(packetSize))
+        return false;
+
+    auto* packetSizeBytes = reinterpret_cast<unsigned char*>(&packetSize);
+    ea::copy(header.first.begin(), header.first.end(), packetSizeBytes);
+    ea::copy(header.second.begin(), header.second.end(), packetSizeBytes + header.first.size());
+
+    // Size and payload are published separately, wait for the whole packet
+    if (packetBuffer_.GetNumReadable() < sizeof(packetSize) + packetSize)
+        return false;
+
+    packetBuffer_.Discard(sizeof(packetSize));
+    packet.resize(packetSize);
+    packetBuffer_.Read(packet.data(), packetSize);
+    return true;
+}
+
+void Microphone::StopEncoderThread()
+{
+    if (encoderThread_)
+    {
+        encoderThread_->Stop();
+        encoderThread_.reset();
+    }
 }
 
 void Microphone::CheckDirtiness()
@@ -163,23 +303,40 @@ void Microphone::CheckDirtiness()
     if (!enabled_)
         return;
 
+    if (encoder_)
+    {
+        if (!encoderThread_)
+            EncodeCaptured();
+        return;
+    }
+
+    if (!isDirty_.exchange(false))
+        return;
+
     MutexLock lockHandle(lock_);
 
-    if (isDirty_)
+    if (!streaming_)
     {
-        auto& data = GetEventDataMap();
+        const CaptureSpans spans = captureBuffer_.Peek();
+        for (const ea::span<const int16_t>& span : {spans.first, spans.second})
+        {
+            buffer_.insert(buffer_.end(), span.begin(), span.end());
+            if (linkedStream_ && !span.empty())
+                linkedStream_->AddData(const_cast<int16_t*>(span.data()), span.size() * sizeof(int16_t));
+        }
+        captureBuffer_.Discard(spans.first.size() + spans.second.size());
+    }
 
-        data[RecordingUpdated::P_MICROPHONE] = this;
-        data[RecordingUpdated::P_DATALENGTH] = (int)buffer_.size();
-        data[RecordingUpdated::P_CLEARDATA] = false;
-        SendEvent(E_RECORDINGUPDATED, data);
+    auto& data = GetEventDataMap();
 
-        // This is generally not done, using an event-data param as a return value. Unsure about how I feel about it.
-        if (data[RecordingUpdated::P_CLEARDATA].GetBool())
-            buffer_.clear();
+    data[RecordingUpdated::P_MICROPHONE] = this;
+    data[RecordingUpdated::P_DATALENGTH] = streaming_ ? (int)captureBuffer_.GetNumReadable() : (int)buffer_.size();
+    data[RecordingUpdated::P_CLEARDATA] = false;
+    SendEvent(E_RECORDINGUPDATED, data);
 
-        isDirty_ = false;
-    }
+    // This is generally not done, using an event-data param as a return value. Unsure about how I feel about it.
+    if (!streaming_ && data[RecordingUpdated::P_CLEARDATA].GetBool())
+        buffer_.clear();
 }
 
 SharedPtr<BufferedSoundStream> Microphone::GetLinked() const
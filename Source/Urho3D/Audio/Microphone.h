@@ -22,16 +22,32 @@
 
 #pragma once
 
+#include "../Container/RingBuffer.h"
 #include "../Core/Object.h"
 #include "../Core/Mutex.h"
 
+#include <EASTL/unique_ptr.h>
+
 #include <SDL.h>
 
+#include <atomic>
+
 namespace Urho3D
 {
 
 class BufferedSoundStream;
 
+/// Encoder turning fixed-size frames of captured 16-bit samples into packets, e.g. for network voice chat.
+/// May be called from a worker thread owned by the microphone.
+class URHO3D_API MicrophoneEncoder : public RefCounted
+{
+public:
+    /// Return number of samples consumed per packet.
+    virtual unsigned GetFrameSize() const = 0;
+    /// Encode exactly GetFrameSize() samples into packet. Return false to drop the frame.
+    virtual bool Encode(ea::span<const int16_t> samples, ea::vector<unsigned char>& packet) = 0;
+};
+
 /// Microphone audio input device. Uses are for speech recognition or network speech, not intended for high quality recording usage.
 class URHO3D_API Microphone : public Object
 {
@@ -45,6 +61,9 @@ public:
     /// Register factory.
     static void RegisterObject(Context*);
 
+    /// Pair of captured sample ranges, the second one is non-empty when the data wraps around the capture buffer.
+    using CaptureSpans = ea::pair<ea::span<const int16_t>, ea::span<const int16_t>>;
+
     /// Gets direct access to the data.
     ea::vector<int16_t>& GetData() { return buffer_; }
     /// Gets direct access to the data.
@@ -56,9 +75,44 @@ public:
     /// Wipes the buffer clean.
     void ClearData();
 
-    /// Appends data to the internal buffer.
+    /// Appends data to the capture buffer. Called from the SDL capture thread, never blocks.
     void Update(unsigned char* rawData, int rawDataLen);
 
+    /// Set capture buffer size in samples. Buffered samples are discarded. Capture and the encoder thread are paused during the resize.
+    void SetCaptureBufferSize(unsigned numSamples);
+    /// Return capture buffer size in samples.
+    unsigned GetCaptureBufferSize() const { return captureBuffer_.GetCapacity(); }
+    /// Return number of samples dropped because the capture buffer was full.
+    unsigned GetNumDroppedSamples() const { return numDroppedSamples_.load(std::memory_order_relaxed); }
+
+    /// Set whether captured samples are left in the capture buffer for PeekCapture and ReadCapture
+    /// instead of being copied into GetData() and the linked stream.
+    void SetStreaming(bool enable) { streaming_ = enable; }
+    /// Return whether streaming consumption is enabled.
+    bool IsStreaming() const { return streaming_; }
+    /// Return number of captured samples available to the streaming consumer.
+    unsigned GetNumCaptured() const { return captureBuffer_.GetNumReadable(); }
+    /// Return up to maxSamples captured samples without copying. Release them with ConsumeCapture.
+    /// Call from a single consumer thread in streaming mode only.
+    CaptureSpans PeekCapture(unsigned maxSamples = M_MAX_UNSIGNED) const { return captureBuffer_.Peek(maxSamples); }
+    /// Release samples returned by PeekCapture. Return number of samples released.
+    unsigned ConsumeCapture(unsigned numSamples) { return captureBuffer_.Discard(numSamples); }
+    /// Copy up to maxSamples captured samples into dest. Return number of samples copied.
+    unsigned ReadCapture(int16_t* dest, unsigned maxSamples) { return captureBuffer_.Read(dest, maxSamples); }
+
+    /// Set encoder consuming captured samples. Encoding runs on a worker thread when threaded is set and threading is available,
+    /// otherwise on the main thread on audio update. Captured samples are not copied into GetData() while an encoder is set.
+    void SetEncoder(MicrophoneEncoder* encoder, bool threaded = true);
+    /// Return encoder.
+    MicrophoneEncoder* GetEncoder() const { return encoder_; }
+    /// Encode all complete frames in the capture buffer. Called automatically, exposed for custom scheduling.
+    /// Return number of packets produced.
+    unsigned EncodeCaptured();
+    /// Read next encoded packet. Return false if there is none. Call from a single consumer thread.
+    bool ReadPacket(ea::vector<unsigned char>& packet);
+    /// Return number of packets dropped because the packet buffer was full.
+    unsigned GetNumDroppedPackets() const { return numDroppedPackets_.load(std::memory_order_relaxed); }
+
     /// Returns the frequency of the microphone's recording.
     /// @property
     unsigned GetFrequency() const { return frequency_; }
@@ -93,10 +147,14 @@ public:
     void Unlink();
 
 private:
+    class EncoderThread;
+
     /// Initializes the SDL audio device.
     void Init(const ea::string& name, SDL_AudioDeviceID id, int bufferSize, unsigned frequency, unsigned which);
     /// Audio calls this to check if the SDL thread has appended data to us.
     void CheckDirtiness();
+    /// Stop encoder worker thread if running.
+    void StopEncoderThread();
 
     /// Target to auto-copy data into.
     SharedPtr<BufferedSoundStream> linkedStream_;
@@ -104,22 +162,40 @@ private:
     ea::string name_;
     /// Stored copy of data contained.
     ea::vector<int16_t> buffer_;
+    /// Samples written by the SDL capture thread and read by a single consumer.
+    RingBuffer<int16_t> captureBuffer_;
+    /// Encoded packets prefixed with their size, written by the encoder and read by a single consumer.
+    RingBuffer<unsigned char> packetBuffer_;
+    /// Encoder.
+    SharedPtr<MicrophoneEncoder> encoder_;
+    /// Encoder worker thread.
+    ea::unique_ptr<EncoderThread> encoderThread_;
+    /// Frame passed to the encoder when captured samples wrap around the capture buffer.
+    ea::vector<int16_t> encoderFrame_;
+    /// Packet produced by the encoder.
+    ea::vector<unsigned char> encoderPacket_;
+    /// Number of samples dropped by the capture thread.
+    std::atomic<unsigned> numDroppedSamples_{};
+    /// Number of packets dropped by the encoder.
+    std::atomic<unsigned> numDroppedPackets_{};
     /// SDL identifier for the mic.
     SDL_AudioDeviceID micID_;
     /// Last seen index by SDL.
     unsigned which_;
-    /// Lock object for thread safety, most operations on speech are going to want to be threaded.
+    /// Lock object for the stored copy of data, the capture thread never takes it.
     mutable Mutex lock_;
     /// HZ freq of the mic.
     unsigned frequency_;
     /// Signal threshold above which to "wake" the microphone. Not very effective.
-    unsigned wakeThreshold_ = UINT_MAX;
+    std::atomic<unsigned> wakeThreshold_{UINT_MAX};
     /// Whether to active capture data or not (data still comes in, but is ignored not copied).
-    bool enabled_;
+    std::atomic<bool> enabled_;
     /// Whether the microphone has failed to meet wake thresholds.
-    bool isSleeping_ = false;
+    std::atomic<bool> isSleeping_{};
     /// Cleanliness state of the data.
-    bool isDirty_ = false;
+    std::atomic<bool> isDirty_{};
+    /// Whether captured samples are consumed through the streaming API.
+    bool streaming_{};
 };
 
 }
@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Audio/PrefetchSoundStream.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+PrefetchSoundStream::PrefetchSoundStream(SoundStream* stream, unsigned capacity) :
+    stream_(stream)
+{
+    assert(stream);
+
+    SetFormat(stream->GetIntFrequency(), stream->IsSixteenBit(), stream->IsStereo());
+    // The decoded stream rewinds by itself when looping
+    SetStopAtEnd(stream->GetStopAtEnd());
+
+    // Decode in chunks of a quarter of the buffer, keeping whole frames
+    const unsigned sampleSize = GetSampleSize();
+    buffer_.Resize(Max(capacity, sampleSize * 4));
+    decodeBuffer_.resize(Max(buffer_.GetCapacity() / 4 / sampleSize, 1u) * sampleSize);
+
+    // Prime the buffer so that playback does not start with silence
+    Decode();
+}
+
+PrefetchSoundStream::~PrefetchSoundStream() = default;
+
+bool PrefetchSoundStream::Seek(unsigned sample_number)
+{
+    MutexLock lock(decodeMutex_);
+    if (!stream_->Seek(sample_number))
+        return false;
+
+    // Everything written so far is stale. Only the mixing thread may drop it
+    flushPosition_.store(numWritten_, std::memory_order_release);
+    finished_.store(false, std::memory_order_release);
+
+    // Refill the space not taken by stale data, so the mixing thread does not have to wait for the decoder thread
+    DecodeLockless();
+    return true;
+}
+
+unsigned PrefetchSoundStream::GetData(signed char* dest, unsigned numBytes)
+{
+    // Check for the end before reading, all data of a finished stream is in the buffer by then
+    const bool finished = finished_.load(std::memory_order_acquire);
+    unsigned outBytes = ReadDecoded(dest, numBytes);
+
+    // Keep playing through an underrun, returning less data would stop one-shot streams
+    if (outBytes < numBytes && !finished)
+    {
+        memset(dest + outBytes, 0, numBytes - outBytes);
+        outBytes = numBytes;
+        numUnderruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return outBytes;
+}
+
+void PrefetchSoundStream::Decode()
+{
+    MutexLock lock(decodeMutex_);
+    DecodeLockless();
+}
+
+unsigned PrefetchSoundStream::ReadDecoded(signed char* dest, unsigned numBytes)
+{
+    // Drop data decoded before a seek
+    const unsigned long long flushPosition = flushPosition_.load(std::memory_order_acquire);
+    if (numRead_ < flushPosition)
+        numRead_ += buffer_.Discard(static_cast<unsigned>(flushPosition - numRead_));
+
+    const unsigned sampleSize = GetSampleSize();
+    const unsigned outBytes = buffer_.Read(dest, Min(numBytes, buffer_.GetNumReadable()) / sampleSize * sampleSize);
+    numRead_ += outBytes;
+    return outBytes;
+}
+
+void PrefetchSoundStream::DecodeLockless()
+{
+    if (finished_.load(std::memory_order_relaxed))
+        return;
+
+    while (buffer_.GetNumWritable() >= decodeBuffer_.size())
+    {
+        const unsigned numBytes = stream_->GetData(decodeBuffer_.data(), decodeBuffer_.size());
+        if (!numBytes)
+        {
+            if (stream_->GetStopAtEnd())
+                finished_.store(true, std::memory_order_release);
+            return;
+        }
+
+        buffer_.Write(decodeBuffer_.data(), numBytes);
+        numWritten_ += numBytes;
+    }
+}
+
+}
@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Audio/SoundStream.h"
+#include "../Container/Ptr.h"
+#include "../Container/RingBuffer.h"
+#include "../Core/Mutex.h"
+
+#include <EASTL/vector.h>
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+/// Sound stream that plays another sound stream decoded ahead of playback by a background thread. Reading never blocks.
+class URHO3D_API PrefetchSoundStream : public SoundStream
+{
+public:
+    /// Construct from the stream to decode, with buffer capacity in bytes. Fills the buffer before returning.
+    PrefetchSoundStream(SoundStream* stream, unsigned capacity);
+    /// Destruct.
+    ~PrefetchSoundStream() override;
+
+    /// Seek to sample number and decode into the free buffer space. Return true on success. Data decoded before the seek is dropped by the next GetData.
+    bool Seek(unsigned sample_number) override;
+
+    /// Produce sound data into destination from the decoded data. Never decodes or waits for the decoder thread: pads with silence if it fell behind. Return number of bytes produced. Called by SoundSource from the mixing thread.
+    unsigned GetData(signed char* dest, unsigned numBytes) override;
+
+    /// Decode until the buffer is full or the stream ends. Called from the decoder thread.
+    void Decode();
+
+    /// Return the decoded stream.
+    SoundStream* GetStream() const { return stream_; }
+
+    /// Return buffer capacity in bytes.
+    unsigned GetCapacity() const { return buffer_.GetCapacity(); }
+
+    /// Return number of decoded bytes not played yet.
+    unsigned GetNumBufferedBytes() const { return buffer_.GetNumReadable(); }
+
+    /// Return number of times the decoded data ran out before the stream ended.
+    unsigned GetNumUnderruns() const { return numUnderruns_.load(std::memory_order_relaxed); }
+
+private:
+    /// Read whole samples of decoded data, dropping data decoded before a seek. Return number of bytes read.
+    unsigned ReadDecoded(signed char* dest, unsigned numBytes);
+    /// Decode until the buffer is full or the stream ends without locking the decode mutex.
+    void DecodeLockless();
+
+    /// Decoded stream. Only accessed with the decode mutex held.
+    SharedPtr<SoundStream> stream_;
+    /// Decode mutex. Held while decoding and by Seek. The mixing thread never acquires it.
+    Mutex decodeMutex_;
+    /// Decoded data, written by the decoder thread and read by the mixing thread.
+    RingBuffer<signed char> buffer_;
+    /// Data produced by the stream before it is written to the buffer.
+    ea::vector<signed char> decodeBuffer_;
+    /// Total number of bytes written to the buffer. Only accessed with the decode mutex held.
+    unsigned long long numWritten_{};
+    /// Total number of bytes read from the buffer. Owned by the mixing thread.
+    unsigned long long numRead_{};
+    /// Bytes written before this position were decoded before a seek and are dropped.
+    std::atomic<unsigned long long> flushPosition_{};
+    /// Whether the stream has ended. Remaining buffered data is still played.
+    std::atomic<bool> finished_{};
+    /// Number of underruns.
+    std::atomic<unsigned> numUnderruns_{};
+};
+
+}
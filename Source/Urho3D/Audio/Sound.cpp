@@ -126,6 +126,7 @@ bool Sound::LoadOggVorbis(Deserializer& source)
     dataSize_ = dataSize;
     sixteenBit_ = true;
     compressed_ = true;
+    floatData_.reset();
 
     SetMemoryUse(dataSize);
     return true;
@@ -228,6 +229,7 @@ void Sound::SetSize(unsigned dataSize)
     data_.reset(new signed char[dataSize + IP_SAFETY]);
     dataSize_ = dataSize;
     compressed_ = false;
+    floatData_.reset();
     SetLooped(false);
 
     SetMemoryUse(dataSize + IP_SAFETY);
@@ -242,6 +244,59 @@ void Sound::SetData(const void* data, unsigned dataSize)
     memcpy(data_.get(), data, dataSize);
 }
 
+ea::shared_ptr<const SoundFloatData> Sound::GetFloatData()
+{
+    if (floatData_ || !data_ || compressed_)
+        return floatData_;
+
+    URHO3D_PROFILE("ConvertSoundToFloat");
+
+    const unsigned numChannels = stereo_ ? 2 : 1;
+    const unsigned numFrames = dataSize_ / GetSampleSize();
+
+    // Account for the copy and enforce the budget before building it. This sound has no copy to release yet,
+    // so the cache drops copies of other sounds instead of the one about to be made
+    SetMemoryUse(GetMemoryUse() + numFrames * numChannels * sizeof(float));
+    if (auto* cache = GetSubsystem<ResourceCache>())
+        cache->CheckMemoryBudget(GetType());
+
+    auto floatData = ea::make_shared<SoundFloatData>();
+    floatData->numChannels_ = numChannels;
+    floatData->numFrames_ = numFrames;
+    floatData->samples_.resize(numFrames * numChannels);
+
+    // Same scaling as used when mixing
+    for (unsigned channel = 0; channel < floatData->numChannels_; ++channel)
+    {
+        float* dest = &floatData->samples_[channel * floatData->numFrames_];
+        if (sixteenBit_)
+        {
+            const auto* src = reinterpret_cast<const short*>(data_.get()) + channel;
+            for (unsigned i = 0; i < floatData->numFrames_; ++i)
+                dest[i] = src[i * floatData->numChannels_] / 32767.0f;
+        }
+        else
+        {
+            const signed char* src = data_.get() + channel;
+            for (unsigned i = 0; i < floatData->numFrames_; ++i)
+                dest[i] = src[i * floatData->numChannels_] / 128.0f;
+        }
+    }
+
+    floatData_ = floatData;
+    return floatData;
+}
+
+bool Sound::ReleaseCachedData()
+{
+    if (!floatData_)
+        return false;
+
+    SetMemoryUse(GetMemoryUse() - floatData_->samples_.size() * sizeof(float));
+    floatData_.reset();
+    return true;
+}
+
 void Sound::SetFormat(unsigned frequency, bool sixteenBit, bool stereo)
 {
     frequency_ = frequency;
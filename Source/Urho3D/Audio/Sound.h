@@ -24,6 +24,8 @@
 
 
 #include <EASTL/shared_array.h>
+#include <EASTL/shared_ptr.h>
+#include <EASTL/vector.h>
 
 #include "../Resource/Resource.h"
 
@@ -32,6 +34,20 @@ namespace Urho3D
 
 class SoundStream;
 
+/// Deinterleaved float copy of uncompressed sound data, shared by everything playing the sound.
+struct SoundFloatData
+{
+    /// Return samples of a channel.
+    const float* GetChannel(unsigned channel) const { return &samples_[channel * numFrames_]; }
+
+    /// Number of sample frames.
+    unsigned numFrames_{};
+    /// Number of channels.
+    unsigned numChannels_{};
+    /// Samples in the range [-1, 1], numFrames_ consecutive samples per channel.
+    ea::vector<float> samples_;
+};
+
 /// %Sound resource.
 class URHO3D_API Sound : public ResourceWithMetadata
 {
@@ -69,6 +85,12 @@ public:
 
     /// Return a new instance of a decoder sound stream. Used by compressed sounds.
     SharedPtr<SoundStream> GetDecoderStream() const;
+    /// Return float copy of the sound data, building it on first use. Return null for compressed sounds. The copy counts towards memory use and may be released by the resource cache under memory pressure, users keep their reference alive.
+    ea::shared_ptr<const SoundFloatData> GetFloatData();
+    /// Return whether the float copy of the sound data exists.
+    bool HasFloatData() const { return floatData_ != nullptr; }
+    /// Release the float copy of the sound data.
+    bool ReleaseCachedData() override;
 
     /// Return shared sound data.
     ea::shared_array<signed char> GetData() const { return data_; }
@@ -143,6 +165,8 @@ private:
     bool compressed_;
     /// Compressed sound length.
     float compressedLength_;
+    /// Float copy of the sound data.
+    ea::shared_ptr<const SoundFloatData> floatData_;
 };
 
 }
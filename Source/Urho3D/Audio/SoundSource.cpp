@@ -24,6 +24,7 @@
 
 #include "../Audio/Audio.h"
 #include "../Audio/AudioEvents.h"
+#include "../Audio/AudioMixKernels.h"
 #include "../Audio/Sound.h"
 #include "../Audio/SoundSource.h"
 #include "../Audio/SoundStream.h"
@@ -46,6 +47,15 @@ static const int SOUND_SOURCE_LOW_FREQ_CHANNEL[] = {
     3, // SPK_SURROUND_5_1
 };
 
+/// Number of interleaved output channels
+static const unsigned SOUND_SOURCE_NUM_CHANNELS[] = {
+    6, // SPK_AUTO
+    1, // SPK_MONO
+    2, // SPK_STEREO
+    4, // SPK_QUADROPHONIC
+    6, // SPK_SURROUND_5_1
+};
+
 #define INC_POS_LOOPED() \
     pos += intAdd; \
     fractPos += fractAdd; \
@@ -104,6 +114,80 @@ static const int SOUND_SOURCE_LOW_FREQ_CHANNEL[] = {
 
 static const int STREAM_SAFETY_SAMPLES = 4;
 
+namespace
+{
+
+/// Read frames of 8-bit or 16-bit sound data as float, stepping like the fixed point mixer. Return number of frames read before a one-shot sound ended.
+template <class T, unsigned NumChannels, bool Interpolate>
+unsigned ReadSoundFrames(float* dest, const T*& pos, int& fractPos, const T* end, const T* repeat, bool looped, unsigned numFrames, int intAdd, int fractAdd)
+{
+    const float scale = sizeof(T) == 1 ? 1.0f / 128.0f : 1.0f / 32768.0f;
+    unsigned i = 0;
+
+    // Sounds at mix rate convert contiguous runs
+    if (intAdd == 1 && fractAdd == 0 && (!Interpolate || fractPos == 0))
+    {
+        while (i < numFrames)
+        {
+            const unsigned run = Min(numFrames - i, static_cast<unsigned>(end - pos) / NumChannels);
+            if (!run)
+                break;
+            ConvertSamples(dest + i * NumChannels, pos, run * NumChannels);
+            i += run;
+            pos += run * NumChannels;
+            if (pos >= end)
+            {
+                if (!looped)
+                    return i;
+                while (pos >= end)
+                    pos -= end - repeat;
+            }
+        }
+    }
+
+    for (; i < numFrames; ++i)
+    {
+        for (unsigned channel = 0; channel < NumChannels; ++channel)
+        {
+            float sample = pos[channel];
+            if (Interpolate)
+                sample += (pos[channel + NumChannels] - sample) * (fractPos * (1.0f / 65536.0f));
+            dest[i * NumChannels + channel] = sample * scale;
+        }
+
+        pos += intAdd * NumChannels;
+        fractPos += fractAdd;
+        if (fractPos > 65535)
+        {
+            fractPos &= 65535;
+            pos += NumChannels;
+        }
+        if (pos >= end)
+        {
+            if (!looped)
+                return i + 1;
+            while (pos >= end)
+                pos -= end - repeat;
+        }
+    }
+    return numFrames;
+}
+
+/// Read frames with the kernel matching channel count and interpolation.
+template <class T>
+unsigned ReadSoundFrames(float* dest, const T*& pos, int& fractPos, const T* end, const T* repeat, bool looped, unsigned numFrames, int intAdd, int fractAdd, bool stereo, bool interpolation)
+{
+    if (stereo)
+    {
+        return interpolation ? ReadSoundFrames<T, 2, true>(dest, pos, fractPos, end, repeat, looped, numFrames, intAdd, fractAdd)
+                             : ReadSoundFrames<T, 2, false>(dest, pos, fractPos, end, repeat, looped, numFrames, intAdd, fractAdd);
+    }
+    return interpolation ? ReadSoundFrames<T, 1, true>(dest, pos, fractPos, end, repeat, looped, numFrames, intAdd, fractAdd)
+                         : ReadSoundFrames<T, 1, false>(dest, pos, fractPos, end, repeat, looped, numFrames, intAdd, fractAdd);
+}
+
+}
+
 extern const char* autoRemoveModeNames[];
 
 SoundSource::SoundSource(Context* context) :
@@ -147,6 +231,7 @@ void SoundSource::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Panning", float, panning_, 0.0f, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Reach", float, reach_, 0.0f, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Low Frequency Effect", bool, lowFrequency_, false, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Priority", int, priority_, 0, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Is Playing", IsPlaying, SetPlayingAttr, bool, false, AM_DEFAULT);
     URHO3D_ENUM_ATTRIBUTE("Autoremove Mode", autoRemove_, autoRemoveModeNames, REMOVE_DISABLED, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Play Position", GetPositionAttr, SetPositionAttr, int, 0, AM_DEFAULT);
@@ -185,14 +270,19 @@ void SoundSource::Play(Sound* sound)
     if (frequency_ == 0.0f && sound)
         SetFrequency(sound->GetFrequency());
 
+    // Compressed sounds are decoded ahead of playback. Prime the decoder before locking, so the mixing thread does not wait for it
+    SharedPtr<SoundStream> decoderStream;
+    if (sound && sound->IsCompressed())
+        decoderStream = audio_->CreatePrefetchStream(sound->GetDecoderStream());
+
     // If sound source is currently playing, have to lock the audio mutex
     if (position_)
     {
         MutexLock lock(audio_->GetMutex());
-        PlayLockless(sound);
+        PlayLockless(sound, decoderStream);
     }
     else
-        PlayLockless(sound);
+        PlayLockless(sound, decoderStream);
 }
 
 void SoundSource::Play(Sound* sound, float frequency)
@@ -279,6 +369,11 @@ void SoundSource::SetGain(float gain)
     gain_ = Max(gain, 0.0f);
 }
 
+void SoundSource::SetPriority(int priority)
+{
+    priority_ = priority;
+}
+
 void SoundSource::SetAttenuation(float attenuation)
 {
     attenuation_ = Clamp(attenuation, 0.0f, 1.0f);
@@ -356,46 +451,56 @@ void SoundSource::Update(float timeStep)
     }
 }
 
-void SoundSource::Mix(int dest[], unsigned samples, int mixRate, SpeakerMode mode, bool interpolation)
+void SoundSource::Mix(float dest[], float scratch[], unsigned samples, int mixRate, SpeakerMode mode, bool interpolation)
 {
     if (!position_ || (!sound_ && !soundStream_) || (!IsEnabledEffective() && node_ != nullptr))
         return;
 
-    int streamFilledSize, outBytes;
+    int streamFilledSize = 0, outBytes = 0;
+    Sound* sound = BeginMix(samples, mixRate, streamFilledSize, outBytes);
+    if (!sound)
+        return;
 
-    if (soundStream_ && streamBuffer_)
+    // Fade out when becoming virtual and back in when becoming audible again
+    const float startVoiceGain = resetVoiceGain_ ? (virtual_ ? 0.0f : 1.0f) : voiceGain_;
+    const float fadeSamples = audio_ ? audio_->GetVoiceFadeTime() * mixRate : 0.0f;
+    const float voiceGainStep = fadeSamples > 0.0f ? samples / fadeSamples : 1.0f;
+    voiceGain_ = virtual_ ? Max(startVoiceGain - voiceGainStep, 0.0f) : Min(startVoiceGain + voiceGainStep, 1.0f);
+    resetVoiceGain_ = false;
+
+    // Resample to the scratch buffer, then pan into the output
+    float leftGains[MaxMixChannels]{};
+    float rightGains[MaxMixChannels]{};
+    if ((startVoiceGain > 0.0f || voiceGain_ > 0.0f) && CalculateChannelGains(sound, mode, leftGains, rightGains))
     {
-        int streamBufferSize = streamBuffer_->GetDataSize();
-        // Calculate how many bytes of stream sound data is needed
-        auto neededSize = (int)((float)samples * frequency_ / (float)mixRate);
-        // Add a little safety buffer. Subtract previous unused data
-        neededSize += STREAM_SAFETY_SAMPLES;
-        neededSize *= soundStream_->GetSampleSize();
-        neededSize -= unusedStreamSize_;
-        neededSize = Clamp(neededSize, 0, streamBufferSize - unusedStreamSize_);
-
-        // Always start play position at the beginning of the stream buffer
-        position_ = streamBuffer_->GetStart();
+        ReadFrames(sound, scratch, samples, mixRate, interpolation);
+        if (startVoiceGain < 1.0f || voiceGain_ < 1.0f)
+            ApplyGainRamp(scratch, samples, sound->IsStereo() ? 2 : 1, startVoiceGain, voiceGain_);
+        if (sound->IsStereo())
+            MixStereoFrames(dest, scratch, samples, SOUND_SOURCE_NUM_CHANNELS[mode], leftGains, rightGains);
+        else
+            MixMonoFrames(dest, scratch, samples, SOUND_SOURCE_NUM_CHANNELS[mode], leftGains);
+    }
+    else
+        MixZeroVolume(sound, samples, mixRate);
 
-        // Request new data from the stream
-        signed char* destination = streamBuffer_->GetStart() + unusedStreamSize_;
-        outBytes = neededSize ? soundStream_->GetData(destination, (unsigned)neededSize) : 0;
-        destination += outBytes;
-        // Zero-fill rest if stream did not produce enough data
-        if (outBytes < neededSize)
-            memset(destination, 0, (size_t)(neededSize - outBytes));
+    EndMix(samples, mixRate, streamFilledSize, outBytes);
+}
 
-        // Calculate amount of total bytes of data in stream buffer now, to know how much went unused after mixing
-        streamFilledSize = neededSize + unusedStreamSize_;
-    }
+void SoundSource::Mix(int dest[], unsigned samples, int mixRate, SpeakerMode mode, bool interpolation)
+{
+    if (!position_ || (!sound_ && !soundStream_) || (!IsEnabledEffective() && node_ != nullptr))
+        return;
 
-    // If streaming, play the stream buffer. Otherwise play the original sound
-    Sound* sound = soundStream_ ? streamBuffer_ : sound_;
+    int streamFilledSize = 0, outBytes = 0;
+    Sound* sound = BeginMix(samples, mixRate, streamFilledSize, outBytes);
     if (!sound)
         return;
 
     // Choose the correct mixing routine
-    if (!sound->IsStereo())
+    if (virtual_)
+        MixZeroVolume(sound, samples, mixRate);
+    else if (!sound->IsStereo())
     {
         if (interpolation)
         {
@@ -464,6 +569,43 @@ void SoundSource::Mix(int dest[], unsigned samples, int mixRate, SpeakerMode mod
         }
     }
 
+    EndMix(samples, mixRate, streamFilledSize, outBytes);
+}
+
+Sound* SoundSource::BeginMix(unsigned samples, int mixRate, int& streamFilledSize, int& outBytes)
+{
+    if (soundStream_ && streamBuffer_)
+    {
+        int streamBufferSize = streamBuffer_->GetDataSize();
+        // Calculate how many bytes of stream sound data is needed
+        auto neededSize = (int)((float)samples * frequency_ / (float)mixRate);
+        // Add a little safety buffer. Subtract previous unused data
+        neededSize += STREAM_SAFETY_SAMPLES;
+        neededSize *= soundStream_->GetSampleSize();
+        neededSize -= unusedStreamSize_;
+        neededSize = Clamp(neededSize, 0, streamBufferSize - unusedStreamSize_);
+
+        // Always start play position at the beginning of the stream buffer
+        position_ = streamBuffer_->GetStart();
+
+        // Request new data from the stream
+        signed char* destination = streamBuffer_->GetStart() + unusedStreamSize_;
+        outBytes = neededSize ? soundStream_->GetData(destination, (unsigned)neededSize) : 0;
+        destination += outBytes;
+        // Zero-fill rest if stream did not produce enough data
+        if (outBytes < neededSize)
+            memset(destination, 0, (size_t)(neededSize - outBytes));
+
+        // Calculate amount of total bytes of data in stream buffer now, to know how much went unused after mixing
+        streamFilledSize = neededSize + unusedStreamSize_;
+    }
+
+    // If streaming, play the stream buffer. Otherwise play the original sound
+    return soundStream_ ? streamBuffer_ : sound_;
+}
+
+void SoundSource::EndMix(unsigned samples, int mixRate, int streamFilledSize, int outBytes)
+{
     // Update the time position. In stream mode, copy unused data back to the beginning of the stream buffer
     if (soundStream_)
     {
@@ -535,7 +677,7 @@ int SoundSource::GetPositionAttr() const
         return 0;
 }
 
-void SoundSource::PlayLockless(Sound* sound)
+void SoundSource::PlayLockless(Sound* sound, const SharedPtr<SoundStream>& decoderStream)
 {
     // Reset the time position in any case
     timePosition_ = 0.0f;
@@ -555,13 +697,14 @@ void SoundSource::PlayLockless(Sound* sound)
                 position_ = start;
                 fractPosition_ = 0;
                 sendFinishedEvent_ = true;
+                resetVoiceGain_ = true;
                 return;
             }
         }
         else
         {
             // Compressed sound start
-            PlayLockless(sound->GetDecoderStream());
+            PlayLockless(decoderStream);
             sound_ = sound;
             return;
         }
@@ -593,6 +736,7 @@ void SoundSource::PlayLockless(const SharedPtr<SoundStream>& stream)
         position_ = streamBuffer_->GetStart();
         fractPosition_ = 0;
         sendFinishedEvent_ = true;
+        resetVoiceGain_ = true;
         return;
     }
 
@@ -629,6 +773,105 @@ void SoundSource::SetPlayPositionLockless(signed char* pos)
     timePosition_ = ((float)(int)(size_t)(pos - sound_->GetStart())) / (sound_->GetSampleSize() * sound_->GetFrequency());
 }
 
+bool SoundSource::CalculateChannelGains(Sound* sound, SpeakerMode mode, float leftGains[], float rightGains[]) const
+{
+    const float totalGain = masterGain_ * attenuation_ * gain_;
+    const unsigned numChannels = SOUND_SOURCE_NUM_CHANNELS[mode];
+
+    if (sound->IsStereo())
+    {
+        // Left and right input go to their own side, front and rear alike. Front-center and LFE are omitted
+        if (mode == SPK_MONO)
+            leftGains[0] = rightGains[0] = 0.5f * totalGain;
+        else
+        {
+            for (unsigned channel = 0; channel < numChannels; channel += 2)
+            {
+                if (mode == SPK_SURROUND_5_1 && channel == 2)
+                    continue;
+                leftGains[channel] = totalGain;
+                rightGains[channel + 1] = totalGain;
+            }
+        }
+    }
+    else if (lowFrequency_)
+    {
+        if (mode == SPK_SURROUND_5_1)
+            leftGains[SOUND_SOURCE_LOW_FREQ_CHANNEL[mode]] = totalGain;
+    }
+    else
+    {
+        const float left = (-panning_ + 1.0f) * totalGain;
+        const float right = (panning_ + 1.0f) * totalGain;
+        switch (mode)
+        {
+        case SPK_MONO:
+            leftGains[0] = totalGain;
+            break;
+        case SPK_STEREO:
+            leftGains[0] = left;
+            leftGains[1] = right;
+            break;
+        case SPK_QUADROPHONIC:
+        case SPK_SURROUND_5_1:
+        {
+            const unsigned rear = mode == SPK_SURROUND_5_1 ? 4 : 2;
+            leftGains[0] = left * (reach_ + 1.0f);
+            leftGains[1] = right * (reach_ + 1.0f);
+            leftGains[rear] = left * (-reach_ + 1.0f);
+            leftGains[rear + 1] = right * (-reach_ + 1.0f);
+            if (mode == SPK_SURROUND_5_1)
+                leftGains[2] = Lerp(leftGains[0], leftGains[1], 0.5f) * Clamp(reach_, 0.0f, 1.0f);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    for (unsigned channel = 0; channel < numChannels; ++channel)
+    {
+        if (leftGains[channel] != 0.0f || rightGains[channel] != 0.0f)
+            return true;
+    }
+    return false;
+}
+
+void SoundSource::ReadFrames(Sound* sound, float dest[], unsigned samples, int mixRate, bool interpolation)
+{
+    float add = frequency_ / (float)mixRate;
+    auto intAdd = (int)add;
+    auto fractAdd = (int)((add - floorf(add)) * 65536.0f);
+    int fractPos = fractPosition_;
+    const bool stereo = sound->IsStereo();
+    const bool looped = sound->IsLooped();
+
+    unsigned framesRead;
+    if (sound->IsSixteenBit())
+    {
+        auto* pos = (const short*)position_;
+        framesRead = ReadSoundFrames(dest, pos, fractPos, (const short*)sound->GetEnd(), (const short*)sound->GetRepeat(),
+            looped, samples, intAdd, fractAdd, stereo, interpolation);
+        position_ = (signed char*)pos;
+    }
+    else
+    {
+        auto* pos = (const signed char*)position_;
+        framesRead = ReadSoundFrames(dest, pos, fractPos, (const signed char*)sound->GetEnd(), (const signed char*)sound->GetRepeat(),
+            looped, samples, intAdd, fractAdd, stereo, interpolation);
+        position_ = (signed char*)pos;
+    }
+    fractPosition_ = fractPos;
+
+    // One-shot sound ended
+    if (framesRead < samples)
+    {
+        const unsigned numChannels = stereo ? 2 : 1;
+        memset(dest + framesRead * numChannels, 0, (samples - framesRead) * numChannels * sizeof(float));
+        position_ = nullptr;
+    }
+}
+
 void SoundSource::MixMonoToMono(Sound* sound, int dest[], unsigned samples, int mixRate, int channel, int channelCount)
 {
     float totalGain = masterGain_ * attenuation_ * gain_;
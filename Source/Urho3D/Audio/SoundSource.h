@@ -83,6 +83,11 @@ public:
     /// Set whether this is a LFE output.
     /// @property
     void SetLowFrequency(bool state);
+    /// Set voice priority. When Audio limits the number of mixed sources, higher priority sources keep their voice before more audible ones.
+    /// @property
+    void SetPriority(int priority);
+    /// Set whether the source is virtual: it keeps its play position but is not mixed. Called by Audio.
+    void SetVirtual(bool enable) { virtual_ = enable; }
     /// Set to remove either the sound source component or its owner node from the scene automatically on sound playback completion. Disabled by default.
     /// @property
     void SetAutoRemoveMode(AutoRemoveMode mode);
@@ -100,6 +105,9 @@ public:
     /// @property
     ea::string GetSoundType() const { return soundType_; }
 
+    /// Return sound type hash.
+    StringHash GetSoundTypeHash() const { return soundTypeHash_; }
+
     /// Return playback time position.
     /// @property
     float GetTimePosition() const { return timePosition_; }
@@ -128,6 +136,17 @@ public:
     /// @property
     bool IsLowFrequency() const { return lowFrequency_; }
 
+    /// Return voice priority.
+    /// @property
+    int GetPriority() const { return priority_; }
+
+    /// Return effective gain used to rank sources for voice limiting.
+    float GetAudibility() const { return masterGain_ * attenuation_ * gain_; }
+
+    /// Return whether the source is virtual.
+    /// @property
+    bool IsVirtual() const { return virtual_; }
+
     /// Return automatic removal mode on sound playback completion.
     /// @property
     AutoRemoveMode GetAutoRemoveMode() const { return autoRemove_; }
@@ -138,7 +157,9 @@ public:
 
     /// Update the sound source. Perform subclass specific operations. Called by Audio.
     virtual void Update(float timeStep);
-    /// Mix sound source output to a 32-bit clipping buffer. Called by Audio.
+    /// Mix sound source output to an interleaved float buffer. Scratch must hold two samples per frame. Called by Audio.
+    void Mix(float dest[], float scratch[], unsigned samples, int mixRate, SpeakerMode mode, bool interpolation);
+    /// Mix sound source output to a 32-bit fixed point clipping buffer. Superseded by the float mixer, kept for comparison.
     void Mix(int dest[], unsigned samples, int mixRate, SpeakerMode mode, bool interpolation);
     /// Update the effective master gain. Called internally and by Audio when the master gain changes.
     void UpdateMasterGain();
@@ -177,18 +198,28 @@ protected:
     bool sendFinishedEvent_;
     /// Whether this source should output to the LFE.
     bool lowFrequency_{ false };
+    /// Voice priority.
+    int priority_{};
     /// Automatic removal mode.
     AutoRemoveMode autoRemove_;
 
 private:
-    /// Play a sound without locking the audio mutex. Called internally.
-    void PlayLockless(Sound* sound);
+    /// Play a sound without locking the audio mutex. Compressed sounds play the given decoder stream. Called internally.
+    void PlayLockless(Sound* sound, const SharedPtr<SoundStream>& decoderStream);
     /// Play a sound stream without locking the audio mutex. Called internally.
     void PlayLockless(const SharedPtr<SoundStream>& stream);
     /// Stop sound without locking the audio mutex. Called internally.
     void StopLockless();
     /// Set new playback position without locking the audio mutex. Called internally.
     void SetPlayPositionLockless(signed char* pos);
+    /// Request stream data for the next mix. Return sound to play, or null if there is nothing to play.
+    Sound* BeginMix(unsigned samples, int mixRate, int& streamFilledSize, int& outBytes);
+    /// Update time position after mixing and keep stream data that went unused.
+    void EndMix(unsigned samples, int mixRate, int streamFilledSize, int outBytes);
+    /// Calculate gains of the left and right input channel for each output channel. Mono sounds only use left gains. Return false if silent.
+    bool CalculateChannelGains(Sound* sound, SpeakerMode mode, float leftGains[], float rightGains[]) const;
+    /// Read interleaved float frames at mix rate and advance playback position. One-shot sounds are padded with silence.
+    void ReadFrames(Sound* sound, float dest[], unsigned samples, int mixRate, bool interpolation);
     /// Mix mono sample to mono buffer.
     void MixMonoToMono(Sound* sound, int dest[], unsigned samples, int mixRate, int channel = 0, int channelCount = 1);
     /// Mix mono sample to stereo buffer.
@@ -232,6 +263,12 @@ private:
     SharedPtr<Sound> streamBuffer_;
     /// Unused stream bytes from previous frame.
     int unusedStreamSize_;
+    /// Virtual flag.
+    bool virtual_{};
+    /// Gain of the fade between audible and virtual.
+    float voiceGain_{1.0f};
+    /// Whether the fade gain should jump to its target, because playback just started.
+    bool resetVoiceGain_{true};
 };
 
 }
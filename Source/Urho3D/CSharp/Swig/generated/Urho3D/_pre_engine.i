@@ -64,6 +64,8 @@
 %ignore Urho3D::EP_SHADER_LOG_SOURCES;
 %constant const char* EpShaderPolicy = "ShaderPolicy";
 %ignore Urho3D::EP_SHADER_POLICY;
+%constant const char* EpSoundBlockSize = "SoundBlockSize";
+%ignore Urho3D::EP_SOUND_BLOCK_SIZE;
 %constant const char* EpSoundBuffer = "SoundBuffer";
 %ignore Urho3D::EP_SOUND_BUFFER;
 %constant const char* EpSoundInterpolation = "SoundInterpolation";
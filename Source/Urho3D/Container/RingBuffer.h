@@ -0,0 +1,142 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Math/MathDefs.h"
+
+#include <EASTL/span.h>
+#include <EASTL/utility.h>
+#include <EASTL/vector.h>
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+/// Lock-free single producer, single consumer ring buffer of trivially copyable elements.
+/// Capacity is rounded up to a power of two. Neither side ever blocks, partial reads and writes return the number of elements transferred.
+template <class T>
+class RingBuffer
+{
+public:
+    /// Construct empty without storage.
+    RingBuffer() = default;
+
+    /// Construct with capacity.
+    explicit RingBuffer(unsigned capacity) { Resize(capacity); }
+
+    /// Resize storage and discard contents. Not thread safe.
+    void Resize(unsigned capacity)
+    {
+        storage_.resize(capacity ? NextPowerOfTwo(capacity) : 0);
+        readPosition_.store(0, std::memory_order_relaxed);
+        writePosition_.store(0, std::memory_order_relaxed);
+    }
+
+    /// Write up to count elements. Return number of elements written. Called by the producer.
+    unsigned Write(const T* data, unsigned count)
+    {
+        const unsigned writePosition = writePosition_.load(std::memory_order_relaxed);
+        const unsigned readPosition = readPosition_.load(std::memory_order_acquire);
+        count = Min(count, GetCapacity() - (writePosition - readPosition));
+        if (!count)
+            return 0;
+
+        const unsigned offset = writePosition & GetMask();
+        const unsigned firstPart = Min(count, GetCapacity() - offset);
+        ea::copy(data, data + firstPart, storage_.begin() + offset);
+        ea::copy(data + firstPart, data + count, storage_.begin());
+
+        writePosition_.store(writePosition + count, std::memory_order_release);
+        return count;
+    }
+
+    /// Read up to count elements. Return number of elements read. Called by the consumer.
+    unsigned Read(T* data, unsigned count)
+    {
+        const unsigned readPosition = readPosition_.load(std::memory_order_relaxed);
+        const unsigned writePosition = writePosition_.load(std::memory_order_acquire);
+        count = Min(count, writePosition - readPosition);
+        if (!count)
+            return 0;
+
+        const unsigned offset = readPosition & GetMask();
+        const unsigned firstPart = Min(count, GetCapacity() - offset);
+        ea::copy(storage_.begin() + offset, storage_.begin() + offset + firstPart, data);
+        ea::copy(storage_.begin(), storage_.begin() + (count - firstPart), data + firstPart);
+
+        readPosition_.store(readPosition + count, std::memory_order_release);
+        return count;
+    }
+
+    /// Return up to count readable elements in place as two contiguous ranges, the second one is non-empty when the data wraps.
+    /// Elements stay valid until they are released with Discard. Called by the consumer.
+    ea::pair<ea::span<const T>, ea::span<const T>> Peek(unsigned count = M_MAX_UNSIGNED) const
+    {
+        const unsigned readPosition = readPosition_.load(std::memory_order_relaxed);
+        const unsigned writePosition = writePosition_.load(std::memory_order_acquire);
+        count = Min(count, writePosition - readPosition);
+        if (!count)
+            return {};
+
+        const unsigned offset = readPosition & GetMask();
+        const unsigned firstPart = Min(count, GetCapacity() - offset);
+        return {{storage_.data() + offset, firstPart}, {storage_.data(), count - firstPart}};
+    }
+
+    /// Drop up to count elements without copying them. Return number of elements dropped. Called by the consumer.
+    unsigned Discard(unsigned count)
+    {
+        const unsigned readPosition = readPosition_.load(std::memory_order_relaxed);
+        const unsigned writePosition = writePosition_.load(std::memory_order_acquire);
+        count = Min(count, writePosition - readPosition);
+        readPosition_.store(readPosition + count, std::memory_order_release);
+        return count;
+    }
+
+    /// Return number of elements available for reading.
+    unsigned GetNumReadable() const
+    {
+        return writePosition_.load(std::memory_order_acquire) - readPosition_.load(std::memory_order_acquire);
+    }
+
+    /// Return number of elements available for writing.
+    unsigned GetNumWritable() const { return GetCapacity() - GetNumReadable(); }
+
+    /// Return capacity.
+    unsigned GetCapacity() const { return storage_.size(); }
+
+private:
+    /// Return mask converting positions to indices.
+    unsigned GetMask() const { return GetCapacity() - 1; }
+
+    /// Element storage.
+    ea::vector<T> storage_;
+    /// Total number of elements read. Written by the consumer.
+    std::atomic<unsigned> readPosition_{};
+    /// Total number of elements written. Written by the producer.
+    std::atomic<unsigned> writePosition_{};
+};
+
+}
@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2017-2024 the rbfx project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <EASTL/array.h>
+
+#include <atomic>
+
+namespace Urho3D
+{
+
+/// Lock-free single producer, single consumer triple buffer.
+/// Producer fills the back value and publishes it, consumer always reads the most recently published value.
+/// Neither side ever blocks or waits for the other one. Values that were published but never read are dropped.
+template <class T>
+class TripleBuffer
+{
+public:
+    /// Construct default.
+    TripleBuffer() = default;
+
+    /// Construct with initial value for all slots.
+    explicit TripleBuffer(const T& value)
+    {
+        for (T& slot : slots_)
+            slot = value;
+    }
+
+    /// Return value to be filled by the producer.
+    T& GetBack() { return slots_[backIndex_]; }
+
+    /// Publish back value. Producer continues with a different back value, which may contain stale data.
+    void Publish()
+    {
+        const unsigned previous = middle_.exchange(backIndex_ | DirtyFlag, std::memory_order_acq_rel);
+        backIndex_ = previous & IndexMask;
+    }
+
+    /// Copy value into back value and publish it.
+    void Publish(const T& value)
+    {
+        GetBack() = value;
+        Publish();
+    }
+
+    /// Fetch latest published value if any. Return whether the front value has changed. Called by the consumer.
+    bool Update()
+    {
+        if (!(middle_.load(std::memory_order_relaxed) & DirtyFlag))
+            return false;
+
+        const unsigned previous = middle_.exchange(frontIndex_, std::memory_order_acq_rel);
+        frontIndex_ = previous & IndexMask;
+        return true;
+    }
+
+    /// Return value last fetched by the consumer.
+    const T& GetFront() const { return slots_[frontIndex_]; }
+    /// Return value last fetched by the consumer.
+    T& GetFront() { return slots_[frontIndex_]; }
+
+    /// Fetch latest published value and return it. Called by the consumer.
+    const T& Read()
+    {
+        Update();
+        return GetFront();
+    }
+
+    /// Return whether there is a published value not yet fetched by the consumer.
+    bool HasPending() const { return (middle_.load(std::memory_order_relaxed) & DirtyFlag) != 0; }
+
+private:
+    static constexpr unsigned IndexMask = 0x3;
+    static constexpr unsigned DirtyFlag = 0x4;
+
+    /// Slots. Each slot is owned by exactly one of producer, consumer and the shared middle at any time.
+    ea::array<T, 3> slots_{};
+    /// Producer slot index.
+    unsigned backIndex_{0};
+    /// Shared slot index and flag whether it contains unread data.
+    std::atomic<unsigned> middle_{1};
+    /// Consumer slot index.
+    unsigned frontIndex_{2};
+};
+
+}
@@ -526,7 +526,8 @@ bool Engine::Initialize(const StringVariantMap& applicationParameters, const Str
 #ifdef URHO3D_STEAM_AUDIO
             GetSubsystem<SteamAudio>()->SetMode(
                 GetParameter(EP_SOUND_MIX_RATE).GetInt(),
-                (SpeakerMode)GetParameter(EP_SOUND_MODE).GetInt()
+                (SpeakerMode)GetParameter(EP_SOUND_MODE).GetInt(),
+                GetParameter(EP_SOUND_BLOCK_SIZE).GetUInt()
             );
 #else
             GetSubsystem<Audio>()->SetMode(
@@ -535,6 +536,10 @@ bool Engine::Initialize(const StringVariantMap& applicationParameters, const Str
                 (SpeakerMode)GetParameter(EP_SOUND_MODE).GetInt(),
                 GetParameter(EP_SOUND_INTERPOLATION).GetBool()
             );
+
+            const ea::string& busGraphName = GetParameter(EP_SOUND_BUS_GRAPH).GetString();
+            if (!busGraphName.empty())
+                GetSubsystem<Audio>()->SetBusGraph(cache->GetResource<AudioBusGraph>(busGraphName));
 #endif
         }
 
@@ -1163,6 +1168,7 @@ void Engine::DefineParameters(CLI::App& commandLine, StringVariantMap& enginePar
     addOptionInt("--hz", EP_REFRESH_RATE, "Use custom refresh rate");
     addOptionInt("-m,--multisample", EP_MULTI_SAMPLE, "Multisampling samples");
     addOptionInt("-b,--sound-buffer", EP_SOUND_BUFFER, "Sound buffer size");
+    addOptionInt("--sound-block-size", EP_SOUND_BLOCK_SIZE, "Sound block size in sample frames");
     addOptionInt("-r,--mix-rate", EP_SOUND_MIX_RATE, "Sound mixing rate");
     addOptionString("--pp,--prefix-paths", EP_RESOURCE_PREFIX_PATHS, "Resource prefix paths")->envname("URHO3D_PREFIX_PATH")->type_name("path1;path2;...");
     addOptionString("--pr,--resource-paths", EP_RESOURCE_PATHS, "Resource paths")->type_name("path1;path2;...");
@@ -1294,7 +1300,9 @@ void Engine::PopulateDefaultParameters()
     engineParameters_->DefineVariable(EP_SHADER_POLICY).SetOptional<int>();
     engineParameters_->DefineVariable(EP_SHADER_LOG_SOURCES, false);
     engineParameters_->DefineVariable(EP_SOUND, true);
+    engineParameters_->DefineVariable(EP_SOUND_BLOCK_SIZE, 1024);
     engineParameters_->DefineVariable(EP_SOUND_BUFFER, 100);
+    engineParameters_->DefineVariable(EP_SOUND_BUS_GRAPH, EMPTY_STRING);
     engineParameters_->DefineVariable(EP_SOUND_INTERPOLATION, true);
     engineParameters_->DefineVariable(EP_SOUND_MIX_RATE, 44100);
     engineParameters_->DefineVariable(EP_SOUND_MODE, SpeakerMode::SPK_AUTO);
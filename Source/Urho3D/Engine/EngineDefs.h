@@ -66,7 +66,9 @@ URHO3D_GLOBAL_CONSTANT(ConstString EP_SAVE_SHADER_CACHE{"SaveShaderCache"});
 URHO3D_GLOBAL_CONSTANT(ConstString EP_SHADER_CACHE_DIR{"ShaderCacheDir"});
 URHO3D_GLOBAL_CONSTANT(ConstString EP_SHADER_LOG_SOURCES{"ShaderLogSource"});
 URHO3D_GLOBAL_CONSTANT(ConstString EP_SHADER_POLICY{"ShaderPolicy"});
+URHO3D_GLOBAL_CONSTANT(ConstString EP_SOUND_BLOCK_SIZE{"SoundBlockSize"});
 URHO3D_GLOBAL_CONSTANT(ConstString EP_SOUND_BUFFER{"SoundBuffer"});
+URHO3D_GLOBAL_CONSTANT(ConstString EP_SOUND_BUS_GRAPH{"SoundBusGraph"});
 URHO3D_GLOBAL_CONSTANT(ConstString EP_SOUND_INTERPOLATION{"SoundInterpolation"});
 URHO3D_GLOBAL_CONSTANT(ConstString EP_SOUND_MIX_RATE{"SoundMixRate"});
 URHO3D_GLOBAL_CONSTANT(ConstString EP_SOUND_MODE{"SoundMode"});
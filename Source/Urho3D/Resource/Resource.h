@@ -112,6 +112,8 @@ public:
     void SetName(const ea::string& name);
     /// Set memory use in bytes, possibly approximate.
     void SetMemoryUse(unsigned size);
+    /// Release optional data that can be rebuilt on demand. Called by the resource cache when the memory budget is exceeded. Return true if memory use was reduced.
+    virtual bool ReleaseCachedData() { return false; }
     /// Reset last used timer.
     void ResetUseTimer();
     /// Set the asynchronous loading state. Called by ResourceCache. Resources in the middle of asynchronous loading are not normally returned to user.
@@ -843,7 +843,17 @@ void ResourceCache::UpdateResourceGroup(StringHash type)
 
         i->second.memoryUse_ = totalSize;
 
-        // If memory budget defined and is exceeded, remove the oldest resource and loop again
+        // If memory budget defined and is exceeded, release data that can be rebuilt on demand first
+        if (i->second.memoryBudget_ && i->second.memoryUse_ > i->second.memoryBudget_)
+        {
+            bool releasedCachedData = false;
+            for (auto j = i->second.resources_.begin(); j != i->second.resources_.end() && !releasedCachedData; ++j)
+                releasedCachedData = j->second->ReleaseCachedData();
+            if (releasedCachedData)
+                continue;
+        }
+
+        // If memory budget is still exceeded, remove the oldest resource and loop again
         // (resources in use always return a zero timer and can not be removed)
         if (i->second.memoryBudget_ && i->second.memoryUse_ > i->second.memoryBudget_ &&
             oldestResource != i->second.resources_.end())
@@ -113,6 +113,8 @@ public:
     /// Set memory budget for a specific resource type, default 0 is unlimited.
     /// @property
     void SetMemoryBudget(StringHash type, unsigned long long budget);
+    /// Recalculate memory use of a resource type and enforce its budget. Call after memory use of a cached resource changed.
+    void CheckMemoryBudget(StringHash type) { UpdateResourceGroup(type); }
     /// Enable or disable returning resources that failed to load. Default false. This may be useful in editing to not lose resource ref attributes.
     /// @property
     void SetReturnFailedResources(bool enable) { returnFailedResources_ = enable; }
@@ -23,30 +23,185 @@
 #include "../Precompiled.h"
 
 #include "../SteamAudio/SteamAudio.h"
+#include "../SteamAudio/SteamAudioEvents.h"
 #include "../SteamAudio/SteamSoundSource.h"
 #include "../SteamAudio/SteamSoundMesh.h"
 #include "../SteamAudio/SteamSoundListener.h"
+#include "../SteamAudio/SteamAudioProbeVolume.h"
 #include "../Audio/Sound.h"
+#include "../Audio/SoundStream.h"
+#include "../Core/Profiler.h"
+#include "../Core/StringUtils.h"
+#include "../Core/Thread.h"
+#include "../Core/Timer.h"
 #include "../IO/Log.h"
+#include "../IO/MemoryBuffer.h"
+#include "../IO/Serializer.h"
+#include "../IO/VectorBuffer.h"
+#include "../IO/VirtualFileSystem.h"
+#include "../Resource/BinaryFile.h"
 #include "../Scene/Node.h"
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 
 #include <SDL.h>
 
+#include <EASTL/sort.h>
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <thread>
+
 namespace Urho3D
 {
 
+namespace
+{
+
+/// Whether the current thread is inside SteamAudio::MixOutput.
+thread_local bool insideMixOutput = false;
+/// Number of allocations Steam Audio performed while mixing.
+std::atomic<unsigned> numMixAllocations{0};
+
+/// Mark the current thread as mixing for the lifetime of the object.
+struct MixOutputScope
+{
+    MixOutputScope() { insideMixOutput = true; }
+    ~MixOutputScope() { insideMixOutput = false; }
+};
+
+void* IPLCALL PhononAllocate(IPLsize size, IPLsize alignment)
+{
+    if (insideMixOutput)
+        numMixAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    // Over-allocate and store the original pointer right before the aligned block
+    alignment = ea::max<IPLsize>(alignment, sizeof(void*));
+    void* base = malloc(size + alignment + sizeof(void*));
+    if (!base)
+        return nullptr;
+
+    auto address = reinterpret_cast<uintptr_t>(base) + sizeof(void*);
+    address = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    reinterpret_cast<void**>(address)[-1] = base;
+    return reinterpret_cast<void*>(address);
+}
+
+void IPLCALL PhononFree(void* memoryBlock)
+{
+    if (memoryBlock)
+        free(reinterpret_cast<void**>(memoryBlock)[-1]);
+}
+
+/// Convert reflection algorithm to Phonon. Default maps to convolution.
+IPLReflectionEffectType ToPhononReflectionType(ReflectionEffectType type)
+{
+    switch (type) {
+    case RET_PARAMETRIC: return IPL_REFLECTIONEFFECTTYPE_PARAMETRIC;
+    case RET_HYBRID: return IPL_REFLECTIONEFFECTTYPE_HYBRID;
+    default: return IPL_REFLECTIONEFFECTTYPE_CONVOLUTION;
+    }
+}
+
+/// Simplify a triangle mesh by merging vertices sharing a grid cell and dropping collapsed triangles.
+void ClusterVertices(ea::vector<IPLVector3>& vertices, ea::vector<IPLTriangle>& triangles, ea::vector<IPLint32>& materialIndices, float cellSize)
+{
+    // Replace vertices of each cell with their average
+    ea::unordered_map<IntVector3, unsigned> cells;
+    ea::vector<unsigned> remap(vertices.size());
+    ea::vector<Vector3> sums;
+    ea::vector<unsigned> counts;
+    for (unsigned i = 0; i < vertices.size(); ++i) {
+        const Vector3 position{vertices[i].x, vertices[i].y, vertices[i].z};
+        const IntVector3 cell = VectorFloorToInt(position/cellSize);
+        const auto insertion = cells.emplace(cell, sums.size());
+        if (insertion.second) {
+            sums.push_back(Vector3::ZERO);
+            counts.push_back(0);
+        }
+        const unsigned cluster = insertion.first->second;
+        sums[cluster] += position;
+        ++counts[cluster];
+        remap[i] = cluster;
+    }
+
+    vertices.resize(sums.size());
+    for (unsigned i = 0; i < sums.size(); ++i) {
+        const Vector3 average = sums[i]/static_cast<float>(counts[i]);
+        vertices[i] = {average.x_, average.y_, average.z_};
+    }
+
+    // Keep triangles that still span three clusters
+    unsigned numTriangles = 0;
+    for (unsigned i = 0; i < triangles.size(); ++i) {
+        const int a = remap[triangles[i].indices[0]];
+        const int b = remap[triangles[i].indices[1]];
+        const int c = remap[triangles[i].indices[2]];
+        if (a == b || b == c || a == c)
+            continue;
+        triangles[numTriangles] = {a, b, c};
+        materialIndices[numTriangles] = materialIndices[i];
+        ++numTriangles;
+    }
+    triangles.resize(numTriangles);
+    materialIndices.resize(numTriangles);
+}
+
+}
+
 void SDLSteamAudioCallback(void* userdata, Uint8* stream, int);
 
+class SteamAudio::SimulationThread : public Thread
+{
+public:
+    explicit SimulationThread(SteamAudio* audio) : Thread("SteamAudio Simulation"), audio_(audio) {}
+
+    void ThreadFunction() override
+    {
+        URHO3D_PROFILE_THREAD(name_.c_str());
+        while (shouldRun_) {
+            // Wake up regularly so queued tasks are not delayed too much
+            const float timeToNextSimulation = audio_->RunSimulation();
+            Time::Sleep(static_cast<unsigned>(Clamp(timeToNextSimulation*1000.0f, 1.0f, 10.0f)));
+        }
+    }
+
+private:
+    SteamAudio* audio_;
+};
+
+class SteamAudio::DecoderThread : public Thread
+{
+public:
+    explicit DecoderThread(SteamAudio* audio) : Thread("SteamAudio Decoder"), audio_(audio) {}
+
+    void ThreadFunction() override
+    {
+        URHO3D_PROFILE_THREAD(name_.c_str());
+        while (shouldRun_) {
+            // Buffers hold far more than one block, polling keeps the audio thread free of wake-ups
+            audio_->DecodeStreams();
+            Time::Sleep(5);
+        }
+    }
+
+private:
+    SteamAudio* audio_;
+};
+
 SteamAudio::SteamAudio(Context* context) :
-    Object(context), audioBufferPool_(nullptr)
+    Object(context)
 {
     context_->RequireSDL(SDL_INIT_AUDIO);
 
     // Set the master to the default value
     masterGain_ = 1.0f;
 
+    // Keep static meshes next to other caches
+    staticMeshCacheDir_ = FileIdentifier::FromUri("conf://SteamAudioCache");
+
     // Register Audio library object factories
     RegisterSteamAudioLibrary(context_);
 
@@ -59,7 +214,7 @@ SteamAudio::~SteamAudio()
     context_->ReleaseSDL();
 }
 
-bool SteamAudio::SetMode(int mixRate, SpeakerMode mode)
+bool SteamAudio::SetMode(int mixRate, SpeakerMode mode, unsigned frameSize)
 {
     // Clean up first
     Release();
@@ -67,6 +222,14 @@ bool SteamAudio::SetMode(int mixRate, SpeakerMode mode)
     // Reset master gain
     masterGain_ = 1.0f;
 
+    // The null device mixes on demand, everything that depends on timing or thread scheduling runs inline
+    offline_ = outputDevice_ == ODT_NULL;
+    offlineTime_ = {};
+    // Schedules may refer to the clock of the previous mode, the simulation thread is stopped by now
+    nextDirectSimulation_ = {};
+    nextReflectionSimulation_ = {};
+    nextSceneCommit_ = {};
+
     // Convert speaker mode to channel count
     switch (mode) {
     case SPK_MONO: channelCount_ = 1; break;
@@ -79,17 +242,23 @@ bool SteamAudio::SetMode(int mixRate, SpeakerMode mode)
     // Create context
     IPLContextSettings contextSettings {
         .version = STEAMAUDIO_VERSION,
+        .allocateCallback = PhononAllocate,
+        .freeCallback = PhononFree,
         #ifndef NDEBUG
         .flags = IPL_CONTEXTFLAGS_VALIDATION
         #endif
     };
     iplContextCreate(&contextSettings, &phononContext_);
 
-    // Typical audio settings...
+    // Phonon effects and SDL work best with power of two blocks
+    const unsigned blockSize = Clamp(NextPowerOfTwo(frameSize), 64u, 4096u);
+    if (blockSize != frameSize)
+        URHO3D_LOGWARNING("Steam Audio block size {} is not supported, using {}", frameSize, blockSize);
     audioSettings_ = IPLAudioSettings {
         .samplingRate = mixRate,
-        .frameSize = 1024
+        .frameSize = static_cast<IPLint32>(blockSize)
     };
+    blockDuration_ = 1000.0f*blockSize/mixRate;
 
     // Create single frame buffer
     // This buffer one individual audio frame per channel at a time.
@@ -103,30 +272,40 @@ bool SteamAudio::SetMode(int mixRate, SpeakerMode mode)
     };
     iplHRTFCreate(phononContext_, &audioSettings_, &hrtfSettings, &hrtf_);
 
-    // Create the scene
-    IPLSceneSettings sceneSettings {
+    // Create the scene, with Embree if requested and available
+    sceneSettings_ = IPLSceneSettings {
         .type = IPL_SCENETYPE_DEFAULT
     };
-    iplSceneCreate(phononContext_, &sceneSettings, &scene_);
+    if (rayTracer_ == RTT_EMBREE) {
+        IPLEmbreeDeviceSettings embreeDeviceSettings {};
+        if (iplEmbreeDeviceCreate(phononContext_, &embreeDeviceSettings, &embreeDevice_) == IPL_STATUS_SUCCESS) {
+            sceneSettings_.type = IPL_SCENETYPE_EMBREE;
+            sceneSettings_.embreeDevice = embreeDevice_;
+        } else {
+            URHO3D_LOGWARNING("Steam Audio was built without Embree, using the built-in ray tracer");
+        }
+    }
+    iplSceneCreate(phononContext_, &sceneSettings_, &scene_);
 
-    // Create the simulator
-    IPLSimulationSettings simulationSettings {
+    // Create the simulator, it is recreated with more room once it runs out of sources
+    simulationSettings_ = IPLSimulationSettings {
         .flags = static_cast<IPLSimulationFlags>(IPL_SIMULATIONFLAGS_DIRECT | IPL_SIMULATIONFLAGS_REFLECTIONS),
-        .sceneType = IPL_SCENETYPE_DEFAULT,
-        .reflectionType = IPL_REFLECTIONEFFECTTYPE_CONVOLUTION,
+        .sceneType = sceneSettings_.type,
+        .reflectionType = ToPhononReflectionType(reflectionEffectType_),
         .maxNumOcclusionSamples = 12,
         .maxNumRays = 16384,
         .numDiffuseSamples = 8, //TODO: No idea about this, find a good default value
         .maxDuration = 4.0f,
         .maxOrder = 8,
-        .maxNumSources = 16, //TODO: This should dynamically increase if limit is reached
-        .numThreads = 3,
+        .maxNumSources = 16,
+        .numThreads = offline_ ? 1 : 3,
         .numVisSamples = 8, //TODO: No idea about this, find a good default value
         .samplingRate = audioSettings_.samplingRate,
         .frameSize = audioSettings_.frameSize
     };
-    iplSimulatorCreate(phononContext_, &simulationSettings, &simulator_);
+    iplSimulatorCreate(phononContext_, &simulationSettings_, &simulator_);
     iplSimulatorSetScene(simulator_, scene_);
+    simulatorCapacity_.store(simulationSettings_.maxNumSources, std::memory_order_relaxed);
     MarkSimulatorDirty();
 
     // Allocate an output buffer
@@ -134,14 +313,22 @@ bool SteamAudio::SetMode(int mixRate, SpeakerMode mode)
     phononFrameBuffer_ = IPLAudioBuffer {};
     iplAudioBufferAllocate(phononContext_, channelCount_, audioSettings_.frameSize, &phononFrameBuffer_);
 
-    // Create the buffer pool
-    audioBufferPool_ = ea::make_unique<SteamAudioBufferPool>(this);
+    // Create the mix workers and the shared reflection bus if used
+    mixWorkers_ = offline_ ? ea::make_unique<SteamAudioMixWorkers>(this, 0, -1.0f) : ea::make_unique<SteamAudioMixWorkers>(this, numMixWorkers_, mixDeadline_);
+    if (reflectionMixMode_ == RMM_SHARED_BUS)
+        reflectionBus_ = ea::make_unique<SteamAudioReflectionBus>(this, reflectionBusOrder_, mixWorkers_->GetNumLanes());
+
+    if (offline_) {
+        // Update once
+        Update(0.0f);
+        return true;
+    }
 
     // Set up SDL
     SDL_AudioSpec spec {
         .freq = audioSettings_.samplingRate,
         .format = AUDIO_F32,
-        .channels = 2,
+        .channels = static_cast<Uint8>(channelCount_),
         .samples = static_cast<unsigned short>(audioSettings_.frameSize),
         .callback = *SDLSteamAudioCallback,
         .userdata = this
@@ -152,9 +339,19 @@ bool SteamAudio::SetMode(int mixRate, SpeakerMode mode)
         URHO3D_LOGERROR(ea::string("Failed to open SDL2 audio: ")+SDL_GetError());
         return false;
     }
+    deviceOpen_ = true;
+
+    // Start simulation thread
+    if (simulationThreaded_) {
+        simulationThread_ = ea::make_unique<SimulationThread>(this);
+        simulationThread_->Run();
+    }
+
+    // Start decoder thread
+    decoderThread_ = ea::make_unique<DecoderThread>(this);
+    decoderThread_->Run();
 
     // Start playing audio
-    audioMutex_.Release();
     Play();
 
     // Update once
@@ -165,7 +362,7 @@ bool SteamAudio::SetMode(int mixRate, SpeakerMode mode)
 
 bool SteamAudio::RefreshMode()
 {
-    return SetMode(audioSettings_.samplingRate, GetSpeakerMode());
+    return SetMode(audioSettings_.samplingRate, GetSpeakerMode(), audioSettings_.frameSize);
 }
 
 void SteamAudio::Close()
@@ -175,17 +372,14 @@ void SteamAudio::Close()
 
 void SteamAudio::Update(float timeStep)
 {
-    if (sceneDirty_) {
-        iplSceneCommit(scene_);
-        iplSceneSaveOBJ(scene_, "scene-base.obj");
-        sceneDirty_ = false;
-    }
-    if (simulatorDirty_) {
-        iplSimulatorCommit(simulator_);
-        simulatorDirty_ = false;
+    // Report allocations on the audio thread, steady-state mixing is expected to be allocation-free
+    const unsigned mixAllocations = GetNumMixAllocations();
+    if (mixAllocations != numReportedMixAllocations_) {
+        URHO3D_LOGWARNING("Steam Audio performed {} heap allocation(s) while mixing", mixAllocations - numReportedMixAllocations_);
+        numReportedMixAllocations_ = mixAllocations;
     }
 
-    // Update listener coordinates in simulator
+    // Update listener coordinates
     if (listener_) {
         const auto lUp = listener_->GetNode()->GetWorldUp();
         const auto lDir = listener_->GetNode()->GetWorldDirection();
@@ -196,29 +390,98 @@ void SteamAudio::Update(float timeStep)
             .up = {lUp.x_, lUp.y_, lUp.z_},
             .ahead = {lDir.x_, lDir.y_, lDir.z_},
             .origin = {lPos.x_, lPos.y_, lPos.z_}
-        },
-        iplSimulatorSetSharedInputs(simulator_, SimulationFlags(), &sharedInputs_);
-
-        // Run simulations
-        {
-            MutexLock Lock(simulatorMutex_);
-            iplSimulatorRunDirect(simulator_);
-        }
-        {
-            MutexLock Lock(simulatorMutex_);
-            iplSimulatorRunReflections(simulator_);
-        }
+        };
     }
+
+    // Merge static meshes after changes
+    if (staticBatchDirty_ && phononContext_)
+        RebuildStaticBatch();
+
+    // Hand listener over to the simulation
+    SimulationState& simulationState = simulationState_.GetBack();
+    simulationState.sharedInputs_ = sharedInputs_;
+    simulationState.hasListener_ = listener_ != nullptr;
+    simulationState.simulateReflections_ = simulateReflections_;
+    simulationState_.Publish();
+
+    // Simulate right here if there is no simulation thread
+    if (!simulationThread_ && simulator_)
+        RunSimulation();
+
+    // Hand source parameters over to the audio thread
+    MutexLock Lock(audioMutex_);
+    UnlockedUpdateVoices();
+    for (auto source : soundSources_)
+        source->PublishParameters();
+    UnlockedPublishMixState();
 }
 
 void SteamAudio::Play()
 {
-    SDL_PauseAudio(0);
+    if (deviceOpen_)
+        SDL_PauseAudio(0);
 }
 
 void SteamAudio::Stop()
 {
-    SDL_PauseAudio(1);
+    if (deviceOpen_)
+        SDL_PauseAudio(1);
+}
+
+bool SteamAudio::RenderOffline(unsigned numBlocks, ea::vector<float>& dest)
+{
+    if (!offline_ || !phononContext_) {
+        URHO3D_LOGERROR("Offline rendering requires SetMode() with the null output device");
+        return false;
+    }
+
+    using namespace std::chrono;
+    using namespace SteamAudioUpdate;
+
+    const unsigned blockSize = audioSettings_.frameSize*channelCount_;
+    const float blockDuration = static_cast<float>(audioSettings_.frameSize)/audioSettings_.samplingRate;
+    const auto blockInterval = duration_cast<steady_clock::duration>(duration<double>(blockDuration));
+
+    VariantMap& eventData = GetEventDataMap();
+    for (unsigned block = 0; block < numBlocks; ++block) {
+        // Let the subsystem and audio components update as if a frame of one block passed. Nothing else in the engine does
+        Update(blockDuration);
+        eventData[P_TIMESTEP] = blockDuration;
+        SendEvent(E_STEAMAUDIOUPDATE, eventData);
+        DecodeStreams();
+
+        const unsigned offset = dest.size();
+        dest.resize(offset + blockSize);
+        MixOutput(dest.data() + offset);
+        offlineTime_ += blockInterval;
+    }
+    return true;
+}
+
+bool SteamAudio::RenderOfflineWav(unsigned numBlocks, Serializer& dest)
+{
+    ea::vector<float> samples;
+    if (!RenderOffline(numBlocks, samples))
+        return false;
+
+    // Write 16-bit PCM, which Sound can load back
+    const unsigned dataLength = samples.size()*sizeof(short);
+    bool success = true;
+    success &= dest.Write("RIFF", 4) == 4;
+    success &= dest.WriteUInt(36 + dataLength);
+    success &= dest.Write("WAVEfmt ", 8) == 8;
+    success &= dest.WriteUInt(16);
+    success &= dest.WriteUShort(1);
+    success &= dest.WriteUShort(channelCount_);
+    success &= dest.WriteUInt(audioSettings_.samplingRate);
+    success &= dest.WriteUInt(audioSettings_.samplingRate*channelCount_*sizeof(short));
+    success &= dest.WriteUShort(channelCount_*sizeof(short));
+    success &= dest.WriteUShort(16);
+    success &= dest.Write("data", 4) == 4;
+    success &= dest.WriteUInt(dataLength);
+    for (float sample : samples)
+        success &= dest.WriteShort(static_cast<short>(Clamp(sample, -1.0f, 1.0f)*32767.0f));
+    return success;
 }
 
 void SteamAudio::SetMasterGain(float gain)
@@ -228,7 +491,6 @@ void SteamAudio::SetMasterGain(float gain)
 
 void SteamAudio::SetListener(SteamSoundListener *listener)
 {
-    MutexLock Lock(audioMutex_);
     listener_ = listener;
 }
 
@@ -242,14 +504,570 @@ void SteamAudio::SetImpulseResponseDuration(float duration)
     sharedInputs_.duration = duration;
 }
 
-bool SteamAudio::GetSimulatorOutputs(IPLSource source, IPLSimulationOutputs& outputs) noexcept
+IPLReflectionEffectType SteamAudio::ResolveReflectionEffectType(ReflectionEffectType requested) const
 {
-    if (!simulatorMutex_.TryAcquire())
-        return false;
-    outputs = IPLSimulationOutputs {};
-    iplSourceGetOutputs(source, SimulationFlags(), &outputs);
-    simulatorMutex_.Release();
-    return true;
+    // Only the hybrid simulator outputs both impulse responses and reverb times
+    if (requested == RET_DEFAULT || simulationSettings_.reflectionType != IPL_REFLECTIONEFFECTTYPE_HYBRID)
+        return simulationSettings_.reflectionType;
+    return ToPhononReflectionType(requested);
+}
+
+void SteamAudio::SetReflectionMixMode(ReflectionMixMode mode, unsigned busAmbisonicsOrder)
+{
+    busAmbisonicsOrder = Clamp(busAmbisonicsOrder, 1u, 6u);
+    if (mode == reflectionMixMode_ && busAmbisonicsOrder == reflectionBusOrder_)
+        return;
+
+    reflectionMixMode_ = mode;
+    reflectionBusOrder_ = busAmbisonicsOrder;
+    RecreateMixResources();
+}
+
+void SteamAudio::SetMixWorkers(unsigned numWorkers, float deadline)
+{
+    deadline = Clamp(deadline, 0.0f, 1.0f);
+    if (numWorkers == numMixWorkers_ && deadline == mixDeadline_)
+        return;
+
+    numMixWorkers_ = numWorkers;
+    mixDeadline_ = deadline;
+    RecreateMixResources();
+}
+
+unsigned SteamAudio::GetNumSkippedSourceBlocks() const
+{
+    return mixWorkers_ ? mixWorkers_->GetNumSkippedSourceBlocks() : 0;
+}
+
+SteamAudioStats SteamAudio::GetStats() const
+{
+    SteamAudioStats stats;
+    stats.blockDuration_ = blockDuration_;
+    stats.lastMixTime_ = lastMixTime_.load(std::memory_order_relaxed);
+    stats.maxMixTime_ = maxMixTime_.load(std::memory_order_relaxed);
+    stats.numBlocks_ = numMixedBlocks_.load(std::memory_order_relaxed);
+    stats.numLateBlocks_ = numLateBlocks_.load(std::memory_order_relaxed);
+    stats.numSilentBlocks_ = numSilentBlocks_.load(std::memory_order_relaxed);
+    stats.numSkippedSourceBlocks_ = GetNumSkippedSourceBlocks();
+    stats.numDroppedWorkerBlocks_ = mixWorkers_ ? mixWorkers_->GetNumDroppedLaneBlocks() : 0;
+    stats.numSimulationLockContentions_ = numSimulationLockContentions_.load(std::memory_order_relaxed);
+    stats.numActiveSources_ = numActiveSources_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SteamAudio::ResetStats()
+{
+    maxMixTime_.store(0.0f, std::memory_order_relaxed);
+    numMixedBlocks_.store(0, std::memory_order_relaxed);
+    numLateBlocks_.store(0, std::memory_order_relaxed);
+    numSilentBlocks_.store(0, std::memory_order_relaxed);
+}
+
+void SteamAudio::RecreateMixResources()
+{
+    // Nothing to do until initialized
+    if (!phononContext_)
+        return;
+
+    // Publish new workers and bus, the old ones are released once the audio thread no longer uses them
+    ea::unique_ptr<SteamAudioMixWorkers> oldMixWorkers = ea::move(mixWorkers_);
+    ea::unique_ptr<SteamAudioReflectionBus> oldBus = ea::move(reflectionBus_);
+    mixWorkers_ = ea::make_unique<SteamAudioMixWorkers>(this, numMixWorkers_, mixDeadline_);
+    if (reflectionMixMode_ == RMM_SHARED_BUS)
+        reflectionBus_ = ea::make_unique<SteamAudioReflectionBus>(this, reflectionBusOrder_, mixWorkers_->GetNumLanes());
+
+    MutexLock Lock(audioMutex_);
+    UnlockedPublishMixState();
+    SynchronizeWithAudioThread();
+
+    // Join the old workers before the old bus goes, one that was late may still be mixing into it
+    oldMixWorkers.reset();
+
+    // Sound sources stop using the old bus once their effects are recreated
+    for (auto source : soundSources_)
+        source->SuspendEffects();
+    for (auto source : soundSources_)
+        source->MarkEffectsDirty();
+}
+
+void SteamAudio::SetSimulationRates(float directRate, float reflectionRate)
+{
+    directSimulationRate_.store(Max(directRate, M_EPSILON), std::memory_order_relaxed);
+    reflectionSimulationRate_.store(Max(reflectionRate, M_EPSILON), std::memory_order_relaxed);
+}
+
+void SteamAudio::SetEffectLodDistances(float reducedDistance, float minimalDistance)
+{
+    effectLodReducedDistance_ = Max(reducedDistance, 0.0f);
+    effectLodMinimalDistance_ = Max(minimalDistance, 0.0f);
+}
+
+void SteamAudio::SetEffectBudget(float milliseconds)
+{
+    effectBudget_ = Max(milliseconds, 0.0f);
+    smoothedMixTime_ = 0.0f;
+    effectLodQuota_ = M_MAX_UNSIGNED;
+}
+
+void SteamAudio::SetSceneCommitRate(float rate)
+{
+    sceneCommitRate_.store(Max(rate, M_EPSILON), std::memory_order_relaxed);
+}
+
+void SteamAudio::SetTransformTolerance(float distance, float angle)
+{
+    transformDistanceTolerance_ = Max(distance, 0.0f);
+    transformAngleTolerance_ = Max(angle, 0.0f);
+}
+
+void SteamAudio::QueueSimulationTask(ea::function<void()> task)
+{
+    AcquireSimulationTasksMutex();
+    simulationTasks_.push_back(ea::move(task));
+    simulationTasksMutex_.Release();
+}
+
+void SteamAudio::AddSimulationSource(const ea::shared_ptr<SteamAudioSimulationSource>& source)
+{
+    QueueSimulationTask([this, source] {
+        if (simulationSources_.size() >= static_cast<unsigned>(simulationSettings_.maxNumSources))
+            GrowSimulator();
+        simulationSources_.push_back(source);
+        source->CreateSource(simulator_);
+        iplSourceAdd(source->source_, simulator_);
+        MarkSimulatorDirty();
+    });
+}
+
+void SteamAudio::RemoveSimulationSource(const ea::shared_ptr<SteamAudioSimulationSource>& source)
+{
+    QueueSimulationTask([this, source] {
+        auto i = simulationSources_.find(source);
+        if (i == simulationSources_.end())
+            return;
+        simulationSources_.erase(i);
+        iplSourceRemove(source->source_, simulator_);
+        source->ReleaseSource();
+        MarkSimulatorDirty();
+    });
+}
+
+void SteamAudio::AddProbeBatch(IPLProbeBatch probeBatch)
+{
+    QueueSimulationTask([this, probeBatch = iplProbeBatchRetain(probeBatch)] {
+        probeBatches_.push_back(probeBatch);
+        iplSimulatorAddProbeBatch(simulator_, probeBatch);
+        MarkSimulatorDirty();
+    });
+}
+
+void SteamAudio::RemoveProbeBatch(IPLProbeBatch probeBatch)
+{
+    QueueSimulationTask([this, probeBatch]() mutable {
+        auto i = probeBatches_.find(probeBatch);
+        if (i == probeBatches_.end())
+            return;
+        probeBatches_.erase(i);
+        iplSimulatorRemoveProbeBatch(simulator_, probeBatch);
+        MarkSimulatorDirty();
+        iplProbeBatchRelease(&probeBatch);
+    });
+}
+
+IPLStaticMesh SteamAudio::LoadStaticMesh(const SteamAudioStaticMeshKey& key, IPLScene scene)
+{
+    auto i = staticMeshCache_.find(key.hash_);
+    if (i == staticMeshCache_.end()) {
+        if (staticMeshCacheDir_.IsEmpty())
+            return nullptr;
+
+        // Serialized meshes depend on the phonon version
+        BinaryFile file(context_);
+        const FileIdentifier fileName = staticMeshCacheDir_ + Format("{:016x}_{}.bin", key.hash_, STEAMAUDIO_VERSION);
+        if (!GetSubsystem<VirtualFileSystem>()->Exists(fileName) || !file.LoadFile(fileName))
+            return nullptr;
+
+        // Cached data starts with the full key
+        MemoryBuffer buffer(file.GetData());
+        CachedStaticMesh cachedMesh;
+        cachedMesh.key_.hash_ = buffer.ReadUInt64();
+        cachedMesh.key_.numVertices_ = buffer.ReadUInt();
+        cachedMesh.key_.numIndices_ = buffer.ReadUInt();
+        cachedMesh.data_.resize(buffer.GetSize() - buffer.GetPosition());
+        buffer.Read(cachedMesh.data_.data(), cachedMesh.data_.size());
+        i = staticMeshCache_.emplace(key.hash_, ea::move(cachedMesh)).first;
+    }
+
+    // Different geometry with the same hash, build it instead
+    if (i->second.key_ != key) {
+        URHO3D_LOGWARNING("Steam Audio static mesh cache collision for {:016x}", key.hash_);
+        return nullptr;
+    }
+
+    // Phonon only reads from the wrapped data
+    IPLSerializedObjectSettings serializedObjectSettings {
+        .data = i->second.data_.data(),
+        .size = i->second.data_.size()
+    };
+    IPLSerializedObject serializedObject {};
+    iplSerializedObjectCreate(phononContext_, &serializedObjectSettings, &serializedObject);
+
+    IPLStaticMesh staticMesh {};
+    if (iplStaticMeshLoad(scene, serializedObject, nullptr, nullptr, &staticMesh) != IPL_STATUS_SUCCESS) {
+        URHO3D_LOGWARNING("Failed to load cached Steam Audio static mesh {:016x}", key.hash_);
+        staticMeshCache_.erase(i);
+        staticMesh = nullptr;
+    }
+    iplSerializedObjectRelease(&serializedObject);
+    return staticMesh;
+}
+
+void SteamAudio::SaveStaticMesh(const SteamAudioStaticMeshKey& key, IPLStaticMesh staticMesh)
+{
+    IPLSerializedObjectSettings serializedObjectSettings {};
+    IPLSerializedObject serializedObject {};
+    iplSerializedObjectCreate(phononContext_, &serializedObjectSettings, &serializedObject);
+    iplStaticMeshSave(staticMesh, serializedObject);
+
+    const IPLbyte* data = iplSerializedObjectGetData(serializedObject);
+    CachedStaticMesh& cachedMesh = staticMeshCache_[key.hash_];
+    cachedMesh.key_ = key;
+    cachedMesh.data_.assign(data, data + iplSerializedObjectGetSize(serializedObject));
+    iplSerializedObjectRelease(&serializedObject);
+
+    if (staticMeshCacheDir_.IsEmpty())
+        return;
+
+    VectorBuffer buffer;
+    buffer.WriteUInt64(key.hash_);
+    buffer.WriteUInt(key.numVertices_);
+    buffer.WriteUInt(key.numIndices_);
+    buffer.Write(cachedMesh.data_.data(), cachedMesh.data_.size());
+
+    BinaryFile file(context_);
+    file.SetData(buffer.GetBuffer());
+    if (!file.SaveFile(staticMeshCacheDir_ + Format("{:016x}_{}.bin", key.hash_, STEAMAUDIO_VERSION)))
+        URHO3D_LOGWARNING("Failed to save Steam Audio static mesh {:016x} to cache", key.hash_);
+}
+
+void SteamAudio::SetStaticBatchSimplification(float cellSize)
+{
+    staticBatchCellSize_ = Max(cellSize, 0.0f);
+    MarkStaticBatchDirty();
+}
+
+void SteamAudio::AddStaticMesh(SteamSoundMesh* mesh)
+{
+    staticMeshes_.push_back(mesh);
+    MarkStaticBatchDirty();
+}
+
+void SteamAudio::RemoveStaticMesh(SteamSoundMesh* mesh)
+{
+    auto i = staticMeshes_.find(mesh);
+    if (i == staticMeshes_.end())
+        return;
+    staticMeshes_.erase(i);
+    MarkStaticBatchDirty();
+}
+
+const SteamAudioStaticGeometry& SteamAudio::GetStaticGeometry(const SteamSoundMesh* mesh)
+{
+    const SteamAudioStaticMeshKey& key = mesh->GetCacheKey();
+    CachedStaticGeometry& cachedGeometry = staticGeometryCache_[key.hash_];
+    if (cachedGeometry.key_ != key) {
+        // New entry or a colliding model, the previous geometry was already appended by its mesh
+        cachedGeometry.key_ = key;
+        cachedGeometry.geometry_.points_.clear();
+        cachedGeometry.geometry_.indices_.clear();
+        mesh->ExtractGeometry(cachedGeometry.geometry_.points_, cachedGeometry.geometry_.indices_);
+    }
+    cachedGeometry.used_ = true;
+    return cachedGeometry.geometry_;
+}
+
+void SteamAudio::RebuildStaticBatch()
+{
+    URHO3D_PROFILE("RebuildSteamAudioStaticBatch");
+    staticBatchDirty_ = false;
+
+    // Gather world space geometry of all static meshes, unpacking each model only once
+    for (auto& [hash, cachedGeometry] : staticGeometryCache_)
+        cachedGeometry.used_ = false;
+
+    ea::vector<IPLVector3> vertices;
+    ea::vector<IPLTriangle> triangles;
+    ea::vector<IPLint32> materialIndices;
+    for (auto mesh : staticMeshes_)
+        mesh->AppendWorldGeometry(GetStaticGeometry(mesh), vertices, triangles, materialIndices);
+    numStaticSourceTriangles_ = triangles.size();
+    ++numStaticBatchRebuilds_;
+
+    // Forget geometry of models no longer used by any static mesh
+    for (auto i = staticGeometryCache_.begin(); i != staticGeometryCache_.end();) {
+        if (i->second.used_)
+            ++i;
+        else
+            i = staticGeometryCache_.erase(i);
+    }
+
+    if (staticBatchCellSize_ > 0.0f)
+        ClusterVertices(vertices, triangles, materialIndices, staticBatchCellSize_);
+    numStaticBatchTriangles_ = triangles.size();
+    URHO3D_LOGDEBUG("Steam Audio static batch: {} mesh(es), {} triangle(s), {} after simplification",
+        staticMeshes_.size(), numStaticSourceTriangles_, numStaticBatchTriangles_);
+
+    // Create one mesh with per-triangle materials
+    IPLStaticMesh staticBatch {};
+    if (!triangles.empty()) {
+        const ea::span<const IPLMaterial> phononMaterials = SteamSoundMesh::GetPhononMaterials();
+        ea::vector<IPLMaterial> materials(phononMaterials.begin(), phononMaterials.end());
+        IPLStaticMeshSettings staticMeshSettings {
+            .numVertices = static_cast<IPLint32>(vertices.size()),
+            .numTriangles = static_cast<IPLint32>(triangles.size()),
+            .numMaterials = static_cast<IPLint32>(materials.size()),
+            .vertices = vertices.data(),
+            .triangles = triangles.data(),
+            .materialIndices = materialIndices.data(),
+            .materials = materials.data()
+        };
+        iplStaticMeshCreate(scene_, &staticMeshSettings, &staticBatch);
+    }
+
+    // Swap batches on the simulation thread, it keeps the old one alive until then
+    QueueSimulationTask([this, oldBatch = staticBatch_, newBatch = staticBatch ? iplStaticMeshRetain(staticBatch) : nullptr]() mutable {
+        if (oldBatch) {
+            iplStaticMeshRemove(oldBatch, scene_);
+            iplStaticMeshRelease(&oldBatch);
+        }
+        if (newBatch) {
+            iplStaticMeshAdd(newBatch, scene_);
+            iplStaticMeshRelease(&newBatch);
+        }
+        MarkSceneDirty();
+    });
+    staticBatch_ = staticBatch;
+}
+
+void SteamAudio::SaveSceneOBJ(const ea::string& fileBaseName)
+{
+    QueueSimulationTask([this, fileBaseName] {
+        CommitSimulationChanges(true);
+        iplSceneSaveOBJ(scene_, fileBaseName.c_str());
+    });
+}
+
+void SteamAudio::RunSimulationTaskAndWait(const ea::function<void()>& task)
+{
+    std::atomic<bool> done{};
+    QueueSimulationTask([this, &task, &done] {
+        // Tasks queued before may have changed the scene
+        CommitSimulationChanges(true);
+        task();
+        done.store(true, std::memory_order_release);
+    });
+
+    if (!simulationThread_) {
+        RunSimulationTasks();
+        return;
+    }
+    while (!done.load(std::memory_order_acquire))
+        Time::Sleep(1);
+}
+
+void SteamAudio::GrowSimulator()
+{
+    simulationSettings_.maxNumSources *= 2;
+    URHO3D_LOGDEBUG("Growing Steam Audio simulator to {} sources", simulationSettings_.maxNumSources);
+
+    // Create the new simulator for the same scene
+    IPLSimulator simulator {};
+    iplSimulatorCreate(phononContext_, &simulationSettings_, &simulator);
+    iplSimulatorSetScene(simulator, scene_);
+
+    // Published outputs point into the current sources, keep them until outputs of the new ones are published.
+    // Sources of a simulator grown again before that were never published and can go right away
+    const bool retire = !retiredSimulator_;
+    for (auto& source : simulationSources_) {
+        iplSourceRemove(source->source_, simulator_);
+        if (retire) {
+            retiredSources_.push_back(source->source_);
+            source->source_ = nullptr;
+        }
+        source->CreateSource(simulator);
+        iplSourceAdd(source->source_, simulator);
+    }
+    for (auto probeBatch : probeBatches_) {
+        iplSimulatorRemoveProbeBatch(simulator_, probeBatch);
+        iplSimulatorAddProbeBatch(simulator, probeBatch);
+    }
+
+    if (retire)
+        retiredSimulator_ = simulator_;
+    else
+        iplSimulatorRelease(&simulator_);
+    simulator_ = simulator;
+    simulatorCapacity_.store(simulationSettings_.maxNumSources, std::memory_order_relaxed);
+    MarkSimulatorDirty();
+
+    // Simulate right away so that the new outputs are not empty for long
+    nextDirectSimulation_ = {};
+    nextReflectionSimulation_ = {};
+}
+
+void SteamAudio::ReleaseRetiredSimulator()
+{
+    if (!retiredSimulator_)
+        return;
+
+    // Wait for a block that may have fetched outputs before they were republished
+    SynchronizeWithAudioThread();
+
+    for (IPLSource& source : retiredSources_)
+        iplSourceRelease(&source);
+    retiredSources_.clear();
+    iplSimulatorRelease(&retiredSimulator_);
+}
+
+void SteamAudio::AddStreamSource(const ea::shared_ptr<SteamAudioStreamSource>& source)
+{
+    // Fill the buffer before the audio thread sees the stream
+    source->Decode();
+
+    MutexLock Lock(streamSourcesMutex_);
+    streamSources_.push_back(source);
+}
+
+void SteamAudio::RemoveStreamSource(const ea::shared_ptr<SteamAudioStreamSource>& source)
+{
+    MutexLock Lock(streamSourcesMutex_);
+    auto i = streamSources_.find(source);
+    if (i != streamSources_.end())
+        streamSources_.erase(i);
+}
+
+void SteamAudio::DecodeStreams()
+{
+    URHO3D_PROFILE("DecodeSteamAudioStreams");
+
+    MutexLock Lock(streamSourcesMutex_);
+    for (auto& source : streamSources_)
+        source->Decode();
+}
+
+void SteamAudio::RunSimulationTasks()
+{
+    // Take pending tasks, they may queue new ones while running
+    AcquireSimulationTasksMutex();
+    ea::swap(runningSimulationTasks_, simulationTasks_);
+    simulationTasksMutex_.Release();
+
+    for (auto& task : runningSimulationTasks_)
+        task();
+    runningSimulationTasks_.clear();
+
+    CommitSimulationChanges();
+}
+
+void SteamAudio::AcquireSimulationTasksMutex()
+{
+    if (simulationTasksMutex_.TryAcquire())
+        return;
+
+    numSimulationLockContentions_.fetch_add(1, std::memory_order_relaxed);
+    simulationTasksMutex_.Acquire();
+}
+
+void SteamAudio::CommitSimulationChanges(bool force)
+{
+    using namespace std::chrono;
+
+    // No simulation is running on this thread. Scene changes in between commits are coalesced
+    const auto now = GetSimulationTime();
+    if ((force || now >= nextSceneCommit_) && sceneDirty_.exchange(false, std::memory_order_relaxed)) {
+        URHO3D_PROFILE("CommitSteamAudioScene");
+        nextSceneCommit_ = now + duration_cast<steady_clock::duration>(duration<float>(1.0f/GetSceneCommitRate()));
+        const auto commitStart = steady_clock::now();
+        iplSceneCommit(scene_);
+
+        const float commitTime = duration<float, std::milli>(steady_clock::now() - commitStart).count();
+        const unsigned numCommits = numSceneCommits_.fetch_add(1, std::memory_order_relaxed) + 1;
+        lastSceneCommitTime_.store(commitTime, std::memory_order_relaxed);
+        URHO3D_PROFILE_VALUE("SteamAudio Scene Commit Time (ms)", commitTime);
+        URHO3D_PROFILE_VALUE("SteamAudio Scene Commits", static_cast<int64_t>(numCommits));
+    }
+    if (simulatorDirty_.exchange(false, std::memory_order_relaxed))
+        iplSimulatorCommit(simulator_);
+}
+
+float SteamAudio::RunSimulation()
+{
+    using namespace std::chrono;
+
+    RunSimulationTasks();
+
+    const auto directInterval = duration_cast<steady_clock::duration>(duration<float>(1.0f/GetDirectSimulationRate()));
+    const auto reflectionInterval = duration_cast<steady_clock::duration>(duration<float>(1.0f/GetReflectionSimulationRate()));
+    const auto now = GetSimulationTime();
+
+    // Fetch latest listener and settings
+    const SimulationState& state = simulationState_.Read();
+    const bool runDirect = state.hasListener_ && now >= nextDirectSimulation_;
+    const bool runReflections = state.hasListener_ && state.simulateReflections_ && now >= nextReflectionSimulation_;
+
+    if (runDirect || runReflections) {
+        // Fetch latest source transforms
+        for (auto& source : simulationSources_)
+            source->inputs_.Update();
+
+        IPLSimulationSharedInputs sharedInputs = state.sharedInputs_;
+        if (runDirect) {
+            nextDirectSimulation_ = now + directInterval;
+            iplSimulatorSetSharedInputs(simulator_, IPL_SIMULATIONFLAGS_DIRECT, &sharedInputs);
+            for (auto& source : simulationSources_)
+                iplSourceSetInputs(source->source_, IPL_SIMULATIONFLAGS_DIRECT, &source->inputs_.GetFront());
+            iplSimulatorRunDirect(simulator_);
+        }
+        if (runReflections) {
+            nextReflectionSimulation_ = now + reflectionInterval;
+            iplSimulatorSetSharedInputs(simulator_, IPL_SIMULATIONFLAGS_REFLECTIONS, &sharedInputs);
+            for (auto& source : simulationSources_) {
+                if (source->flags_ & IPL_SIMULATIONFLAGS_REFLECTIONS)
+                    iplSourceSetInputs(source->source_, IPL_SIMULATIONFLAGS_REFLECTIONS, &source->inputs_.GetFront());
+            }
+            iplSimulatorRunReflections(simulator_);
+        }
+    }
+
+    // Hand outputs over to the audio thread. After the simulator grew all outputs are fetched again, older ones point into retired sources
+    const bool retiring = retiredSimulator_ != nullptr;
+    if (runDirect || runReflections || retiring) {
+        for (auto& source : simulationSources_) {
+            if (runDirect || retiring)
+                iplSourceGetOutputs(source->source_, IPL_SIMULATIONFLAGS_DIRECT, &source->lastOutputs_);
+            if ((runReflections || retiring) && (source->flags_ & IPL_SIMULATIONFLAGS_REFLECTIONS))
+                iplSourceGetOutputs(source->source_, IPL_SIMULATIONFLAGS_REFLECTIONS, &source->lastOutputs_);
+            source->outputs_.Publish(source->lastOutputs_);
+        }
+    }
+    if (retiring)
+        ReleaseRetiredSimulator();
+
+    // Return time until the next simulation is due
+    auto nextSimulation = nextDirectSimulation_;
+    if (state.simulateReflections_)
+        nextSimulation = ea::min(nextSimulation, nextReflectionSimulation_);
+    return Max(duration<float>(nextSimulation - GetSimulationTime()).count(), 0.0f);
+}
+
+std::chrono::steady_clock::time_point SteamAudio::GetSimulationTime() const
+{
+    return offline_ ? offlineTime_ : std::chrono::steady_clock::now();
+}
+
+unsigned SteamAudio::GetNumMixAllocations() const
+{
+    return numMixAllocations.load(std::memory_order_relaxed);
 }
 
 float SteamAudio::GetMasterGain() const
@@ -278,62 +1096,95 @@ void SteamAudio::AddSoundSource(SteamSoundSource *soundSource)
 {
     MutexLock Lock(audioMutex_);
     soundSources_.push_back(soundSource);
+    UnlockedPublishMixState();
 }
 
 void SteamAudio::RemoveSoundSource(SteamSoundSource *soundSource)
 {
-    MutexLock Lock(audioMutex_);
-    auto i = soundSources_.find(soundSource);
-    if (i != soundSources_.end())
     {
-        MutexLock lock(audioMutex_);
+        MutexLock Lock(audioMutex_);
+        auto i = soundSources_.find(soundSource);
+        if (i == soundSources_.end())
+            return;
         soundSources_.erase(i);
+        UnlockedPublishMixState();
     }
+
+    // Make sure the audio thread dropped the source before it gets destroyed
+    SynchronizeWithAudioThread();
+}
+
+void SteamAudio::SynchronizeWithAudioThread() const
+{
+    // Pairs with the fence in MixOutput(): either the audio thread sees what was unpublished, or we see its block in progress
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const unsigned generation = mixGeneration_.load(std::memory_order_acquire);
+    if (generation & 1u) {
+        while (mixGeneration_.load(std::memory_order_acquire) == generation)
+            std::this_thread::yield();
+    }
+
+    // Workers that were late for a block may still render sources of it
+    if (mixWorkers_)
+        mixWorkers_->WaitForLateWorkers();
 }
 
 void SteamAudio::MixOutput(float *dest) noexcept
 {
-    // Stop if no listener
-    if (!GetListener()) {
+    URHO3D_PROFILE("SteamAudioMix");
+    MixOutputScope scope;
+    const auto mixStart = std::chrono::steady_clock::now();
+
+    // Mark block as in progress, see SynchronizeWithAudioThread()
+    mixGeneration_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // Fetch latest state published by the main thread
+    const MixState& mixState = mixState_.Read();
+
+    // Output silence if no listener
+    if (!mixState.hasListener_ || !mixState.mixWorkers_) {
         memset(dest, 0, audioSettings_.frameSize*channelCount_*sizeof(float));
+        numSilentBlocks_.fetch_add(1, std::memory_order_relaxed);
+        numActiveSources_.store(0, std::memory_order_relaxed);
+        mixGeneration_.fetch_add(1, std::memory_order_release);
         return;
     }
 
-    // Don't do anything if lock can't be acquired
-    if (!audioMutex_.TryAcquire())
-        return;
-
     // Clear frame buffer
-    for (unsigned channel = 0; channel != phononFrameBuffer_.numChannels; channel++)
-        for (unsigned sample = 0; sample != phononFrameBuffer_.numSamples; sample++)
-            phononFrameBuffer_.data[channel][sample] = 0.0f;
+    for (IPLint32 channel = 0; channel != phononFrameBuffer_.numChannels; channel++)
+        memset(phononFrameBuffer_.data[channel], 0, phononFrameBuffer_.numSamples*sizeof(float));
 
-    // Iterate over all sound sources
-    for (auto source : soundSources_) {
-        // Skip disabled ones
-        if (!source->IsEnabledEffective())
-            continue;
-
-        // Generate audio buffer
-        auto audioBuffer = source->GenerateAudioBuffer(masterGain_);
-
-        // Skip if none generated
-        if (!audioBuffer)
-            continue;
+    // Render all sound sources, in parallel if there are workers
+    mixState.mixWorkers_->Mix(mixState.soundSources_, mixState.masterGain_, mixState.reflectionBus_, &phononFrameBuffer_);
 
-        // Mix into frame buffer
-        iplAudioBufferMix(phononContext_, audioBuffer, &phononFrameBuffer_);
-    }
+    // Decode shared reflections once for all sources
+    if (mixState.reflectionBus_)
+        mixState.reflectionBus_->Decode(&phononFrameBuffer_);
 
     // Interleave into our buffer
     iplAudioBufferInterleave(phononContext_, &phononFrameBuffer_, dest);
 
-    audioMutex_.Release();
+    // Compare mix time against the time the device takes to play the block
+    const unsigned numActiveSources = mixState.mixWorkers_->GetNumRenderedSources();
+    const float mixTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mixStart).count();
+    lastMixTime_.store(mixTime, std::memory_order_relaxed);
+    if (mixTime > maxMixTime_.load(std::memory_order_relaxed))
+        maxMixTime_.store(mixTime, std::memory_order_relaxed);
+    if (mixTime > blockDuration_)
+        numLateBlocks_.fetch_add(1, std::memory_order_relaxed);
+    numMixedBlocks_.fetch_add(1, std::memory_order_relaxed);
+    numActiveSources_.store(numActiveSources, std::memory_order_relaxed);
+    URHO3D_PROFILE_VALUE("SteamAudio Mix Time (ms)", mixTime);
+    URHO3D_PROFILE_VALUE("SteamAudio Active Sources", static_cast<int64_t>(numActiveSources));
+
+    mixGeneration_.fetch_add(1, std::memory_order_release);
 }
 
 unsigned int SteamAudio::ChannelCount(unsigned int order)
 {
     switch (order) {
+    case 0: return 1;
     case 1: return 4;
     case 2: return 9;
     case 3: return 16;
@@ -344,6 +1195,83 @@ unsigned int SteamAudio::ChannelCount(unsigned int order)
     }
 }
 
+void SteamAudio::UnlockedPublishMixState()
+{
+    MixState& mixState = mixState_.GetBack();
+    mixState.soundSources_ = soundSources_;
+    mixState.masterGain_ = masterGain_;
+    mixState.hasListener_ = GetListener() != nullptr;
+    mixState.reflectionBus_ = reflectionBus_.get();
+    mixState.mixWorkers_ = mixWorkers_.get();
+    mixState_.Publish();
+}
+
+void SteamAudio::UnlockedUpdateVoices()
+{
+    // Gather playing sources, everything else keeps rendering as usual. Sounds that ended no longer take a voice
+    voiceRanking_.clear();
+    const SteamSoundListener* listener = GetListener();
+    const Vector3 listenerPosition = listener?listener->GetNode()->GetWorldPosition():Vector3::ZERO;
+    for (auto source : soundSources_) {
+        source->SetVirtual(false);
+        source->SetEffectLod(ELOD_FULL);
+        if (!source->IsPlaying() || source->IsFinished() || !source->IsEnabledEffective())
+            continue;
+
+        // Distant sources get cheaper effects
+        const float distance = (source->GetNode()->GetWorldPosition() - listenerPosition).Length();
+        EffectLOD effectLod = ELOD_FULL;
+        if (effectLodMinimalDistance_ > 0.0f && distance > effectLodMinimalDistance_)
+            effectLod = ELOD_MINIMAL;
+        else if (effectLodReducedDistance_ > 0.0f && distance > effectLodReducedDistance_)
+            effectLod = ELOD_REDUCED;
+        voiceRanking_.push_back(Voice {source, source->GetPriority(), source->GetAudibility(listenerPosition), effectLod});
+    }
+
+    const auto moreImportant = [](const Voice& lhs, const Voice& rhs) {
+        if (lhs.priority_ != rhs.priority_)
+            return lhs.priority_ > rhs.priority_;
+        return lhs.audibility_ > rhs.audibility_;
+    };
+
+    // Lower effect LOD of the least important sources while over the mix time budget
+    UpdateEffectLodQuota(voiceRanking_.size());
+    if (effectLodQuota_ < voiceRanking_.size()) {
+        ea::sort(voiceRanking_.begin(), voiceRanking_.end(), moreImportant);
+        for (unsigned i = effectLodQuota_; i < voiceRanking_.size(); ++i)
+            voiceRanking_[i].effectLod_ = static_cast<EffectLOD>(Min(voiceRanking_[i].effectLod_ + 1, static_cast<int>(ELOD_MINIMAL)));
+    }
+    for (const Voice& voice : voiceRanking_)
+        voice.source_->SetEffectLod(voice.effectLod_);
+
+    numVirtualVoices_ = 0;
+    if (!maxRealVoices_ || voiceRanking_.size() <= maxRealVoices_)
+        return;
+
+    // Keep the most important sources real, the rest only advance their playback position
+    const auto realEnd = voiceRanking_.begin() + maxRealVoices_;
+    ea::nth_element(voiceRanking_.begin(), realEnd, voiceRanking_.end(), moreImportant);
+    for (auto i = realEnd; i != voiceRanking_.end(); ++i)
+        i->source_->SetVirtual(true);
+    numVirtualVoices_ = voiceRanking_.size() - maxRealVoices_;
+}
+
+void SteamAudio::UpdateEffectLodQuota(unsigned numVoices)
+{
+    if (effectBudget_ <= 0.0f) {
+        effectLodQuota_ = M_MAX_UNSIGNED;
+        return;
+    }
+
+    // Lower quickly when over budget and raise slowly when well below, so the quota does not oscillate
+    smoothedMixTime_ = Lerp(smoothedMixTime_, lastMixTime_.load(std::memory_order_relaxed), 0.2f);
+    if (smoothedMixTime_ > effectBudget_) {
+        effectLodQuota_ = Min(effectLodQuota_, numVoices);
+        effectLodQuota_ -= Min(effectLodQuota_, Max(effectLodQuota_/8, 1u));
+    } else if (smoothedMixTime_ < effectBudget_*0.75f && effectLodQuota_ < numVoices)
+        ++effectLodQuota_;
+}
+
 IPLSimulationFlags SteamAudio::SimulationFlags() const
 {
     int fres = IPL_SIMULATIONFLAGS_DIRECT;
@@ -354,21 +1282,50 @@ IPLSimulationFlags SteamAudio::SimulationFlags() const
 
 void SteamAudio::HandleRenderUpdate(StringHash eventType, VariantMap &eventData)
 {
-    using namespace RenderUpdate;
-
-    Update(eventData[P_TIMESTEP].GetFloat());
+    const float timeStep = eventData[RenderUpdate::P_TIMESTEP].GetFloat();
+    Update(timeStep);
+
+    // Let audio components update
+    using namespace SteamAudioUpdate;
+    VariantMap& audioEventData = GetEventDataMap();
+    audioEventData[P_TIMESTEP] = timeStep;
+    SendEvent(E_STEAMAUDIOUPDATE, audioEventData);
 }
 
 void SteamAudio::Release()
 {
+    // Stop the audio and simulation threads before releasing anything they use
+    if (deviceOpen_)
+        SDL_CloseAudio();
+    deviceOpen_ = false;
+    simulationThread_.reset();
+    decoderThread_.reset();
+
+    // Apply pending changes, tasks may hold references to phonon objects
+    if (simulator_)
+        RunSimulationTasks();
+    for (auto& source : simulationSources_)
+        source->ReleaseSource();
+    simulationSources_.clear();
+    for (auto& probeBatch : probeBatches_)
+        iplProbeBatchRelease(&probeBatch);
+    probeBatches_.clear();
+    if (staticBatch_)
+        iplStaticMeshRelease(&staticBatch_);
+    if (!staticMeshes_.empty())
+        MarkStaticBatchDirty();
+
+    mixState_.Publish(MixState {});
+    mixWorkers_.reset();
+    reflectionBus_.reset();
+    ReleaseRetiredSimulator();
     iplSimulatorRelease(&simulator_);
+    iplEmbreeDeviceRelease(&embreeDevice_);
+    sceneSettings_ = IPLSceneSettings {};
     iplAudioBufferFree(phononContext_, &phononFrameBuffer_);
     iplHRTFRelease(&hrtf_);
     iplContextRelease(&phononContext_);
-    audioBufferPool_.reset();
     finalFrameBuffer_.clear();
-    SDL_CloseAudio();
-    audioMutex_.Acquire();
 }
 
 void SDLSteamAudioCallback(void* userdata, Uint8 *stream, int)
@@ -380,6 +1337,75 @@ void SDLSteamAudioCallback(void* userdata, Uint8 *stream, int)
 }
 
 
+SteamAudioSimulationSource::SteamAudioSimulationSource(IPLSimulationFlags flags) : flags_(flags)
+{
+}
+
+SteamAudioSimulationSource::~SteamAudioSimulationSource()
+{
+    ReleaseSource();
+}
+
+void SteamAudioSimulationSource::CreateSource(IPLSimulator simulator)
+{
+    ReleaseSource();
+
+    IPLSourceSettings sourceSettings {
+        .flags = flags_
+    };
+    iplSourceCreate(simulator, &sourceSettings, &source_);
+}
+
+void SteamAudioSimulationSource::ReleaseSource()
+{
+    if (source_)
+        iplSourceRelease(&source_);
+}
+
+
+SteamAudioStreamSource::SteamAudioStreamSource(SoundStream* stream, unsigned capacity) : stream_(stream), buffer_(capacity)
+{
+    // Decode in chunks of a quarter of the buffer
+    const unsigned chunkSamples = buffer_.GetCapacity()/4;
+    rawBuffer_.resize(chunkSamples*(stream_->IsSixteenBit()?2:1));
+    decodeBuffer_.resize(chunkSamples);
+}
+
+SteamAudioStreamSource::~SteamAudioStreamSource() = default;
+
+void SteamAudioStreamSource::Decode()
+{
+    if (finished_.load(std::memory_order_relaxed))
+        return;
+    if (controlsLoop_)
+        stream_->SetStopAtEnd(!loop_.load(std::memory_order_relaxed));
+
+    const unsigned channels = stream_->IsStereo()?2:1;
+    const unsigned sampleBytes = stream_->IsSixteenBit()?2:1;
+    while (buffer_.GetNumWritable() >= decodeBuffer_.size()) {
+        // Only request whole frames so channels stay interleaved
+        const unsigned numBytes = decodeBuffer_.size()/channels*channels*sampleBytes;
+        const unsigned numSamples = stream_->GetData(rawBuffer_.data(), numBytes)/sampleBytes/channels*channels;
+        if (!numSamples) {
+            if (stream_->GetStopAtEnd())
+                finished_.store(true, std::memory_order_release);
+            return;
+        }
+
+        // Convert to float like non-streamed sounds
+        if (sampleBytes == 2) {
+            const auto* integerData = reinterpret_cast<const int16_t*>(rawBuffer_.data());
+            for (unsigned sample = 0; sample != numSamples; sample++)
+                decodeBuffer_[sample] = float(integerData[sample])/32767.0f;
+        } else {
+            for (unsigned sample = 0; sample != numSamples; sample++)
+                decodeBuffer_[sample] = float(rawBuffer_[sample])/128.f;
+        }
+        buffer_.Write(decodeBuffer_.data(), numSamples);
+    }
+}
+
+
 SteamAudioBufferPool::SteamAudioBufferPool(SteamAudio *audio) : audio_(audio), bufferIdx_(0)
 {
     const auto phononContext = audio_->GetPhononContext();
@@ -420,12 +1446,337 @@ unsigned int SteamAudioBufferPool::GetNextBufferIndex() const
 }
 
 
+SteamAudioReflectionBus::SteamAudioReflectionBus(SteamAudio *audio, unsigned ambisonicsOrder, unsigned numLanes) : audio_(audio), ambisonicsOrder_(ambisonicsOrder)
+{
+    const auto phononContext = audio_->GetPhononContext();
+    auto audioSettings = audio_->GetAudioSettings();
+    const auto numChannels = SteamAudio::ChannelCount(ambisonicsOrder_);
+
+    // Reflection effects of sound sources are created with the same settings
+    IPLReflectionEffectSettings reflectionEffectSettings {
+        .type = IPL_REFLECTIONEFFECTTYPE_CONVOLUTION,
+        .irSize = static_cast<IPLint32>(audio_->ImpulseResponseDuration() * audioSettings.samplingRate),
+        .numChannels = static_cast<IPLint32>(numChannels)
+    };
+    mixers_.resize(numLanes);
+    laneBuffers_.resize(numLanes);
+    for (unsigned lane = 0; lane != numLanes; lane++) {
+        iplReflectionMixerCreate(phononContext, &audioSettings, &reflectionEffectSettings, &mixers_[lane]);
+        iplAudioBufferAllocate(phononContext, numChannels, audioSettings.frameSize, &laneBuffers_[lane]);
+        for (IPLint32 channel = 0; channel != laneBuffers_[lane].numChannels; channel++)
+            memset(laneBuffers_[lane].data[channel], 0, laneBuffers_[lane].numSamples*sizeof(float));
+    }
+
+    IPLAmbisonicsBinauralEffectSettings ambisonicsBinauralEffectSettings {
+        .hrtf = audio_->GetHRTF(),
+        .maxOrder = static_cast<IPLint32>(ambisonicsOrder_)
+    };
+    iplAmbisonicsBinauralEffectCreate(phononContext, &audioSettings, &ambisonicsBinauralEffectSettings, &decoder_);
+
+    iplAudioBufferAllocate(phononContext, numChannels, audioSettings.frameSize, &buffer_);
+    for (IPLint32 channel = 0; channel != buffer_.numChannels; channel++)
+        memset(buffer_.data[channel], 0, buffer_.numSamples*sizeof(float));
+    iplAudioBufferAllocate(phononContext, numChannels, audioSettings.frameSize, &mixerBuffer_);
+    iplAudioBufferAllocate(phononContext, audio_->GetChannelCount(), audioSettings.frameSize, &output_);
+}
+
+SteamAudioReflectionBus::~SteamAudioReflectionBus()
+{
+    const auto phononContext = audio_->GetPhononContext();
+    iplAudioBufferFree(phononContext, &output_);
+    iplAudioBufferFree(phononContext, &mixerBuffer_);
+    iplAudioBufferFree(phononContext, &buffer_);
+    iplAmbisonicsBinauralEffectRelease(&decoder_);
+    for (auto& buffer : laneBuffers_)
+        iplAudioBufferFree(phononContext, &buffer);
+    for (auto& mixer : mixers_)
+        iplReflectionMixerRelease(&mixer);
+}
+
+void SteamAudioReflectionBus::Mix(unsigned lane, IPLReflectionEffect effect, IPLReflectionEffectParams& params, IPLAudioBuffer* input, IPLAudioBuffer* scratch)
+{
+    if (params.type == IPL_REFLECTIONEFFECTTYPE_CONVOLUTION) {
+        // Convolution output is accumulated in frequency domain by the mixer
+        iplReflectionEffectApply(effect, &params, input, scratch, mixers_[lane]);
+    } else {
+        iplReflectionEffectApply(effect, &params, input, scratch, nullptr);
+        MixRendered(lane, scratch);
+    }
+}
+
+void SteamAudioReflectionBus::MixRendered(unsigned lane, IPLAudioBuffer* reflections)
+{
+    iplAudioBufferMix(audio_->GetPhononContext(), reflections, &laneBuffers_[lane]);
+}
+
+void SteamAudioReflectionBus::ReduceLane(unsigned lane)
+{
+    const auto phononContext = audio_->GetPhononContext();
+    const auto& audioSettings = audio_->GetAudioSettings();
+
+    // Retrieve convolution output of the lane and sum it up with the other reflections
+    IPLReflectionEffectParams reflectionEffectParams {
+        .type = IPL_REFLECTIONEFFECTTYPE_CONVOLUTION,
+        .numChannels = static_cast<IPLint32>(buffer_.numChannels),
+        .irSize = static_cast<IPLint32>(audio_->ImpulseResponseDuration() * audioSettings.samplingRate)
+    };
+    iplReflectionMixerApply(mixers_[lane], &reflectionEffectParams, &mixerBuffer_);
+    iplAudioBufferMix(phononContext, &mixerBuffer_, &buffer_);
+    iplAudioBufferMix(phononContext, &laneBuffers_[lane], &buffer_);
+
+    // Clear lane for the next block
+    for (IPLint32 channel = 0; channel != laneBuffers_[lane].numChannels; channel++)
+        memset(laneBuffers_[lane].data[channel], 0, laneBuffers_[lane].numSamples*sizeof(float));
+}
+
+void SteamAudioReflectionBus::Decode(IPLAudioBuffer* output)
+{
+    const auto phononContext = audio_->GetPhononContext();
+
+    // Decode and add to output
+    IPLAmbisonicsBinauralEffectParams ambisonicsBinauralEffectParams {
+        .hrtf = audio_->GetHRTF(),
+        .order = static_cast<IPLint32>(ambisonicsOrder_)
+    };
+    iplAmbisonicsBinauralEffectApply(decoder_, &ambisonicsBinauralEffectParams, &buffer_, &output_);
+    iplAudioBufferMix(phononContext, &output_, output);
+
+    // Clear bus for the next block
+    for (IPLint32 channel = 0; channel != buffer_.numChannels; channel++)
+        memset(buffer_.data[channel], 0, buffer_.numSamples*sizeof(float));
+}
+
+
+class SteamAudioMixWorkers::WorkerThread : public Thread
+{
+public:
+    WorkerThread(SteamAudioMixWorkers* owner, unsigned lane) : Thread(Format("SteamAudio Mixer {}", lane)), owner_(owner), lane_(lane) {}
+
+    void ThreadFunction() override
+    {
+        URHO3D_PROFILE_THREAD(name_.c_str());
+        owner_->WorkerLoop(lane_);
+    }
+
+private:
+    SteamAudioMixWorkers* owner_;
+    unsigned lane_;
+};
+
+SteamAudioMixWorkers::SteamAudioMixWorkers(SteamAudio *audio, unsigned numWorkers, float deadline) : audio_(audio), deadline_(deadline)
+{
+    const auto phononContext = audio_->GetPhononContext();
+    const auto& audioSettings = audio_->GetAudioSettings();
+
+    // Audio thread mixes into the output directly and needs no accumulation buffers
+    numLanes_ = numWorkers + 1;
+    lanes_ = ea::make_unique<Lane[]>(numLanes_);
+    for (unsigned laneIndex = 0; laneIndex != numLanes_; laneIndex++) {
+        lanes_[laneIndex].bufferPool_ = ea::make_unique<SteamAudioBufferPool>(audio_);
+        if (laneIndex != 0) {
+            for (IPLAudioBuffer& accumulation : lanes_[laneIndex].accumulation_)
+                iplAudioBufferAllocate(phononContext, audio_->GetChannelCount(), audioSettings.frameSize, &accumulation);
+        }
+    }
+
+    for (unsigned lane = 1; lane != numLanes_; lane++) {
+        workers_.push_back(ea::make_unique<WorkerThread>(this, lane));
+        workers_.back()->Run();
+    }
+}
+
+SteamAudioMixWorkers::~SteamAudioMixWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        shutdown_ = true;
+    }
+    wakeCondition_.notify_all();
+    workers_.clear();
+
+    const auto phononContext = audio_->GetPhononContext();
+    for (unsigned laneIndex = 0; laneIndex != numLanes_; laneIndex++) {
+        for (IPLAudioBuffer& accumulation : lanes_[laneIndex].accumulation_) {
+            if (accumulation.data)
+                iplAudioBufferFree(phononContext, &accumulation);
+        }
+    }
+}
+
+void SteamAudioMixWorkers::Mix(const ea::vector<SteamSoundSource*>& sources, float gain, SteamAudioReflectionBus* reflectionBus, IPLAudioBuffer* output)
+{
+    const auto phononContext = audio_->GetPhononContext();
+    const auto& audioSettings = audio_->GetAudioSettings();
+
+    // Generations fit the job state and 0 marks idle lanes
+    jobGeneration_ = (jobGeneration_ + 1) & (UINT_MAX >> 1u);
+    if (!jobGeneration_)
+        jobGeneration_ = 1;
+    const unsigned generation = jobGeneration_;
+
+    // Set up the job, no new sources are started once most of the block duration has passed
+    const auto jobStart = std::chrono::steady_clock::now();
+    const auto blockDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(double(audioSettings.frameSize)/audioSettings.samplingRate));
+    Job& job = jobs_[generation & 1u];
+    job.sources_ = &sources;
+    job.gain_ = gain;
+    job.reflectionBus_ = reflectionBus;
+    job.output_ = output;
+    job.deadline_ = deadline_ < 0.0f ? LLONG_MAX
+        : (jobStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(blockDuration*deadline_)).time_since_epoch().count();
+    nextSource_.store(static_cast<unsigned long long>(generation) << 32u, std::memory_order_relaxed);
+    numRenderedSources_.store(0, std::memory_order_relaxed);
+
+    // Open the job, publishing everything above to the workers
+    jobState_.store((generation << 1u) | 1u, std::memory_order_seq_cst);
+
+    // Wake workers up, the audio thread never waits for them to start
+    if (!workers_.empty())
+        wakeCondition_.notify_all();
+
+    // Take part in rendering
+    ProcessLane(0, generation);
+
+    // Close the job for workers that wake up late
+    jobState_.store(generation << 1u, std::memory_order_seq_cst);
+
+    // Reduce outputs of the workers that finish while the block lasts, the audio thread mixed into the output directly.
+    // Later ones are dropped rather than waited for, which would underrun the device. Lanes stuck in an earlier job are dropped right away
+    const long long dropTime = deadline_ < 0.0f ? LLONG_MAX : (jobStart + blockDuration).time_since_epoch().count();
+    for (unsigned laneIndex = 1; laneIndex < numLanes_; laneIndex++) {
+        Lane& lane = lanes_[laneIndex];
+        unsigned busyGeneration = lane.busyGeneration_.load(std::memory_order_seq_cst);
+        while (busyGeneration == generation && std::chrono::steady_clock::now().time_since_epoch().count() < dropTime) {
+            std::this_thread::yield();
+            busyGeneration = lane.busyGeneration_.load(std::memory_order_seq_cst);
+        }
+        if (busyGeneration != 0) {
+            numDroppedLaneBlocks_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        if (lane.generation_ == generation)
+            iplAudioBufferMix(phononContext, &lane.accumulation_[generation & 1u], output);
+        if (reflectionBus)
+            reflectionBus->ReduceLane(laneIndex);
+    }
+    if (reflectionBus)
+        reflectionBus->ReduceLane(0);
+}
+
+void SteamAudioMixWorkers::WaitForLateWorkers() const
+{
+    // Jobs opened after this see whatever the caller unpublished, only lanes inside earlier ones may still use it
+    const unsigned generation = jobState_.load(std::memory_order_seq_cst) >> 1u;
+    for (unsigned laneIndex = 1; laneIndex < numLanes_; laneIndex++) {
+        for (;;) {
+            // Generations wrap around, newer ones are less than half of the range ahead
+            const unsigned busyGeneration = lanes_[laneIndex].busyGeneration_.load(std::memory_order_acquire);
+            const unsigned age = (generation - busyGeneration) & (UINT_MAX >> 1u);
+            if (!busyGeneration || age > (UINT_MAX >> 2u))
+                break;
+            std::this_thread::yield();
+        }
+    }
+}
+
+void SteamAudioMixWorkers::ProcessLane(unsigned laneIndex, unsigned generation)
+{
+    Lane& lane = lanes_[laneIndex];
+
+    // Parameters of a job are only rewritten two jobs later. A lane that late fails to claim a source and discards them
+    const Job& job = jobs_[generation & 1u];
+    const ea::vector<SteamSoundSource*>& sources = *job.sources_;
+    const long long deadline = job.deadline_;
+
+    const SteamAudioMixContext mixContext {
+        .gain_ = job.gain_,
+        .bufferPool_ = lane.bufferPool_.get(),
+        .reflectionBus_ = job.reflectionBus_,
+        .lane_ = laneIndex
+    };
+
+    bool deadlineMissed = false;
+    unsigned long long claim = nextSource_.load(std::memory_order_relaxed);
+    for (;;) {
+        // Claim the next source of this job, reading it before the claim confirms the job is still current
+        if ((claim >> 32u) != generation)
+            break;
+        const unsigned index = static_cast<unsigned>(claim);
+        if (index >= sources.size())
+            break;
+        SteamSoundSource* source = sources[index];
+        if (!nextSource_.compare_exchange_weak(claim, claim + 1, std::memory_order_relaxed))
+            continue;
+        claim = claim + 1;
+
+        // Keep late sources in sync without rendering them
+        if (!deadlineMissed)
+            deadlineMissed = std::chrono::steady_clock::now().time_since_epoch().count() > deadline;
+        if (deadlineMissed) {
+            source->SkipAudioBuffer();
+            numSkippedSourceBlocks_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        // Generate audio buffer
+        auto audioBuffer = source->GenerateAudioBuffer(mixContext);
+
+        // Skip if none generated
+        if (!audioBuffer)
+            continue;
+        numRenderedSources_.fetch_add(1, std::memory_order_relaxed);
+
+        // Mix into lane output, cleared when used for the first time in this job
+        if (laneIndex == 0) {
+            iplAudioBufferMix(audio_->GetPhononContext(), audioBuffer, job.output_);
+            continue;
+        }
+        IPLAudioBuffer& accumulation = lane.accumulation_[generation & 1u];
+        if (lane.generation_ != generation) {
+            for (IPLint32 channel = 0; channel != accumulation.numChannels; channel++)
+                memset(accumulation.data[channel], 0, accumulation.numSamples*sizeof(float));
+            lane.generation_ = generation;
+        }
+        iplAudioBufferMix(audio_->GetPhononContext(), audioBuffer, &accumulation);
+    }
+}
+
+void SteamAudioMixWorkers::WorkerLoop(unsigned laneIndex)
+{
+    MixOutputScope scope;
+    Lane& lane = lanes_[laneIndex];
+
+    unsigned lastGeneration = jobState_.load(std::memory_order_acquire) >> 1u;
+    for (;;) {
+        // Sleep until there is a new job. A missed wake up only means the audio thread renders more sources itself
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wakeCondition_.wait(lock, [&] { return shutdown_ || (jobState_.load(std::memory_order_acquire) >> 1u) != lastGeneration; });
+            if (shutdown_)
+                return;
+        }
+
+        // Register first, then enter the job unless it was closed already. The audio thread does not reduce a registered lane.
+        // The job entered may be newer than the one that woke the worker up, it is rendered with its own generation
+        const unsigned state = jobState_.load(std::memory_order_seq_cst);
+        lastGeneration = state >> 1u;
+        if (!(state & 1u))
+            continue;
+        lane.busyGeneration_.store(lastGeneration, std::memory_order_seq_cst);
+        if (jobState_.load(std::memory_order_seq_cst) == state)
+            ProcessLane(laneIndex, lastGeneration);
+        lane.busyGeneration_.store(0, std::memory_order_release);
+    }
+}
+
 void RegisterSteamAudioLibrary(Context* context)
 {
     Sound::RegisterObject(context);
     SteamSoundListener::RegisterObject(context);
     SteamSoundSource::RegisterObject(context);
     SteamSoundMesh::RegisterObject(context);
+    SteamAudioProbeVolume::RegisterObject(context);
 }
 
 }
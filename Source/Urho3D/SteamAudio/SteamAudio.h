@@ -23,18 +23,62 @@
 #pragma once
 
 #include "../SteamAudio/SteamAudioDefs.h"
+#include "../Container/ByteVector.h"
+#include "../Container/RingBuffer.h"
+#include "../Container/TripleBuffer.h"
 #include "../Core/Object.h"
+#include "../IO/FileIdentifier.h"
+
+#include <EASTL/functional.h>
+#include <EASTL/shared_ptr.h>
+#include <EASTL/unordered_map.h>
 
 #include <phonon.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
 namespace Urho3D
 {
 
+class Serializer;
 class SteamAudioBufferPool;
+class SteamAudioMixWorkers;
+class SteamAudioReflectionBus;
+struct SteamAudioSimulationSource;
+struct SteamAudioStreamSource;
 class SteamSoundListener;
 class SteamSoundSource;
 class SteamSoundMesh;
 class SteamSoundBufferPool;
+class SoundStream;
+
+/// Counters of the audio and simulation threads.
+struct SteamAudioStats
+{
+    /// Duration of a block at the output sampling rate in milliseconds. Mixing must finish within it to avoid underruns.
+    float blockDuration_{};
+    /// Time spent mixing the last block in milliseconds.
+    float lastMixTime_{};
+    /// Longest time spent mixing a block since the counters were reset, in milliseconds.
+    float maxMixTime_{};
+    /// Number of blocks mixed.
+    unsigned numBlocks_{};
+    /// Number of blocks that took longer than the block duration to mix.
+    unsigned numLateBlocks_{};
+    /// Number of blocks output as silence because there was no listener or mixing was not set up.
+    unsigned numSilentBlocks_{};
+    /// Number of source blocks skipped because mixing missed its deadline.
+    unsigned numSkippedSourceBlocks_{};
+    /// Number of blocks of mix workers dropped because they were still rendering when the block had to be output.
+    unsigned numDroppedWorkerBlocks_{};
+    /// Number of times the simulation task queue was contended.
+    unsigned numSimulationLockContentions_{};
+    /// Number of sound sources rendered in the last block.
+    unsigned numActiveSources_{};
+};
 
 /// %Audio subsystem.
 class URHO3D_API SteamAudio : public Object
@@ -47,8 +91,8 @@ public:
     /// Destruct. Terminate the audio thread and free the audio buffer.
     ~SteamAudio() override;
 
-    /// Initialize sound output with specified buffer length and output mode.
-    bool SetMode(int mixRate, SpeakerMode mode);
+    /// Initialize sound output with specified sampling rate, output mode and block size in sample frames. Block size is rounded up to a power of two between 64 and 4096, smaller blocks lower latency at a higher per-block cost. Simulation rates do not depend on it.
+    bool SetMode(int mixRate, SpeakerMode mode, unsigned frameSize = 1024);
     /// Re-initialize sound output with same parameters.
     bool RefreshMode();
     /// Shutdown this audio device, likely because we've lost it.
@@ -74,6 +118,103 @@ public:
     void SetImpulseResponseDuration(float duration = 2.0f);
     /// Returns impulse response duration.
     float ImpulseResponseDuration() const { return sharedInputs_.duration; }
+    /// Set algorithm rendering reflections of sound sources that do not choose their own. Sound sources may only choose their own if the type is hybrid, for which both impulse responses and reverb times are simulated. Takes effect on next SetMode().
+    void SetReflectionEffectType(ReflectionEffectType type) { reflectionEffectType_ = type == RET_DEFAULT ? RET_CONVOLUTION : type; }
+    /// Return requested reflection algorithm.
+    ReflectionEffectType GetReflectionEffectType() const { return reflectionEffectType_; }
+    /// Return reflection algorithm a sound source requesting the given one renders with.
+    IPLReflectionEffectType ResolveReflectionEffectType(ReflectionEffectType requested) const;
+    /// Set how reflections are decoded and the ambisonics order of the shared reflection bus. Effects of all sound sources are recreated.
+    void SetReflectionMixMode(ReflectionMixMode mode, unsigned busAmbisonicsOrder = 1);
+    /// Return how reflections are decoded.
+    ReflectionMixMode GetReflectionMixMode() const { return reflectionMixMode_; }
+    /// Return ambisonics order of the shared reflection bus.
+    unsigned GetReflectionBusOrder() const { return reflectionBusOrder_; }
+    /// Set number of audio worker threads rendering sound sources in parallel with the audio thread, and the fraction of a block after which no new sources are started.
+    void SetMixWorkers(unsigned numWorkers, float deadline = 0.75f);
+    /// Return number of audio worker threads.
+    unsigned GetNumMixWorkers() const { return numMixWorkers_; }
+    /// Return number of source blocks skipped so far because mixing missed its deadline.
+    unsigned GetNumSkippedSourceBlocks() const;
+    /// Return counters of the audio and simulation threads.
+    SteamAudioStats GetStats() const;
+    /// Reset block counters and the longest mix time.
+    void ResetStats();
+    /// Set how often direct and reflection simulations run, in Hz.
+    void SetSimulationRates(float directRate, float reflectionRate);
+    /// Return direct simulation rate in Hz.
+    float GetDirectSimulationRate() const { return directSimulationRate_.load(std::memory_order_relaxed); }
+    /// Return reflection simulation rate in Hz.
+    float GetReflectionSimulationRate() const { return reflectionSimulationRate_.load(std::memory_order_relaxed); }
+    /// Set maximum number of scene commits per second. Mesh changes in between are coalesced into the next commit.
+    void SetSceneCommitRate(float rate);
+    /// Return maximum number of scene commits per second.
+    float GetSceneCommitRate() const { return sceneCommitRate_.load(std::memory_order_relaxed); }
+    /// Set how far, in world units, and how much, in degrees, dynamic meshes must move before their transform is updated.
+    void SetTransformTolerance(float distance, float angle);
+    /// Return how far dynamic meshes must move before their transform is updated.
+    float GetTransformDistanceTolerance() const { return transformDistanceTolerance_; }
+    /// Return how much dynamic meshes must turn before their transform is updated.
+    float GetTransformAngleTolerance() const { return transformAngleTolerance_; }
+    /// Return number of scene commits so far.
+    unsigned GetNumSceneCommits() const { return numSceneCommits_.load(std::memory_order_relaxed); }
+    /// Return duration of the last scene commit in milliseconds.
+    float GetLastSceneCommitTime() const { return lastSceneCommitTime_.load(std::memory_order_relaxed); }
+    /// Set maximum number of sound sources rendered in full, 0 for no limit, which is the default. Quieter sources of lower priority become virtual and only advance their playback position.
+    void SetMaxRealVoices(unsigned maxVoices) { maxRealVoices_ = maxVoices; }
+    /// Return maximum number of sound sources rendered in full.
+    unsigned GetMaxRealVoices() const { return maxRealVoices_; }
+    /// Return number of sound sources that were made virtual in the last update.
+    unsigned GetNumVirtualVoices() const { return numVirtualVoices_; }
+    /// Set listener distances beyond which sound sources use reduced and minimal effect LOD, 0 to disable.
+    void SetEffectLodDistances(float reducedDistance, float minimalDistance);
+    /// Return distance beyond which sound sources use reduced effect LOD.
+    float GetEffectLodReducedDistance() const { return effectLodReducedDistance_; }
+    /// Return distance beyond which sound sources use minimal effect LOD.
+    float GetEffectLodMinimalDistance() const { return effectLodMinimalDistance_; }
+    /// Set mix time per block in milliseconds above which the least important sound sources are lowered by one effect LOD, 0 to disable.
+    void SetEffectBudget(float milliseconds);
+    /// Return mix time budget per block in milliseconds.
+    float GetEffectBudget() const { return effectBudget_; }
+    /// Return number of playing sound sources currently allowed their distance based effect LOD under the budget.
+    unsigned GetEffectLodQuota() const { return effectLodQuota_; }
+    /// Return number of sources the simulator has room for. Grows as sources are added.
+    unsigned GetSimulatorCapacity() const { return simulatorCapacity_.load(std::memory_order_relaxed); }
+    /// Set directory where serialized static meshes are cached between runs. Empty to only cache in memory.
+    void SetStaticMeshCacheDir(const FileIdentifier& dir) { staticMeshCacheDir_ = dir; }
+    /// Return directory where serialized static meshes are cached between runs.
+    const FileIdentifier& GetStaticMeshCacheDir() const { return staticMeshCacheDir_; }
+    /// Set grid cell size used to simplify the static batch by vertex clustering, 0 to keep full detail.
+    void SetStaticBatchSimplification(float cellSize);
+    /// Return grid cell size used to simplify the static batch.
+    float GetStaticBatchSimplification() const { return staticBatchCellSize_; }
+    /// Return number of triangles of static meshes before simplification.
+    unsigned GetNumStaticSourceTriangles() const { return numStaticSourceTriangles_; }
+    /// Return number of triangles in the static batch.
+    unsigned GetNumStaticBatchTriangles() const { return numStaticBatchTriangles_; }
+    /// Return number of times the static batch was rebuilt.
+    unsigned GetNumStaticBatchRebuilds() const { return numStaticBatchRebuilds_; }
+    /// Return number of distinct static mesh geometries kept for static batch rebuilds.
+    unsigned GetNumCachedStaticGeometries() const { return staticGeometryCache_.size(); }
+    /// Set ray tracer used for the acoustic scene. Takes effect on next SetMode().
+    void SetRayTracer(RayTracerType type) { rayTracer_ = type; }
+    /// Return requested ray tracer.
+    RayTracerType GetRayTracer() const { return rayTracer_; }
+    /// Return ray tracer in use, which differs from the requested one if it is unavailable.
+    RayTracerType GetActiveRayTracer() const { return sceneSettings_.type == IPL_SCENETYPE_EMBREE ? RTT_EMBREE : RTT_DEFAULT; }
+    /// Set whether simulation runs on its own thread instead of in Update(). Takes effect on next SetMode().
+    void SetSimulationThreaded(bool threaded) { simulationThreaded_ = threaded; }
+    /// Return whether simulation runs on its own thread.
+    bool IsSimulationThreaded() const { return simulationThreaded_; }
+
+    /// Set output device. Takes effect on next SetMode().
+    void SetOutputDevice(OutputDeviceType type) { outputDevice_ = type; }
+    /// Return requested output device.
+    OutputDeviceType GetOutputDevice() const { return outputDevice_; }
+    /// Render blocks with the null device and append interleaved samples. The subsystem, its components and simulations advance by one block each, on the calling thread and a clock independent of wall time. No render update events are sent. Return false if the null device is not active.
+    bool RenderOffline(unsigned numBlocks, ea::vector<float>& dest);
+    /// Render blocks with the null device and write them as a 16-bit WAV file. Return false if the null device is not active or writing failed.
+    bool RenderOfflineWav(unsigned numBlocks, Serializer& dest);
 
     /// Return phonon context.
     IPLContext GetPhononContext() const { return phononContext_; }
@@ -81,20 +222,20 @@ public:
     IPLHRTF GetHRTF() const { return hrtf_; }
     /// Return scene.
     IPLScene GetScene() const { return scene_; }
+    /// Return settings the scene was created with. Sub-scenes must use the same ones.
+    const IPLSceneSettings& GetSceneSettings() const { return sceneSettings_; }
     /// Return phonon audio settings.
     const IPLAudioSettings& GetAudioSettings() const { return audioSettings_; }
-    /// Return audio buffer pool.
-    SteamAudioBufferPool& GetAudioBufferPool() { return *audioBufferPool_; }
-    /// Return simulator.
+    /// Return simulator. It is recreated when it runs out of sources, only use it from simulation tasks.
     IPLSimulator GetSimulator() { return simulator_; }
-    /// Return simulator outputs.
-    bool GetSimulatorOutputs(IPLSource source, IPLSimulationOutputs& outputs) noexcept;
     /// Return channel count.
     /// @property
     unsigned GetChannelCount() const { return channelCount_; }
-    /// Return byte size of one frame.
+    /// Return number of sample frames in one block.
     /// @property
     unsigned GetFrameSize() const { return audioSettings_.frameSize; }
+    /// Return number of heap allocations Steam Audio performed on the audio thread while mixing. Should stay constant during steady-state playback.
+    unsigned GetNumMixAllocations() const;
 
     /// Return master gain for a specific sound source type. Unknown sound types will return full gain (1).
     /// @property
@@ -109,9 +250,39 @@ public:
     SteamSoundListener* GetListener() const;
 
     /// Mark scene dirty (after changes)
-    void MarkSceneDirty() { sceneDirty_ = true; }
+    void MarkSceneDirty() { sceneDirty_.store(true, std::memory_order_relaxed); }
     /// Mark scene simulator (after changes)
-    void MarkSimulatorDirty() { simulatorDirty_ = true; }
+    void MarkSimulatorDirty() { simulatorDirty_.store(true, std::memory_order_relaxed); }
+
+    /// Queue a task that modifies the scene or the simulator. Tasks run in order before the next simulation, on the simulation thread if there is one.
+    void QueueSimulationTask(ea::function<void()> task);
+    /// Add a source to the simulation. Called by SteamSoundSource.
+    void AddSimulationSource(const ea::shared_ptr<SteamAudioSimulationSource>& source);
+    /// Remove a source from the simulation. Called by SteamSoundSource.
+    void RemoveSimulationSource(const ea::shared_ptr<SteamAudioSimulationSource>& source);
+    /// Add a probe batch with baked data to the simulation. Called by SteamAudioProbeVolume.
+    void AddProbeBatch(IPLProbeBatch probeBatch);
+    /// Remove a probe batch from the simulation. Called by SteamAudioProbeVolume.
+    void RemoveProbeBatch(IPLProbeBatch probeBatch);
+    /// Load a static mesh from the static mesh cache into a scene. Return null if it is not cached.
+    IPLStaticMesh LoadStaticMesh(const SteamAudioStaticMeshKey& key, IPLScene scene);
+    /// Store a static mesh in the static mesh cache, in memory and in the cache directory.
+    void SaveStaticMesh(const SteamAudioStaticMeshKey& key, IPLStaticMesh staticMesh);
+    /// Add a mesh to the static batch. Called by SteamSoundMesh.
+    void AddStaticMesh(SteamSoundMesh* mesh);
+    /// Remove a mesh from the static batch. Called by SteamSoundMesh.
+    void RemoveStaticMesh(SteamSoundMesh* mesh);
+    /// Mark static batch dirty. It is rebuilt on next update.
+    void MarkStaticBatchDirty() { staticBatchDirty_ = true; }
+    /// Export the scene as OBJ once pending changes are committed, for debugging.
+    void SaveSceneOBJ(const ea::string& fileBaseName);
+    /// Run a task after all queued ones, with their changes committed, and wait for it to finish. Simulation is stalled meanwhile.
+    void RunSimulationTaskAndWait(const ea::function<void()>& task);
+
+    /// Add a stream to be kept decoded ahead of playback by the decoder thread. Called by SteamSoundSource.
+    void AddStreamSource(const ea::shared_ptr<SteamAudioStreamSource>& source);
+    /// Remove a stream from the decoder thread. The stream is no longer decoded once this returns. Called by SteamSoundSource.
+    void RemoveStreamSource(const ea::shared_ptr<SteamAudioStreamSource>& source);
 
     /// Return all sound sources.
     const ea::vector<SteamSoundSource*>& GetSoundSources() const { return soundSources_; }
@@ -120,18 +291,113 @@ public:
     /// Remove a sound source. Called by SteamSoundSource.
     void RemoveSoundSource(SteamSoundSource* soundSource);
 
-    /// Return audio thread mutex.
+    /// Return mutex guarding the sound source list. Never locked by the audio thread.
     Mutex& GetMutex() { return audioMutex_; }
 
-    /// Mix sound sources into the buffer.
+    /// Wait until the audio thread has finished the block it is currently mixing, if any, and mix workers late for earlier blocks are done. Data unpublished before the call is no longer accessed afterwards.
+    void SynchronizeWithAudioThread() const;
+
+    /// Mix sound sources into the buffer. Never blocks.
     void MixOutput(float *dest) noexcept;
 
     /// Returns channel count of ambisonics order up to 6
     static unsigned ChannelCount(unsigned order);
 
 private:
+    class SimulationThread;
+    class DecoderThread;
+
+    /// State shared with the simulation thread.
+    struct SimulationState
+    {
+        /// Listener and reflection settings.
+        IPLSimulationSharedInputs sharedInputs_{};
+        /// Is there an active listener?
+        bool hasListener_{};
+        /// Is reflection simulation active?
+        bool simulateReflections_{};
+    };
+
+    /// State shared with the audio thread.
+    struct MixState
+    {
+        /// Sound sources to mix.
+        ea::vector<SteamSoundSource*> soundSources_;
+        /// Master gain.
+        float masterGain_{1.0f};
+        /// Is there an active listener?
+        bool hasListener_{};
+        /// Shared reflection bus, null unless mixing reflections into a shared bus.
+        SteamAudioReflectionBus* reflectionBus_{};
+        /// Workers rendering sound sources.
+        SteamAudioMixWorkers* mixWorkers_{};
+    };
+
+    /// Serialized static mesh with the key it was built for.
+    struct CachedStaticMesh
+    {
+        /// Key including vertex and index counts, a different key with the same hash is a collision.
+        SteamAudioStaticMeshKey key_;
+        /// Serialized phonon static mesh.
+        ByteVector data_;
+    };
+
+    /// Model space geometry of static meshes with the key it was extracted for.
+    struct CachedStaticGeometry
+    {
+        /// Key including vertex and index counts, a different key with the same hash is a collision.
+        SteamAudioStaticMeshKey key_;
+        /// Extracted geometry.
+        SteamAudioStaticGeometry geometry_;
+        /// Whether a static mesh used it during the current rebuild.
+        bool used_{};
+    };
+
+    /// Playing sound source considered by voice management.
+    struct Voice
+    {
+        /// Sound source.
+        SteamSoundSource* source_{};
+        /// Priority, higher is kept real first.
+        int priority_{};
+        /// Estimated loudness at the listener.
+        float audibility_{};
+        /// Effect LOD chosen by distance.
+        EffectLOD effectLod_{};
+    };
+
     /// Returns simulation flags.
     IPLSimulationFlags SimulationFlags() const;
+    /// Publish sound sources, master gain and listener state to the audio thread. Audio mutex must be locked.
+    void UnlockedPublishMixState();
+    /// Recreate mix workers and reflection bus after their settings changed. Effects of all sound sources are recreated.
+    void RecreateMixResources();
+    /// Merge all static meshes into a single phonon static mesh and replace the previous batch.
+    void RebuildStaticBatch();
+    /// Return model space geometry of a static mesh, extracting it only for models not seen before.
+    const SteamAudioStaticGeometry& GetStaticGeometry(const SteamSoundMesh* mesh);
+    /// Rank playing sound sources, choose their effect LOD and make those beyond the real voice limit virtual. Audio mutex must be locked.
+    void UnlockedUpdateVoices();
+    /// Adapt the number of sound sources allowed full effect LOD to the mix time budget.
+    void UpdateEffectLodQuota(unsigned numVoices);
+    /// Recreate the simulator with twice the source capacity and move all sources over. Called from the simulation thread.
+    void GrowSimulator();
+    /// Release the simulator and sources replaced by GrowSimulator() once the audio thread no longer uses their outputs. Called from the simulation thread.
+    void ReleaseRetiredSimulator();
+    /// Run queued simulation tasks and commit changes. Called from the simulation thread.
+    void RunSimulationTasks();
+    /// Acquire the simulation task mutex, counting contention.
+    void AcquireSimulationTasksMutex();
+    /// Commit scene and simulator changes. Scene commits are rate-limited unless forced. Called from the simulation thread.
+    void CommitSimulationChanges(bool force = false);
+    /// Run queued simulation tasks and due simulations. Return seconds until the next simulation is due. Called from the simulation thread.
+    float RunSimulation();
+
+    /// Top up buffers of all streams. Called from the decoder thread.
+    void DecodeStreams();
+
+    /// Return current time for simulation scheduling. Advances by whole blocks with the null device.
+    std::chrono::steady_clock::time_point GetSimulationTime() const;
 
     /// Handle render update event.
     void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
@@ -142,12 +408,28 @@ private:
     IPLContext phononContext_{};
     /// Phonon simulator.
     IPLSimulator simulator_{};
+    /// Simulator replaced by a grown one. Owned by the simulation thread.
+    IPLSimulator retiredSimulator_{};
+    /// Sources of the retired simulator, published outputs still point into them. Owned by the simulation thread.
+    ea::vector<IPLSource> retiredSources_;
+    /// Settings the simulator was created with. Owned by the simulation thread once it runs.
+    IPLSimulationSettings simulationSettings_{};
+    /// Number of sources the simulator has room for.
+    std::atomic<unsigned> simulatorCapacity_{};
     /// Phonon audio settings.
     IPLAudioSettings audioSettings_{};
     /// Phonon HRTF.
     IPLHRTF hrtf_{};
     /// Phonon final output frame buffer.
     IPLAudioBuffer phononFrameBuffer_{};
+    /// Requested reflection algorithm.
+    ReflectionEffectType reflectionEffectType_{RET_CONVOLUTION};
+    /// Requested ray tracer.
+    RayTracerType rayTracer_{RTT_DEFAULT};
+    /// Embree device, if Embree is in use.
+    IPLEmbreeDevice embreeDevice_{};
+    /// Settings the scene was created with.
+    IPLSceneSettings sceneSettings_{};
     /// Phonon scene.
     IPLScene scene_{};
     /// Simulation inputs.
@@ -155,25 +437,193 @@ private:
     /// Is reflection simulation active?
     bool simulateReflections_{};
     /// Is phonon scene dirty?
-    bool sceneDirty_{};
+    std::atomic<bool> sceneDirty_{};
     /// Is simulator dirty?
-    bool simulatorDirty_{};
+    std::atomic<bool> simulatorDirty_{};
+    /// Direct simulation rate in Hz.
+    std::atomic<float> directSimulationRate_{60.0f};
+    /// Reflection simulation rate in Hz.
+    std::atomic<float> reflectionSimulationRate_{10.0f};
+    /// Maximum number of scene commits per second.
+    std::atomic<float> sceneCommitRate_{20.0f};
+    /// Time of the next allowed scene commit. Owned by the simulation thread.
+    std::chrono::steady_clock::time_point nextSceneCommit_{};
+    /// Number of scene commits so far.
+    std::atomic<unsigned> numSceneCommits_{};
+    /// Duration of the last scene commit in milliseconds.
+    std::atomic<float> lastSceneCommitTime_{};
+    /// How far dynamic meshes must move before their transform is updated.
+    float transformDistanceTolerance_{0.01f};
+    /// How much dynamic meshes must turn before their transform is updated, in degrees.
+    float transformAngleTolerance_{0.5f};
+    /// Requested output device.
+    OutputDeviceType outputDevice_{ODT_SDL};
+    /// Is the SDL audio device open?
+    bool deviceOpen_{};
+    /// Is the null device active? Simulation and decoding then run inline and mixing is single-threaded.
+    bool offline_{};
+    /// Time advanced by rendered blocks with the null device.
+    std::chrono::steady_clock::time_point offlineTime_{};
+    /// Should simulation run on its own thread?
+    bool simulationThreaded_{true};
+    /// Simulation thread.
+    ea::unique_ptr<SimulationThread> simulationThread_;
+    /// State published to the simulation thread.
+    TripleBuffer<SimulationState> simulationState_;
+    /// Pending simulation tasks mutex. Never held while running tasks.
+    Mutex simulationTasksMutex_;
+    /// Pending simulation tasks.
+    ea::vector<ea::function<void()>> simulationTasks_;
+    /// Simulation tasks being run. Owned by the simulation thread.
+    ea::vector<ea::function<void()>> runningSimulationTasks_;
+    /// Simulated sources. Owned by the simulation thread.
+    ea::vector<ea::shared_ptr<SteamAudioSimulationSource>> simulationSources_;
+    /// Probe batches with baked data. Owned by the simulation thread.
+    ea::vector<IPLProbeBatch> probeBatches_;
+    /// Time of the next direct simulation. Owned by the simulation thread.
+    std::chrono::steady_clock::time_point nextDirectSimulation_{};
+    /// Time of the next reflection simulation. Owned by the simulation thread.
+    std::chrono::steady_clock::time_point nextReflectionSimulation_{};
+    /// Directory where serialized static meshes are cached between runs.
+    FileIdentifier staticMeshCacheDir_;
+    /// Serialized static meshes by cache key hash.
+    ea::unordered_map<unsigned long long, CachedStaticMesh> staticMeshCache_;
+    /// Model space geometry of static meshes by cache key hash, so rebuilds only transform it.
+    ea::unordered_map<unsigned long long, CachedStaticGeometry> staticGeometryCache_;
+    /// Meshes merged into the static batch.
+    ea::vector<SteamSoundMesh*> staticMeshes_;
+    /// Static batch in the scene.
+    IPLStaticMesh staticBatch_{};
+    /// Is the static batch dirty?
+    bool staticBatchDirty_{};
+    /// Grid cell size used to simplify the static batch, 0 if disabled.
+    float staticBatchCellSize_{};
+    /// Number of triangles of static meshes before simplification.
+    unsigned numStaticSourceTriangles_{};
+    /// Number of triangles in the static batch.
+    unsigned numStaticBatchTriangles_{};
+    /// Number of static batch rebuilds.
+    unsigned numStaticBatchRebuilds_{};
+    /// Decoder thread.
+    ea::unique_ptr<DecoderThread> decoderThread_;
+    /// Stream list mutex. Held by the decoder thread while decoding.
+    Mutex streamSourcesMutex_;
+    /// Streams kept decoded ahead of playback.
+    ea::vector<ea::shared_ptr<SteamAudioStreamSource>> streamSources_;
+    /// How reflections are decoded.
+    ReflectionMixMode reflectionMixMode_{RMM_PER_SOURCE};
+    /// Ambisonics order of the shared reflection bus.
+    unsigned reflectionBusOrder_{1};
+    /// Shared reflection bus.
+    ea::unique_ptr<SteamAudioReflectionBus> reflectionBus_;
+    /// Number of audio worker threads.
+    unsigned numMixWorkers_{};
+    /// Fraction of a block after which no new sources are started.
+    float mixDeadline_{0.75f};
+    /// Audio worker threads.
+    ea::unique_ptr<SteamAudioMixWorkers> mixWorkers_;
+    /// Number of mix allocations already reported.
+    unsigned numReportedMixAllocations_{};
     /// Interleaved output frame buffer for SDL.
     ea::vector<float> finalFrameBuffer_{};
-    /// Audio thread mutex.
+    /// Sound source list mutex.
     Mutex audioMutex_;
-    /// Simulator mutex.
-    Mutex simulatorMutex_;
+    /// State published to the audio thread.
+    TripleBuffer<MixState> mixState_;
+    /// Number of started and finished audio blocks. Odd while the audio thread is mixing.
+    std::atomic<unsigned> mixGeneration_{};
+    /// Time spent mixing the last block in milliseconds.
+    std::atomic<float> lastMixTime_{};
+    /// Duration of a block at the output sampling rate in milliseconds.
+    float blockDuration_{};
+    /// Longest time spent mixing a block in milliseconds.
+    std::atomic<float> maxMixTime_{};
+    /// Number of blocks mixed.
+    std::atomic<unsigned> numMixedBlocks_{};
+    /// Number of blocks that took longer than the block duration to mix.
+    std::atomic<unsigned> numLateBlocks_{};
+    /// Number of blocks output as silence.
+    std::atomic<unsigned> numSilentBlocks_{};
+    /// Number of sound sources rendered in the last block.
+    std::atomic<unsigned> numActiveSources_{};
+    /// Number of times the simulation task queue was contended.
+    std::atomic<unsigned> numSimulationLockContentions_{};
     /// Channel count
     unsigned channelCount_{};
     /// Master gain.
     float masterGain_{};
     /// Sound sources.
     ea::vector<SteamSoundSource*> soundSources_;
+    /// Maximum number of sound sources rendered in full, 0 for no limit.
+    unsigned maxRealVoices_{};
+    /// Number of sound sources made virtual in the last update.
+    unsigned numVirtualVoices_{};
+    /// Playing sound sources being ranked. Reused every update.
+    ea::vector<Voice> voiceRanking_;
+    /// Distance beyond which sound sources use reduced effect LOD, 0 if disabled.
+    float effectLodReducedDistance_{};
+    /// Distance beyond which sound sources use minimal effect LOD, 0 if disabled.
+    float effectLodMinimalDistance_{};
+    /// Mix time budget per block in milliseconds, 0 if disabled.
+    float effectBudget_{};
+    /// Smoothed mix time per block in milliseconds.
+    float smoothedMixTime_{};
+    /// Number of sound sources allowed their distance based effect LOD.
+    unsigned effectLodQuota_{M_MAX_UNSIGNED};
     /// Sound listener.
     WeakPtr<SteamSoundListener> listener_;
-    /// Audio buffer pool.
-    ea::unique_ptr<SteamAudioBufferPool> audioBufferPool_;
+};
+
+/// Simulation state of a sound source, shared between main, simulation and audio threads.
+struct SteamAudioSimulationSource
+{
+    /// Construct. The phonon source is created once the source is added to the simulation.
+    explicit SteamAudioSimulationSource(IPLSimulationFlags flags);
+    /// Destruct and release the phonon source.
+    ~SteamAudioSimulationSource();
+
+    /// Create the phonon source for a simulator, releasing the previous one. Called from the simulation thread.
+    void CreateSource(IPLSimulator simulator);
+    /// Release the phonon source. Called from the simulation thread.
+    void ReleaseSource();
+
+    /// Phonon source. Owned by the simulation thread.
+    IPLSource source_{};
+    /// Simulations the source takes part in.
+    IPLSimulationFlags flags_{};
+    /// Inputs published by the main thread.
+    TripleBuffer<IPLSimulationInputs> inputs_;
+    /// Outputs published by the simulation thread.
+    TripleBuffer<IPLSimulationOutputs> outputs_;
+    /// Latest outputs. Owned by the simulation thread.
+    IPLSimulationOutputs lastOutputs_{};
+};
+
+/// Sound stream decoded ahead of playback, shared between main, decoder and audio threads.
+struct SteamAudioStreamSource
+{
+    /// Construct with buffer capacity in samples.
+    SteamAudioStreamSource(SoundStream* stream, unsigned capacity);
+    /// Destruct.
+    ~SteamAudioStreamSource();
+
+    /// Decode until the buffer is full or the stream runs dry. Called from the decoder thread.
+    void Decode();
+
+    /// Stream. Only accessed by the decoder thread once added.
+    SharedPtr<SoundStream> stream_;
+    /// Decoded interleaved samples, written by the decoder thread and read by the audio thread.
+    RingBuffer<float> buffer_;
+    /// Raw data produced by the stream.
+    ea::vector<signed char> rawBuffer_;
+    /// Raw data converted to float.
+    ea::vector<float> decodeBuffer_;
+    /// Should the looping of the stream follow loop_?
+    bool controlsLoop_{};
+    /// Should the stream rewind at its end?
+    std::atomic<bool> loop_{};
+    /// Has the stream ended? Remaining buffered samples are still played.
+    std::atomic<bool> finished_{};
 };
 
 /// %Audio buffer pool.
@@ -198,6 +648,151 @@ private:
     ea::array<IPLAudioBuffer, 4> buffers_;
 };
 
+/// State of the thread rendering a sound source.
+struct SteamAudioMixContext
+{
+    /// Gain applied on top of source gain.
+    float gain_{1.0f};
+    /// Scratch buffers owned by the thread.
+    SteamAudioBufferPool* bufferPool_{};
+    /// Shared reflection bus, if any.
+    SteamAudioReflectionBus* reflectionBus_{};
+    /// Index of the mixing thread, 0 is the audio thread.
+    unsigned lane_{};
+};
+
+/// Shared ambisonics bus for reflections of all sound sources, decoded to the output once per block.
+class SteamAudioReflectionBus {
+    SteamAudio *audio_;
+
+public:
+    SteamAudioReflectionBus(SteamAudio* audio, unsigned ambisonicsOrder, unsigned numLanes);
+    ~SteamAudioReflectionBus();
+
+    /// Mix reflections of a single source into the bus. Convolution goes through the reflection mixer of the lane, parametric and hybrid reverb through its lane buffer. Input must be mono. Each lane may be used by one thread at a time.
+    void Mix(unsigned lane, IPLReflectionEffect effect, IPLReflectionEffectParams& params, IPLAudioBuffer* input, IPLAudioBuffer* scratch);
+    /// Add reflections a source already rendered in time domain to the lane buffer. Each lane may be used by one thread at a time.
+    void MixRendered(unsigned lane, IPLAudioBuffer* reflections);
+    /// Sum up reflections mixed by a lane and clear it. Called from the audio thread once the lane finished the block.
+    void ReduceLane(unsigned lane);
+    /// Decode reflections summed up since the last call and add them to the output.
+    void Decode(IPLAudioBuffer* output);
+
+    /// Return ambisonics order.
+    unsigned GetAmbisonicsOrder() const { return ambisonicsOrder_; }
+    /// Return channel count.
+    unsigned GetChannelCount() const { return buffer_.numChannels; }
+
+private:
+    /// Ambisonics order.
+    unsigned ambisonicsOrder_;
+    /// Reflection mixers used for convolution reverb, one per lane.
+    ea::vector<IPLReflectionMixer> mixers_;
+    /// Ambisonics buses accumulating reflections not handled by the mixers, one per lane.
+    ea::vector<IPLAudioBuffer> laneBuffers_;
+    /// Ambisonics decoder.
+    IPLAmbisonicsBinauralEffect decoder_{};
+    /// Ambisonics bus summing up the reduced lanes.
+    IPLAudioBuffer buffer_{};
+    /// Output of a reflection mixer.
+    IPLAudioBuffer mixerBuffer_{};
+    /// Decoded bus.
+    IPLAudioBuffer output_{};
+};
+
+/// Audio worker threads rendering sound sources in parallel. The audio thread takes part in mixing as lane 0.
+class SteamAudioMixWorkers {
+    SteamAudio *audio_;
+
+public:
+    /// Construct. Negative deadline renders all sources regardless of time spent and always waits for the workers.
+    SteamAudioMixWorkers(SteamAudio* audio, unsigned numWorkers, float deadline);
+    ~SteamAudioMixWorkers();
+
+    /// Mix sound sources into the output. Sources not started before the deadline only advance their playback position. Output of workers still rendering once the block duration has passed is dropped instead of waited for. Called from the audio thread.
+    void Mix(const ea::vector<SteamSoundSource*>& sources, float gain, SteamAudioReflectionBus* reflectionBus, IPLAudioBuffer* output);
+    /// Wait until no worker renders a job opened before this call. Called from the main thread before sources or their effects are released.
+    void WaitForLateWorkers() const;
+
+    /// Return number of lanes, including the audio thread.
+    unsigned GetNumLanes() const { return numLanes_; }
+    /// Return number of source blocks skipped so far because the deadline was missed.
+    unsigned GetNumSkippedSourceBlocks() const { return numSkippedSourceBlocks_.load(std::memory_order_relaxed); }
+    /// Return number of lane blocks dropped so far because a worker was still rendering at the end of the block.
+    unsigned GetNumDroppedLaneBlocks() const { return numDroppedLaneBlocks_.load(std::memory_order_relaxed); }
+    /// Return number of sources that generated sound in the last job. Called from the audio thread.
+    unsigned GetNumRenderedSources() const { return numRenderedSources_.load(std::memory_order_relaxed); }
+
+private:
+    class WorkerThread;
+
+    /// Parameters of a job.
+    struct Job
+    {
+        /// Sources to render.
+        const ea::vector<SteamSoundSource*>* sources_{};
+        /// Gain.
+        float gain_{};
+        /// Reflection bus.
+        SteamAudioReflectionBus* reflectionBus_{};
+        /// Output, only mixed into by the audio thread.
+        IPLAudioBuffer* output_{};
+        /// Time after which no new sources are started, in steady clock ticks.
+        long long deadline_{};
+    };
+
+    /// Per-thread mixing state.
+    struct Lane
+    {
+        /// Scratch buffers.
+        ea::unique_ptr<SteamAudioBufferPool> bufferPool_;
+        /// Accumulated output of the sources rendered by this lane, one per job generation parity. A lane late for one job never writes to the buffer of the next. Unused by the audio thread.
+        IPLAudioBuffer accumulation_[2]{};
+        /// Job generation the accumulation buffer of its parity was cleared for. Written by the lane while busy.
+        unsigned generation_{};
+        /// Generation of the job the lane is inside, 0 while idle. The audio thread only reduces idle lanes.
+        std::atomic<unsigned> busyGeneration_{};
+    };
+
+    /// Render sources of the job of given generation until none are left or the deadline passed.
+    void ProcessLane(unsigned lane, unsigned generation);
+    /// Worker thread body.
+    void WorkerLoop(unsigned lane);
+
+    /// Lanes, lane 0 is the audio thread.
+    ea::unique_ptr<Lane[]> lanes_;
+    /// Number of lanes.
+    unsigned numLanes_{};
+    /// Worker threads.
+    ea::vector<ea::unique_ptr<WorkerThread>> workers_;
+    /// Fraction of a block after which no new sources are started.
+    float deadline_;
+
+    /// Parameters of the last two jobs, indexed by generation parity. Lanes late for a job keep reading their own.
+    Job jobs_[2];
+    /// Generation of the current job in the upper half and index of the next source to render in the lower half.
+    /// Sources are claimed together with the generation, so a late lane never claims a source of the next job.
+    std::atomic<unsigned long long> nextSource_{};
+    /// Generation of the last job, never 0. Owned by the audio thread.
+    unsigned jobGeneration_{};
+    /// Generation of the last job shifted left by one, the lowest bit is set while workers may enter it.
+    /// A single word so that workers never pair the open flag of one job with the generation of another.
+    std::atomic<unsigned> jobState_{};
+    /// Number of source blocks skipped because the deadline was missed.
+    std::atomic<unsigned> numSkippedSourceBlocks_{};
+    /// Number of lane blocks dropped because a worker was late.
+    std::atomic<unsigned> numDroppedLaneBlocks_{};
+    /// Number of sources that generated sound in the current job.
+    std::atomic<unsigned> numRenderedSources_{};
+
+    /// Mutex for sleeping workers. Never locked by the audio thread.
+    std::mutex wakeMutex_;
+    /// Wakes up sleeping workers.
+    std::condition_variable wakeCondition_;
+    /// Are workers shutting down?
+    bool shutdown_{};
+};
+
 /// Register Audio library objects.
 /// @nobind
 void URHO3D_API RegisterSteamAudioLibrary(Context* context);
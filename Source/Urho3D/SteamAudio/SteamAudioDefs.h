@@ -23,10 +23,77 @@
 #pragma once
 
 #include "../Audio/AudioDefs.h"
+#include "../Math/Vector3.h"
+
+#include <EASTL/vector.h>
 
 namespace Urho3D
 {
 
-//...
+/// How reflections of sound sources are decoded to the output.
+enum ReflectionMixMode
+{
+    RMM_PER_SOURCE,     // Every source decodes its own ambisonics reflections to the output
+    RMM_SHARED_BUS,     // Sources mix reflections into one ambisonics bus, which is decoded once per block
+};
+
+/// Algorithm rendering reflections of a sound source.
+enum ReflectionEffectType
+{
+    RET_DEFAULT,        // Sound sources follow the global type
+    RET_CONVOLUTION,    // Convolution with the whole simulated impulse response on the CPU, most detailed and most expensive
+    RET_PARAMETRIC,     // Feedback delay network driven by simulated decay times, cheapest, cannot render distinct echoes
+    RET_HYBRID,         // Convolution of the early impulse response, parametric reverb for the tail
+};
+
+/// Ray tracer used for the acoustic scene.
+enum RayTracerType
+{
+    RTT_DEFAULT,        // Built-in Phonon ray tracer
+    RTT_EMBREE,         // Intel Embree, falls back to the built-in ray tracer if Steam Audio was built without it
+};
+
+/// Quality level of the effect chain of a sound source. Changes are cross-faded over one block.
+enum EffectLOD
+{
+    ELOD_FULL,          // Effects as configured
+    ELOD_REDUCED,       // Parametric reverb if the simulator estimates it, panning instead of binaural, frequency independent transmission
+    ELOD_MINIMAL,       // Like reduced, without reflections
+};
+
+/// Identity of model geometry in the static mesh cache. Counts are stored with cached data and verified on load.
+struct SteamAudioStaticMeshKey
+{
+    /// 64-bit hash of material, vertex and index data.
+    unsigned long long hash_{};
+    /// Number of vertices hashed.
+    unsigned numVertices_{};
+    /// Number of indices hashed.
+    unsigned numIndices_{};
+
+    /// Test for equality.
+    bool operator==(const SteamAudioStaticMeshKey& rhs) const
+    {
+        return hash_ == rhs.hash_ && numVertices_ == rhs.numVertices_ && numIndices_ == rhs.numIndices_;
+    }
+    /// Test for inequality.
+    bool operator!=(const SteamAudioStaticMeshKey& rhs) const { return !(*this == rhs); }
+};
+
+/// Model space geometry of a static mesh, unpacked once and transformed on every static batch rebuild.
+struct SteamAudioStaticGeometry
+{
+    /// Vertex positions.
+    ea::vector<Vector3> points_;
+    /// Triangle indices into points.
+    ea::vector<unsigned> indices_;
+};
+
+/// Where mixed audio goes.
+enum OutputDeviceType
+{
+    ODT_SDL,            // SDL audio device, mixed on the SDL audio thread in real time
+    ODT_NULL,           // No device, mixed on demand by RenderOffline() as fast as possible and deterministically
+};
 
 }
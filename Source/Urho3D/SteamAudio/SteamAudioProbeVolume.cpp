@@ -0,0 +1,250 @@
+//
+// Copyright (c) 2024-2024 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../SteamAudio/SteamAudioProbeVolume.h"
+#include "../SteamAudio/SteamAudio.h"
+#include "../SteamAudio/SteamAudioEvents.h"
+#include "../Core/Context.h"
+#include "../Core/ProcessUtils.h"
+#include "../IO/Log.h"
+#include "../Resource/ResourceCache.h"
+#include "../Scene/Node.h"
+
+#include <phonon.h>
+
+namespace Urho3D
+{
+
+static const ea::vector<ea::string> probeGenerationNames = {
+    "Centroid",
+    "Uniform Floor"
+};
+
+SteamAudioProbeVolume::SteamAudioProbeVolume(Context* context) :
+    Component(context)
+{
+    audio_ = GetSubsystem<SteamAudio>();
+
+    if (audio_)
+        SubscribeToEvent(audio_, E_STEAMAUDIOUPDATE, URHO3D_HANDLER(SteamAudioProbeVolume, HandleAudioUpdate));
+}
+
+SteamAudioProbeVolume::~SteamAudioProbeVolume()
+{
+    if (audio_)
+        SetProbeBatch(nullptr);
+}
+
+void SteamAudioProbeVolume::RegisterObject(Context* context)
+{
+    context->AddFactoryReflection<SteamAudioProbeVolume>(Category_Audio);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+    URHO3D_ENUM_ACCESSOR_ATTRIBUTE("Generation", GetGeneration, SetGeneration, ProbeGeneration, probeGenerationNames, ProbeGeneration::uniformFloor, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Spacing", GetSpacing, SetSpacing, float, 2.0f, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Height", GetHeight, SetHeight, float, 1.5f, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Bake Rays", GetNumBakeRays, SetNumBakeRays, unsigned, 16384, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Bake Bounces", GetNumBakeBounces, SetNumBakeBounces, unsigned, 16, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Bake Duration", GetBakeDuration, SetBakeDuration, float, 2.0f, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Bake Ambisonics Order", GetBakeAmbisonicsOrder, SetBakeAmbisonicsOrder, unsigned, 1, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Baked Data File", GetBakedDataFileRef, SetBakedDataFileRef, ResourceRef, ResourceRef{BinaryFile::GetTypeStatic()}, AM_DEFAULT | AM_NOEDIT);
+}
+
+bool SteamAudioProbeVolume::Bake()
+{
+    if (!audio_ || !audio_->GetPhononContext() || !node_) {
+        URHO3D_LOGERROR("Cannot bake probe volume without initialized Steam Audio");
+        return false;
+    }
+
+    const IPLContext phononContext = audio_->GetPhononContext();
+    IPLProbeBatch probeBatch {};
+    iplProbeBatchCreate(phononContext, &probeBatch);
+
+    // Bake on the simulation thread, the scene must not change meanwhile
+    IPLProbeGenerationParams generationParams {
+        .type = generation_ == ProbeGeneration::centroid?IPL_PROBEGENERATIONTYPE_CENTROID:IPL_PROBEGENERATIONTYPE_UNIFORMFLOOR,
+        .spacing = spacing_,
+        .height = height_,
+        .transform = GetPhononMatrix()
+    };
+    IPLReflectionsBakeParams bakeParams {
+        .scene = audio_->GetScene(),
+        .probeBatch = probeBatch,
+        .sceneType = audio_->GetSceneSettings().type,
+        .identifier = GetReverbIdentifier(),
+        .bakeFlags = static_cast<IPLReflectionsBakeFlags>(IPL_REFLECTIONSBAKEFLAGS_BAKECONVOLUTION | IPL_REFLECTIONSBAKEFLAGS_BAKEPARAMETRIC),
+        .numRays = static_cast<IPLint32>(numBakeRays_),
+        .numDiffuseSamples = 32,
+        .numBounces = static_cast<IPLint32>(numBakeBounces_),
+        // Must not exceed what the simulator was created for
+        .simulatedDuration = Clamp(bakeDuration_, 0.1f, 4.0f),
+        .savedDuration = Clamp(bakeDuration_, 0.1f, 4.0f),
+        .order = static_cast<IPLint32>(Clamp(bakeAmbisonicsOrder_, 1u, 8u)),
+        .numThreads = static_cast<IPLint32>(Max(GetNumLogicalCPUs(), 1u)),
+        .irradianceMinDistance = 1.0f
+    };
+    unsigned numProbes = 0;
+    audio_->RunSimulationTaskAndWait([&] {
+        IPLProbeArray probeArray {};
+        iplProbeArrayCreate(phononContext, &probeArray);
+        iplProbeArrayGenerateProbes(probeArray, bakeParams.scene, &generationParams);
+        iplProbeBatchAddProbeArray(probeBatch, probeArray);
+        iplProbeBatchCommit(probeBatch);
+        iplProbeArrayRelease(&probeArray);
+
+        numProbes = iplProbeBatchGetNumProbes(probeBatch);
+        if (numProbes)
+            iplReflectionsBakerBake(phononContext, &bakeParams, nullptr, nullptr);
+    });
+
+    if (!numProbes) {
+        URHO3D_LOGWARNING("No probes generated in probe volume of node {}", node_->GetID());
+        iplProbeBatchRelease(&probeBatch);
+        return false;
+    }
+
+    URHO3D_LOGDEBUG("Baked {} probe(s) in probe volume of node {}", numProbes, node_->GetID());
+    SetProbeBatch(probeBatch);
+    return true;
+}
+
+bool SteamAudioProbeVolume::SaveBakedData(const FileIdentifier& fileName) const
+{
+    if (!probeBatch_)
+        return false;
+
+    IPLSerializedObjectSettings serializedObjectSettings {};
+    IPLSerializedObject serializedObject {};
+    iplSerializedObjectCreate(audio_->GetPhononContext(), &serializedObjectSettings, &serializedObject);
+    iplProbeBatchSave(probeBatch_, serializedObject);
+
+    const IPLbyte* data = iplSerializedObjectGetData(serializedObject);
+    BinaryFile bakedDataFile(context_);
+    bakedDataFile.SetData(ByteVector(data, data + iplSerializedObjectGetSize(serializedObject)));
+    iplSerializedObjectRelease(&serializedObject);
+
+    return bakedDataFile.SaveFile(fileName);
+}
+
+IPLBakedDataIdentifier SteamAudioProbeVolume::GetReverbIdentifier()
+{
+    return IPLBakedDataIdentifier {
+        .type = IPL_BAKEDDATATYPE_REFLECTIONS,
+        .variation = IPL_BAKEDDATAVARIATION_REVERB
+    };
+}
+
+void SteamAudioProbeVolume::SetBakedDataFileRef(const ResourceRef& fileRef)
+{
+    if (bakedDataRef_ != fileRef) {
+        bakedDataDirty_ = true;
+        bakedDataRef_ = fileRef;
+    }
+}
+
+unsigned SteamAudioProbeVolume::GetNumProbes() const
+{
+    return probeBatch_?iplProbeBatchGetNumProbes(probeBatch_):0;
+}
+
+void SteamAudioProbeVolume::HandleAudioUpdate(StringHash eventType, VariantMap &eventData)
+{
+    UpdateBakedData();
+    UpdateRegistration();
+}
+
+void SteamAudioProbeVolume::UpdateBakedData()
+{
+    if (!bakedDataDirty_ || !audio_->GetPhononContext())
+        return;
+
+    bakedDataDirty_ = false;
+    auto* cache = GetSubsystem<ResourceCache>();
+    auto bakedDataFile = cache->GetTempResource<BinaryFile>(bakedDataRef_.name_);
+    if (!bakedDataFile) {
+        SetProbeBatch(nullptr);
+        return;
+    }
+
+    // Phonon only reads from the wrapped data
+    const ByteVector& data = bakedDataFile->GetData();
+    IPLSerializedObjectSettings serializedObjectSettings {
+        .data = const_cast<IPLbyte*>(data.data()),
+        .size = data.size()
+    };
+    IPLSerializedObject serializedObject {};
+    iplSerializedObjectCreate(audio_->GetPhononContext(), &serializedObjectSettings, &serializedObject);
+
+    IPLProbeBatch probeBatch {};
+    if (iplProbeBatchLoad(audio_->GetPhononContext(), serializedObject, &probeBatch) == IPL_STATUS_SUCCESS) {
+        iplProbeBatchCommit(probeBatch);
+        SetProbeBatch(probeBatch);
+    } else {
+        URHO3D_LOGERROR("Failed to load Steam Audio baked data from {}", bakedDataRef_.name_);
+        SetProbeBatch(nullptr);
+    }
+    iplSerializedObjectRelease(&serializedObject);
+}
+
+void SteamAudioProbeVolume::SetProbeBatch(IPLProbeBatch probeBatch)
+{
+    if (probeBatch_)
+        iplProbeBatchRelease(&probeBatch_);
+    probeBatch_ = probeBatch;
+    UpdateRegistration();
+}
+
+void SteamAudioProbeVolume::UpdateRegistration()
+{
+    // The simulation keeps its own reference until the batch is removed
+    const IPLProbeBatch probeBatch = IsEnabledEffective()?probeBatch_:nullptr;
+    if (probeBatch == registeredProbeBatch_)
+        return;
+
+    if (registeredProbeBatch_) {
+        audio_->RemoveProbeBatch(registeredProbeBatch_);
+        registeredProbeBatch_ = nullptr;
+    }
+    if (probeBatch) {
+        audio_->AddProbeBatch(probeBatch);
+        registeredProbeBatch_ = probeBatch;
+    }
+}
+
+IPLMatrix4x4 SteamAudioProbeVolume::GetPhononMatrix() const
+{
+    // Map the unit cube at the origin onto the box centered at the node
+    const Matrix3x4 m = GetNode()->GetWorldTransform() * Matrix3x4(Vector3::ONE * -0.5f, Quaternion::IDENTITY, Vector3::ONE);
+    return {
+        {
+            {m.Element(0, 0), m.Element(0, 1), m.Element(0, 2), m.Element(0, 3)},
+            {m.Element(1, 0), m.Element(1, 1), m.Element(1, 2), m.Element(1, 3)},
+            {m.Element(2, 0), m.Element(2, 1), m.Element(2, 2), m.Element(2, 3)},
+            {0.0f,            0.0f,            0.0f,            1.0f           }
+        }
+    };
+}
+
+}
@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2024-2024 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Resource/BinaryFile.h"
+#include "../Scene/Component.h"
+
+#include <phonon.h>
+
+namespace Urho3D
+{
+
+class SteamAudio;
+
+/// How probes are placed inside a probe volume.
+enum class ProbeGeneration {
+    centroid,
+    uniformFloor
+};
+
+/// %Probe volume component. Bakes reverb at probes placed within the node's scale.x*scale.y*scale.z box, which sound sources with baked reflections look up instead of tracing rays.
+class URHO3D_API SteamAudioProbeVolume : public Component
+{
+    URHO3D_OBJECT(SteamAudioProbeVolume, Component);
+
+public:
+    /// Construct.
+    explicit SteamAudioProbeVolume(Context* context);
+    /// Destruct. Remove self from the audio subsystem.
+    ~SteamAudioProbeVolume() override;
+    /// Register object factory.
+    /// @nobind
+    static void RegisterObject(Context* context);
+
+    /// Generate probes and bake reverb at them using all CPU cores. Stalls simulation until done, meant for editor and offline use. Return true if successful.
+    bool Bake();
+    /// Save baked data to a file that can be used as the baked data file. Return true if successful.
+    bool SaveBakedData(const FileIdentifier& fileName) const;
+    /// Return identifier of the baked reverb layer. Shared by all probe volumes.
+    static IPLBakedDataIdentifier GetReverbIdentifier();
+
+    /// Set reference on file with baked data.
+    void SetBakedDataFileRef(const ResourceRef& fileRef);
+    /// Return reference on file with baked data.
+    ResourceRef GetBakedDataFileRef() const { return bakedDataRef_; }
+    /// Return number of probes in use.
+    unsigned GetNumProbes() const;
+
+    /// Attributes
+    /// @{
+    void SetGeneration(ProbeGeneration generation) { generation_ = generation; }
+    ProbeGeneration GetGeneration() const { return generation_; }
+    void SetSpacing(float spacing) { spacing_ = spacing; }
+    float GetSpacing() const { return spacing_; }
+    void SetHeight(float height) { height_ = height; }
+    float GetHeight() const { return height_; }
+    void SetNumBakeRays(unsigned numRays) { numBakeRays_ = numRays; }
+    unsigned GetNumBakeRays() const { return numBakeRays_; }
+    void SetNumBakeBounces(unsigned numBounces) { numBakeBounces_ = numBounces; }
+    unsigned GetNumBakeBounces() const { return numBakeBounces_; }
+    void SetBakeDuration(float duration) { bakeDuration_ = duration; }
+    float GetBakeDuration() const { return bakeDuration_; }
+    void SetBakeAmbisonicsOrder(unsigned order) { bakeAmbisonicsOrder_ = order; }
+    unsigned GetBakeAmbisonicsOrder() const { return bakeAmbisonicsOrder_; }
+    /// @}
+
+private:
+    /// Handle audio subsystem update event.
+    void HandleAudioUpdate(StringHash eventType, VariantMap& eventData);
+
+    /// Load probe batch from the baked data file.
+    void UpdateBakedData();
+    /// Replace probe batch in use. Takes ownership.
+    void SetProbeBatch(IPLProbeBatch probeBatch);
+    /// Add or remove the probe batch from the simulation to match the enabled state.
+    void UpdateRegistration();
+    /// Return phonon matrix transforming the unit cube into the volume.
+    IPLMatrix4x4 GetPhononMatrix() const;
+
+    /// Steam audio subsystem.
+    WeakPtr<SteamAudio> audio_;
+    /// Probe batch in use.
+    IPLProbeBatch probeBatch_{};
+    /// Probe batch added to the simulation.
+    IPLProbeBatch registeredProbeBatch_{};
+    /// Reference on file with baked data.
+    ResourceRef bakedDataRef_{BinaryFile::GetTypeStatic()};
+    /// Whether the baked data is dirty.
+    bool bakedDataDirty_{};
+    /// How probes are placed.
+    ProbeGeneration generation_{ProbeGeneration::uniformFloor};
+    /// Distance between neighboring probes.
+    float spacing_{2.0f};
+    /// Height of probes above the floor.
+    float height_{1.5f};
+    /// Number of rays traced from each probe while baking.
+    unsigned numBakeRays_{16384};
+    /// Number of bounces of each ray while baking.
+    unsigned numBakeBounces_{16};
+    /// Length of baked impulse responses in seconds.
+    float bakeDuration_{2.0f};
+    /// Ambisonics order of baked impulse responses.
+    unsigned bakeAmbisonicsOrder_{1};
+};
+
+}
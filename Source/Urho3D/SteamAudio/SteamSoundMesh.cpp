@@ -24,6 +24,8 @@
 
 #include "../SteamAudio/SteamSoundMesh.h"
 #include "../SteamAudio/SteamAudio.h"
+#include "../SteamAudio/SteamAudioEvents.h"
+#include "../Container/Hash.h"
 #include "../Graphics/Model.h"
 #include "../Graphics/Geometry.h"
 #include "../Graphics/VertexBuffer.h"
@@ -31,7 +33,6 @@
 #include "../Scene/Node.h"
 #include "../Resource/ResourceCache.h"
 #include "../Core/Context.h"
-#include "../Core/CoreEvents.h"
 
 #include <phonon.h>
 
@@ -66,32 +67,41 @@ static const ea::vector<ea::string> materialNames = {
     "Rock"
 };
 
+/// Initial value of the 64-bit FNV-1a hash.
+static const unsigned long long FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+/// Continue 64-bit FNV-1a hash with binary data.
+static unsigned long long HashData(unsigned long long hash, const void* data, unsigned size)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (unsigned i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i])*1099511628211ull;
+    return hash;
+}
+
 SteamSoundMesh::SteamSoundMesh(Context* context) :
-    Component(context), modelDirty_(false), mesh_(nullptr), subScene_(nullptr), materialIndex_(Material::generic)
+    Component(context), modelDirty_(false), mesh_(nullptr), subScene_(nullptr), instancedMesh_(nullptr), materialIndex_(Material::generic)
 {
     audio_ = GetSubsystem<SteamAudio>();
     material_ = &materials[static_cast<unsigned>(materialIndex_)];
 
     if (audio_) {
-        // Create subscene
-        IPLSceneSettings sceneSettings {
-            .type = IPL_SCENETYPE_DEFAULT
-        };
+        // Create subscene, it must use the same ray tracer as the main scene
+        IPLSceneSettings sceneSettings = audio_->GetSceneSettings();
         iplSceneCreate(audio_->GetPhononContext(), &sceneSettings, &subScene_);
 
-        // Subscribe to render updates
-        SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(SteamSoundMesh, HandleRenderUpdate));
+        // Subscribe to audio subsystem updates
+        SubscribeToEvent(audio_, E_STEAMAUDIOUPDATE, URHO3D_HANDLER(SteamSoundMesh, HandleAudioUpdate));
     }
 }
 
 SteamSoundMesh::~SteamSoundMesh()
 {
     if (audio_) {
-        // Reset model
+        // Reset model, queued tasks keep their own references
         ResetModel();
-        // Remove subscene and mesh
+        // Remove subscene
         iplSceneRelease(&subScene_);
-        iplStaticMeshRelease(&mesh_);
     }
 }
 
@@ -102,6 +112,7 @@ void SteamSoundMesh::RegisterObject(Context* context)
     URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Model", GetModel, SetModel, ResourceRef, ResourceRef(Model::GetTypeStatic()), AM_DEFAULT);
     URHO3D_ENUM_ACCESSOR_ATTRIBUTE("Material", GetMaterial, SetMaterial, Material, materialNames, Material::generic, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Static", IsStatic, SetStatic, bool, false, AM_DEFAULT);
 }
 
 void SteamSoundMesh::SetModel(const ResourceRef& model)
@@ -117,16 +128,29 @@ void SteamSoundMesh::SetMaterial(Material material) {
     MarkModelDirty();
 }
 
+void SteamSoundMesh::SetStatic(bool isStatic)
+{
+    static_ = isStatic;
+    MarkModelDirty();
+}
+
 ResourceRef SteamSoundMesh::GetModel() const
 {
     return GetResourceRef(model_, Model::GetTypeStatic());
 }
 
-void SteamSoundMesh::HandleRenderUpdate(StringHash eventType, VariantMap &eventData)
+void SteamSoundMesh::HandleAudioUpdate(StringHash eventType, VariantMap &eventData)
 {
     if (modelDirty_) {
         ReloadModel();
         modelDirty_ = false;
+        transformDirty_ = false;
+    }
+
+    // Transform changes are coalesced to one update per frame
+    if (transformDirty_) {
+        UpdateTransform();
+        transformDirty_ = false;
     }
 }
 
@@ -140,8 +164,11 @@ void SteamSoundMesh::OnNodeSet(Node *previousNode, Node *currentNode)
 
 void SteamSoundMesh::OnMarkedDirty(Node *)
 {
-    if (model_)
-        UpdateTransform();
+    // Moving a static mesh is supported, but rebuilds the whole batch
+    if (inStaticBatch_)
+        audio_->MarkStaticBatchDirty();
+    else if (model_)
+        transformDirty_ = true;
 }
 
 void SteamSoundMesh::ReloadModel()
@@ -150,30 +177,104 @@ void SteamSoundMesh::ReloadModel()
     if (!audio_)
         return;
 
-    // Clear if no model set
-    if (!model_) {
-        ResetModel();
+    // Clear previous model
+    ResetModel();
+    if (!model_)
+        return;
+
+    // Static meshes are merged with others by the audio subsystem, which caches their geometry by key
+    cacheKey_ = GetStaticMeshCacheKey();
+    if (static_) {
+        audio_->AddStaticMesh(this);
+        inStaticBatch_ = true;
         return;
-    } else if (mesh_) {
-        ResetModel();
     }
 
-    // Extract points and indices
-    ea::vector<Vector3> allPoints;
-    ea::vector<unsigned> allIndices;
+    // Load static mesh from cache, build and cache it on a miss
+    mesh_ = audio_->LoadStaticMesh(cacheKey_, subScene_);
+    if (!mesh_) {
+        BuildStaticMesh();
+        if (mesh_)
+            audio_->SaveStaticMesh(cacheKey_, mesh_);
+    }
+
+    // Create instanced mesh
+    IPLInstancedMeshSettings instancedMeshSettings {
+        .subScene = subScene_,
+        .transform = GetPhononMatrix()
+    };
+    iplInstancedMeshCreate(audio_->GetScene(), &instancedMeshSettings, &instancedMesh_);
+    StoreCommittedTransform();
+
+    // Add meshes to scenes on the simulation thread, scenes must not change while simulating
+    audio_->QueueSimulationTask([audio = audio_.Get(), subScene = iplSceneRetain(subScene_), mesh = iplStaticMeshRetain(mesh_),
+        instancedMesh = iplInstancedMeshRetain(instancedMesh_)]() mutable {
+        iplStaticMeshAdd(mesh, subScene);
+        iplSceneCommit(subScene);
+        iplInstancedMeshAdd(instancedMesh, audio->GetScene());
+        audio->MarkSceneDirty();
+
+        iplInstancedMeshRelease(&instancedMesh);
+        iplStaticMeshRelease(&mesh);
+        iplSceneRelease(&subScene);
+    });
+}
+
+void SteamSoundMesh::ExtractGeometry(ea::vector<Vector3>& points, ea::vector<unsigned>& indices) const
+{
     for (const auto& geometry : model_->GetGeometries()) {
-        for (const auto& geometry : geometry) {
-            for (const auto& vertexBuffer : geometry->GetVertexBuffers()) {
-                ea::vector<Vector4> points(vertexBuffer->GetVertexCount());
-                vertexBuffer->UnpackVertexData(vertexBuffer->GetShadowData(), vertexBuffer->GetVertexSize(), *vertexBuffer->GetElement(SEM_POSITION), 0, vertexBuffer->GetVertexCount(), points.data(), sizeof(Vector4));
-                for (const auto& point : points)
-                    allPoints.push_back({point.x_, point.y_, point.z_});
+        for (const auto& lod : geometry) {
+            // Indices refer to the vertex buffer holding positions
+            const unsigned baseVertex = points.size();
+            for (const auto& vertexBuffer : lod->GetVertexBuffers()) {
+                const VertexElement* positionElement = vertexBuffer->GetElement(SEM_POSITION);
+                if (!positionElement || !vertexBuffer->GetShadowData())
+                    continue;
+                ea::vector<Vector4> vertexPoints(vertexBuffer->GetVertexCount());
+                vertexBuffer->UnpackVertexData(vertexBuffer->GetShadowData(), vertexBuffer->GetVertexSize(), *positionElement, 0, vertexBuffer->GetVertexCount(), vertexPoints.data(), sizeof(Vector4));
+                for (const auto& point : vertexPoints)
+                    points.push_back({point.x_, point.y_, point.z_});
+                break;
             }
-            const auto& indexBuffer = geometry->GetIndexBuffer();
-            const auto indices = indexBuffer->GetUnpackedData();
-            allIndices.insert(allIndices.begin(), indices.begin(), indices.end());
+            const auto& indexBuffer = lod->GetIndexBuffer();
+            if (!indexBuffer)
+                continue;
+            for (unsigned index : indexBuffer->GetUnpackedData())
+                indices.push_back(baseVertex + index);
         }
     }
+}
+
+void SteamSoundMesh::AppendWorldGeometry(const SteamAudioStaticGeometry& geometry,
+    ea::vector<IPLVector3>& vertices, ea::vector<IPLTriangle>& triangles, ea::vector<IPLint32>& materialIndices) const
+{
+    if (!model_ || !node_)
+        return;
+
+    const ea::vector<unsigned>& indices = geometry.indices_;
+    const Matrix3x4& worldTransform = node_->GetWorldTransform();
+    const int baseVertex = vertices.size();
+    for (const auto& point : geometry.points_) {
+        const Vector3 worldPoint = worldTransform * point;
+        vertices.push_back({worldPoint.x_, worldPoint.y_, worldPoint.z_});
+    }
+    for (unsigned idx = 0; idx + 2 < indices.size(); idx += 3) {
+        triangles.push_back({baseVertex + int(indices[idx+0]), baseVertex + int(indices[idx+1]), baseVertex + int(indices[idx+2])});
+        materialIndices.push_back(static_cast<IPLint32>(materialIndex_));
+    }
+}
+
+ea::span<const IPLMaterial> SteamSoundMesh::GetPhononMaterials()
+{
+    return materials;
+}
+
+void SteamSoundMesh::BuildStaticMesh()
+{
+    // Extract points and indices
+    ea::vector<Vector3> allPoints;
+    ea::vector<unsigned> allIndices;
+    ExtractGeometry(allPoints, allIndices);
 
     // Convert to phonon points and indices
     ea::vector<IPLVector3> phononVertices;
@@ -198,39 +299,84 @@ void SteamSoundMesh::ReloadModel()
 
     // Create static mesh
     iplStaticMeshCreate(subScene_, &staticMeshSettings, &mesh_);
-    iplStaticMeshAdd(mesh_, subScene_);
-    iplSceneCommit(subScene_);
-    iplSceneSaveOBJ(subScene_, ("scene-"+ea::to_string(GetNode()->GetID())+".obj").c_str());
-
-    // Create instanced mesh
-    IPLInstancedMeshSettings instancedMeshSettings {
-        .subScene = subScene_,
-        .transform = GetPhononMatrix()
-    };
-    iplInstancedMeshCreate(audio_->GetScene(), &instancedMeshSettings, &instancedMesh_);
-    iplInstancedMeshAdd(instancedMesh_, audio_->GetScene());
+}
 
-    // Mark scene as dirty
-    audio_->MarkSceneDirty();
+SteamAudioStaticMeshKey SteamSoundMesh::GetStaticMeshCacheKey() const
+{
+    // Keys are persisted, 64 bits make collisions between models unlikely and counts catch the rest
+    SteamAudioStaticMeshKey key;
+    key.hash_ = HashData(FNV_OFFSET_BASIS, &materialIndex_, sizeof(materialIndex_));
+    for (const auto& geometry : model_->GetGeometries()) {
+        for (const auto& lod : geometry) {
+            for (const auto& vertexBuffer : lod->GetVertexBuffers()) {
+                if (const unsigned char* data = vertexBuffer->GetShadowData()) {
+                    key.hash_ = HashData(key.hash_, data, vertexBuffer->GetVertexCount()*vertexBuffer->GetVertexSize());
+                    key.numVertices_ += vertexBuffer->GetVertexCount();
+                }
+            }
+            const auto& indexBuffer = lod->GetIndexBuffer();
+            if (!indexBuffer)
+                continue;
+            if (const unsigned char* data = indexBuffer->GetShadowData()) {
+                key.hash_ = HashData(key.hash_, data, indexBuffer->GetIndexCount()*indexBuffer->GetIndexSize());
+                key.numIndices_ += indexBuffer->GetIndexCount();
+            }
+        }
+    }
+    return key;
 }
 
 void SteamSoundMesh::ResetModel()
 {
-    // Release ressources
-    iplInstancedMeshRemove(instancedMesh_, audio_->GetScene());
-    iplInstancedMeshRelease(&instancedMesh_);
-    iplStaticMeshRemove(mesh_, subScene_);
-    iplStaticMeshRelease(&mesh_);
-    mesh_ = nullptr;
+    if (inStaticBatch_) {
+        audio_->RemoveStaticMesh(this);
+        inStaticBatch_ = false;
+    }
+    if (!mesh_)
+        return;
 
-    // Mark scene as dirty
-    audio_->MarkSceneDirty();
+    // Remove meshes from scenes on the simulation thread, it keeps them alive until then
+    audio_->QueueSimulationTask([audio = audio_.Get(), subScene = iplSceneRetain(subScene_), mesh = mesh_, instancedMesh = instancedMesh_]() mutable {
+        iplInstancedMeshRemove(instancedMesh, audio->GetScene());
+        iplStaticMeshRemove(mesh, subScene);
+        iplSceneCommit(subScene);
+        audio->MarkSceneDirty();
+
+        iplInstancedMeshRelease(&instancedMesh);
+        iplStaticMeshRelease(&mesh);
+        iplSceneRelease(&subScene);
+    });
+    instancedMesh_ = nullptr;
+    mesh_ = nullptr;
 }
 
 void SteamSoundMesh::UpdateTransform()
 {
-    iplInstancedMeshUpdateTransform(instancedMesh_, audio_->GetScene(), GetPhononMatrix());
-    audio_->MarkSceneDirty();
+    if (!instancedMesh_)
+        return;
+
+    // Skip movements too small to be heard
+    const Node* node = GetNode();
+    const float distance = (node->GetWorldPosition() - committedPosition_).Length();
+    const float angle = 2.0f * Acos(Min(Abs(node->GetWorldRotation().DotProduct(committedRotation_)), 1.0f));
+    if (distance <= audio_->GetTransformDistanceTolerance() && angle <= audio_->GetTransformAngleTolerance()
+        && node->GetWorldScale().Equals(committedScale_))
+        return;
+    StoreCommittedTransform();
+
+    audio_->QueueSimulationTask([audio = audio_.Get(), instancedMesh = iplInstancedMeshRetain(instancedMesh_), transform = GetPhononMatrix()]() mutable {
+        iplInstancedMeshUpdateTransform(instancedMesh, audio->GetScene(), transform);
+        audio->MarkSceneDirty();
+        iplInstancedMeshRelease(&instancedMesh);
+    });
+}
+
+void SteamSoundMesh::StoreCommittedTransform()
+{
+    const Node* node = GetNode();
+    committedPosition_ = node->GetWorldPosition();
+    committedRotation_ = node->GetWorldRotation();
+    committedScale_ = node->GetWorldScale();
 }
 
 IPLMatrix4x4 SteamSoundMesh::GetPhononMatrix() const
@@ -23,6 +23,9 @@
 #pragma once
 
 #include "../Scene/Component.h"
+#include "../SteamAudio/SteamAudioDefs.h"
+
+#include <EASTL/span.h>
 
 #include <phonon.h>
 
@@ -65,14 +68,29 @@ public:
     /// Set material to use.
     void SetMaterial(Material material);
 
+    /// Set whether the mesh never moves. Static meshes are merged into the static batch of the audio subsystem instead of being instanced.
+    void SetStatic(bool isStatic);
+
     /// Returns currently used model.
     ResourceRef GetModel() const;
     /// Returns currently used material.
     Material GetMaterial() const { return materialIndex_; }
+    /// Return whether the mesh never moves.
+    bool IsStatic() const { return static_; }
+
+    /// Return static mesh cache key of the current model, shared by all meshes using the same model and material.
+    const SteamAudioStaticMeshKey& GetCacheKey() const { return cacheKey_; }
+    /// Extract model vertex positions and triangle indices.
+    void ExtractGeometry(ea::vector<Vector3>& points, ea::vector<unsigned>& indices) const;
+    /// Append model geometry transformed to world space, with the material index of every triangle. Used for static batching.
+    void AppendWorldGeometry(const SteamAudioStaticGeometry& geometry,
+        ea::vector<IPLVector3>& vertices, ea::vector<IPLTriangle>& triangles, ea::vector<IPLint32>& materialIndices) const;
+    /// Return phonon materials, indexed by Material.
+    static ea::span<const IPLMaterial> GetPhononMaterials();
 
 private:
-    /// Handle render update event.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle audio subsystem update event.
+    void HandleAudioUpdate(StringHash eventType, VariantMap& eventData);
     /// Handle node being assigned.
     virtual void OnNodeSet(Node* previousNode, Node* currentNode) override;
     /// Handle transform change.
@@ -83,17 +101,37 @@ private:
 
     /// Reload current model.
     void ReloadModel();
+    /// Build static mesh from model geometry.
+    void BuildStaticMesh();
+    /// Return static mesh cache key of model content and material.
+    SteamAudioStaticMeshKey GetStaticMeshCacheKey() const;
     /// Reset (clear) current model.
     void ResetModel();
-    /// Update transform.
+    /// Update transform if the node moved beyond the tolerance of the audio subsystem.
     void UpdateTransform();
+    /// Remember the node transform the instanced mesh uses.
+    void StoreCommittedTransform();
     /// Return phonon matrix of node
     IPLMatrix4x4 GetPhononMatrix() const;
 
     /// Is model dirty?
     bool modelDirty_;
+    /// Is the mesh static?
+    bool static_{};
+    /// Is the mesh part of the static batch?
+    bool inStaticBatch_{};
+    /// Has the node moved since the last update?
+    bool transformDirty_{};
+    /// World position the instanced mesh was last updated with.
+    Vector3 committedPosition_;
+    /// World rotation the instanced mesh was last updated with.
+    Quaternion committedRotation_;
+    /// World scale the instanced mesh was last updated with.
+    Vector3 committedScale_;
     /// Currently used model.
     SharedPtr<Model> model_;
+    /// Static mesh cache key of the model.
+    SteamAudioStaticMeshKey cacheKey_;
     /// Material index.
     Material materialIndex_;
     /// Material.
@@ -23,15 +23,19 @@
 #include "../Precompiled.h"
 
 #include "../SteamAudio/SteamAudio.h"
+#include "../SteamAudio/SteamAudioEvents.h"
+#include "../SteamAudio/SteamAudioProbeVolume.h"
 #include "../SteamAudio/SteamSoundSource.h"
 #include "../SteamAudio/SteamSoundListener.h"
 #include "../Audio/Sound.h"
+#include "../Audio/SoundStream.h"
 #include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Core/StringUtils.h"
 #include "../IO/Log.h"
 #include "../Resource/ResourceCache.h"
 #include "../Scene/Node.h"
 #include "../Scene/SceneEvents.h"
-#include "../Core/CoreEvents.h"
 
 #include "../DebugNew.h"
 
@@ -40,8 +44,45 @@
 namespace Urho3D
 {
 
+namespace
+{
+
+const char* reflectionTypeNames[] =
+{
+    "Default",
+    "Convolution",
+    "Parametric",
+    "Hybrid",
+    nullptr
+};
+
+/// Blend the other buffer into the destination with a linear ramp over one block, towards the other buffer or away from it.
+void CrossFade(IPLAudioBuffer& dest, const IPLAudioBuffer& other, bool towardsOther)
+{
+    const unsigned numChannels = Min(dest.numChannels, other.numChannels);
+    const float step = 1.0f/dest.numSamples;
+    for (unsigned channel = 0; channel < numChannels; channel++) {
+        for (IPLint32 sample = 0; sample < dest.numSamples; sample++) {
+            const float fade = (sample + 1)*step;
+            dest.data[channel][sample] = Lerp(dest.data[channel][sample], other.data[channel][sample], towardsOther?fade:1.0f - fade);
+        }
+    }
+}
+
+/// Copy a mono buffer with a linear gain ramp over one block.
+void Fade(const IPLAudioBuffer& source, IPLAudioBuffer& dest, bool fadeIn)
+{
+    const float step = 1.0f/dest.numSamples;
+    for (IPLint32 sample = 0; sample < dest.numSamples; sample++) {
+        const float fade = (sample + 1)*step;
+        dest.data[0][sample] = source.data[0][sample]*(fadeIn?fade:1.0f - fade);
+    }
+}
+
+}
+
 SteamSoundSource::SteamSoundSource(Context* context) :
-    Component(context), sound_(nullptr), binauralEffect_(nullptr), directEffect_(nullptr), source_(nullptr), simulatorOutputs_({}), gain_(1.0f), paused_(false), loop_(false), binaural_(false), distanceAttenuation_(false), airAbsorption_(false), occlusion_(false), transmission_(false), reflection_(false), reflectionAmbisonicsOrder_(1), binauralSpatialBlend_(1.0f), binauralBilinearInterpolation_(false), effectsLoaded_(false), effectsDirty_(false)
+    Component(context), sound_(nullptr), binauralEffect_(nullptr), directEffect_(nullptr), reflectionEffect_(nullptr), ambisonicsBinauralEffect_(nullptr), gain_(1.0f), paused_(false), loop_(false), binaural_(false), distanceAttenuation_(false), airAbsorption_(false), occlusion_(false), transmission_(false), reflection_(false), reflectionAmbisonicsOrder_(1), binauralSpatialBlend_(1.0f), binauralBilinearInterpolation_(false), effectsLoaded_(false), effectsDirty_(false)
 {
     audio_ = GetSubsystem<SteamAudio>();
 
@@ -49,16 +90,25 @@ SteamSoundSource::SteamSoundSource(Context* context) :
         // Add this sound source
         audio_->AddSoundSource(this);
 
-        // Subscribe to render updates
-        SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(SteamSoundSource, HandleRenderUpdate));
+        // Subscribe to audio subsystem updates
+        SubscribeToEvent(audio_, E_STEAMAUDIOUPDATE, URHO3D_HANDLER(SteamSoundSource, HandleAudioUpdate));
     }
 }
 
 SteamSoundSource::~SteamSoundSource()
 {
-    if (audio_)
+    if (audio_) {
         // Remove this sound source
         audio_->RemoveSoundSource(this);
+
+        // Release effects and scratch buffers
+        SuspendEffects();
+        UnlockedDestroyEffects();
+
+        // Stop decoding
+        soundStream_.Reset();
+        UnlockedUpdateStreamSource();
+    }
 }
 
 void SteamSoundSource::RegisterObject(Context* context)
@@ -70,6 +120,8 @@ void SteamSoundSource::RegisterObject(Context* context)
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Sound", GetSoundAttr, SetSoundAttr, ResourceRef, ResourceRef(Sound::GetTypeStatic()), AM_DEFAULT);
     URHO3D_ATTRIBUTE("Gain", float, gain_, 1.0f, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Loop", bool, loop_, false, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Priority", int, priority_, 0, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Pitch", float, pitch_, 1.0f, AM_DEFAULT);
     URHO3D_ATTRIBUTE_EX("Binaural", bool, binaural_, MarkEffectsDirty, false, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Binaural Spacial Blend", float, binauralSpatialBlend_, 1.0f, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Binaural Bilinear Interpolation", bool, binauralBilinearInterpolation_, false, AM_DEFAULT);
@@ -79,15 +131,34 @@ void SteamSoundSource::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE_EX("Transmission", bool, transmission_, MarkEffectsDirty, false, AM_DEFAULT);
     URHO3D_ATTRIBUTE_EX("Reflection", bool, reflection_, MarkEffectsDirty, false, AM_DEFAULT);
     URHO3D_ATTRIBUTE_EX("Reflection Ambisonics Order", unsigned, reflectionAmbisonicsOrder_, MarkEffectsDirty, 1, AM_DEFAULT);
+    URHO3D_ATTRIBUTE_EX("Baked Reflections", bool, bakedReflections_, MarkEffectsDirty, false, AM_DEFAULT);
+    URHO3D_ENUM_ATTRIBUTE_EX("Reflection Type", reflectionType_, MarkEffectsDirty, reflectionTypeNames, RET_DEFAULT, AM_DEFAULT);
+    URHO3D_ATTRIBUTE_EX("Hybrid Transition Time", float, hybridTransitionTime_, MarkEffectsDirty, 1.0f, AM_DEFAULT);
+    URHO3D_ATTRIBUTE_EX("Hybrid Overlap", float, hybridOverlap_, MarkEffectsDirty, 0.25f, AM_DEFAULT);
 }
 
 void SteamSoundSource::Play(Sound *sound)
 {
-    // Reset current frame (playback position)
-    frame_ = 0;
-
-    // Set sound
+    // Set sound, playback position is reset once effects are recreated
     sound_ = sound;
+    restartPending_ = true;
+
+    // Compressed sounds are played through a decoder stream
+    if (sound && sound->IsCompressed())
+        soundStream_ = sound->GetDecoderStream();
+    else
+        soundStream_.Reset();
+
+    // Update effects
+    MarkEffectsDirty();
+}
+
+void SteamSoundSource::Play(SoundStream *stream)
+{
+    // Set stream, it replaces the decoded stream once effects are recreated
+    sound_.Reset();
+    soundStream_ = stream;
+    restartPending_ = true;
 
     // Update effects
     MarkEffectsDirty();
@@ -95,8 +166,7 @@ void SteamSoundSource::Play(Sound *sound)
 
 bool SteamSoundSource::IsPlaying() const
 {
-    const auto& audioSettings = audio_->GetAudioSettings();
-    return sound_ && !paused_;
+    return (sound_ || soundStream_) && !paused_;
 }
 
 void SteamSoundSource::SetPlayingAttr(bool playing)
@@ -115,153 +185,398 @@ ResourceRef SteamSoundSource::GetSoundAttr() const
     return GetResourceRef(sound_, Sound::GetTypeStatic());
 }
 
-IPLAudioBuffer *SteamSoundSource::GenerateAudioBuffer(float gain)
+float SteamSoundSource::GetAudibility(const Vector3& listenerPosition) const
+{
+    // Inverse distance model with a minimum distance of 1 unit, like the default Steam Audio model
+    if (!distanceAttenuation_ || !node_)
+        return gain_;
+    return gain_/Max((node_->GetWorldPosition() - listenerPosition).Length(), 1.0f);
+}
+
+void SteamSoundSource::PublishParameters()
+{
+    MixParameters& parameters = parameters_.GetBack();
+    parameters.gain_ = gain_;
+    parameters.binauralSpatialBlend_ = binauralSpatialBlend_;
+    parameters.binauralBilinearInterpolation_ = binauralBilinearInterpolation_;
+    parameters.playing_ = IsPlaying() && IsEnabledEffective();
+    parameters.loop_ = loop_;
+    parameters.virtual_ = virtual_;
+    parameters.effectLod_ = effectLod_;
+    if (streamSource_)
+        streamSource_->loop_.store(loop_, std::memory_order_relaxed);
+
+    // Resample to the output sampling rate, banks are only looked up when the step changes
+    const float frequency = soundStream_?soundStream_->GetFrequency():(sound_?sound_->GetFrequency():0.0f);
+    const double step = frequency > 0.0f?Clamp(static_cast<double>(frequency*pitch_)/audio_->GetAudioSettings().samplingRate, 0.0, AudioResampler::MaxStep):1.0;
+    if (step != filterBankStep_) {
+        filterBankStep_ = step;
+        filterBank_ = step != 1.0?ResamplerFilterBank::Get(step):nullptr;
+    }
+    parameters.step_ = step;
+    parameters.filterBank_ = filterBank_;
+
+    // Calculate direction to listener
+    auto listener = audio_->GetListener();
+    if (listener && node_) {
+        const auto lPos = listener->GetNode()->GetWorldPosition();
+        const auto lDir = listener->GetNode()->GetWorldDirection();
+        const auto lUp = listener->GetNode()->GetWorldUp();
+        const auto sPos = node_->GetWorldPosition();
+        parameters.direction_ = iplCalculateRelativeDirection(audio_->GetPhononContext(), {sPos.x_, sPos.y_, sPos.z_}, {lPos.x_, lPos.y_, lPos.z_}, {lDir.x_, lDir.y_, lDir.z_}, {lUp.x_, lUp.y_, lUp.z_});
+        parameters.direction_.x = -parameters.direction_.x; // Why is this required?
+    }
+
+    parameters_.Publish();
+}
+
+IPLAudioBuffer *SteamSoundSource::GenerateAudioBuffer(const SteamAudioMixContext& mixContext)
 {
-    // Stop if effects are dirty
-    if (effectsDirty_)
+    // Stop if effects are being recreated, or a mix worker late for the previous block still renders this source
+    if (!effectsReady_.load(std::memory_order_acquire) || rendering_.exchange(true, std::memory_order_acquire))
         return nullptr;
 
+    URHO3D_PROFILE("SteamSoundSource");
+    URHO3D_PROFILE_ZONENAME(profileName_.c_str(), profileName_.size());
+    const auto mixStart = std::chrono::steady_clock::now();
+    IPLAudioBuffer* const result = RenderAudioBuffer(mixContext);
+    lastMixTime_.store(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mixStart).count(), std::memory_order_relaxed);
+    rendering_.store(false, std::memory_order_release);
+    return result;
+}
+
+IPLAudioBuffer *SteamSoundSource::RenderAudioBuffer(const SteamAudioMixContext& mixContext)
+{
+    // Fetch latest parameters published by the main thread
+    const MixParameters& parameters = parameters_.Read();
+
     // Return nothing if not playing
-    if (!IsPlaying())
+    if (!parameters.playing_ || (!playingSound_ && !streamSource_))
+        return nullptr;
+
+    // Scratch buffers are sized by UpdateEffects(), never allocate here
+    if (conversionBuffer_.empty() || !outputBuffer_.data)
+        return nullptr;
+
+    // Virtual sources only keep track of their playback position
+    if (parameters.virtual_) {
+        SkipInputFrame(parameters);
         return nullptr;
+    }
 
     // Get phonon context and audio settings
     const auto phononContext = audio_->GetPhononContext();
     const auto hrtf = audio_->GetHRTF();
     const auto& audioSettings = audio_->GetAudioSettings();
 
-    // Get audio pool
-    MutexLock Lock(effectsMutex_);
-    auto& pool = audio_->GetAudioBufferPool();
+    // Get audio pool of this thread
+    auto& pool = *mixContext.bufferPool_;
+    auto reflectionBus = mixContext.reflectionBus_;
+
+    // Fetch input with gain applied
+    IPLAudioBuffer* input;
+    {
+        URHO3D_PROFILE("SteamSoundSource Input");
+        input = ReadInputBuffer(parameters, parameters.gain_*mixContext.gain_);
+    }
+    if (!input)
+        return nullptr;
+    IPLAudioBuffer* currentBuffer = input;
+
+    // Fetch latest outputs published by the simulation
+    const IPLSimulationOutputs simulatorOutputs = simulationSource_?simulationSource_->outputs_.Read():IPLSimulationOutputs {};
+
+    // Effect LOD changes are cross-faded over this block
+    const EffectLOD effectLod = parameters.effectLod_;
+    const EffectLOD previousEffectLod = renderedEffectLod_;
+    renderedEffectLod_ = effectLod;
+
+    // Apply reflection effect, minimal effect LOD renders none. The dry signal continues through the other effects either way
+    bool reflectionsDecoded = false;
+    const bool send = effectLod != ELOD_MINIMAL;
+    const bool sent = previousEffectLod != ELOD_MINIMAL;
+    if (reflectionEffect_ && (send || sent)) {
+        URHO3D_PROFILE("SteamSoundSource Reflection");
+
+        // Make sure input is mono, faded while reflections are switched on or off
+        IPLAudioBuffer* monoBuffer = input;
+        if (input->numChannels > 1) {
+            iplAudioBufferDownmix(phononContext, input, &monoBuffer_);
+            monoBuffer = &monoBuffer_;
+        }
+        if (send != sent) {
+            Fade(*monoBuffer, monoBuffer_, send);
+            monoBuffer = &monoBuffer_;
+        }
 
-    // Calculate size of one full interleaved frame
-    const auto fullFrameSize = audioSettings.frameSize*(sound_->IsStereo()?2:1);
+        // Lower effect LOD renders parametric reverb if available. Switching reflections on or off keeps the algorithm that is audible
+        const bool reduce = reducedReflectionEffect_ && (send?effectLod:previousEffectLod) != ELOD_FULL;
+        const bool reduced = reducedReflectionEffect_ && (sent?previousEffectLod:effectLod) != ELOD_FULL;
+        IPLReflectionEffectParams reflectionEffectParams = simulatorOutputs.reflections;
+        reflectionEffectParams.type = reduce?IPL_REFLECTIONEFFECTTYPE_PARAMETRIC:effectsReflectionType_;
+        reflectionEffectParams.irSize = ImpulseResponseSize();
+        reflectionEffectParams.numChannels = ambisonicsBuffer_.numChannels;
+        IPLReflectionEffect reflectionEffect = reduce?reducedReflectionEffect_:reflectionEffect_;
+
+        // Algorithm changes are cross-faded in time domain, even if the bus would convolve in frequency domain
+        const bool mixToBus = effectsUseReflectionBus_ && reflectionBus && reflectionBus->GetChannelCount() == ambisonicsBuffer_.numChannels;
+        if (reduce != reduced) {
+            IPLReflectionEffectParams fullEffectParams = reflectionEffectParams;
+            fullEffectParams.type = effectsReflectionType_;
+            IPLReflectionEffectParams reducedEffectParams = reflectionEffectParams;
+            reducedEffectParams.type = IPL_REFLECTIONEFFECTTYPE_PARAMETRIC;
+            iplReflectionEffectApply(reflectionEffect_, &fullEffectParams, monoBuffer, &ambisonicsBuffer_, nullptr);
+            iplReflectionEffectApply(reducedReflectionEffect_, &reducedEffectParams, monoBuffer, &reducedAmbisonicsBuffer_, nullptr);
+            CrossFade(ambisonicsBuffer_, reducedAmbisonicsBuffer_, reduce);
+            if (mixToBus)
+                reflectionBus->MixRendered(mixContext.lane_, &ambisonicsBuffer_);
+
+            // Forget input of the algorithm faded out, so switching back does not replay stale reflections
+            iplReflectionEffectReset(reduce?reflectionEffect_:reducedReflectionEffect_);
+        } else if (mixToBus) {
+            // Mix into shared bus, it is decoded once for all sources
+            reflectionBus->Mix(mixContext.lane_, reflectionEffect, reflectionEffectParams, monoBuffer, &ambisonicsBuffer_);
+        } else if (!effectsUseReflectionBus_) {
+            iplReflectionEffectApply(reflectionEffect, &reflectionEffectParams, monoBuffer, &ambisonicsBuffer_, nullptr);
+        }
 
-    // Stop or reset if file ends before end of frame
-    if ((frame_ + 1)*fullFrameSize*(sound_->IsSixteenBit()?2:1) > sound_->GetDataSize()) {
-        if (loop_)
-            frame_ = 0;
-        else
-            return nullptr;
+        // Decode to the output channel layout, added once the dry signal is processed
+        if (!effectsUseReflectionBus_) {
+            IPLAmbisonicsBinauralEffectParams ambisonicsBinauralEffectParams {
+                .hrtf = hrtf,
+                .order = static_cast<IPLint32>(effectsAmbisonicsOrder_)
+            };
+            iplAmbisonicsBinauralEffectApply(ambisonicsBinauralEffect_, &ambisonicsBinauralEffectParams, &ambisonicsBuffer_, &reflectionBuffer_);
+            reflectionsDecoded = true;
+        }
     }
 
-    // Convert sound data to interleaved float buffer
-    ea::vector<float> rawInputBuffer(fullFrameSize);
-    for (unsigned sample = 0; sample != fullFrameSize; sample++) {
-        // Convert to float32
-        if (sound_->IsSixteenBit()) {
-            int16_t integerData = reinterpret_cast<const int16_t*>(sound_->GetData().get())[frame_*fullFrameSize + sample];
-            rawInputBuffer[sample] = float(integerData)/32767.0f;
-        } else {
-            int8_t integerData = sound_->GetData()[frame_*fullFrameSize + sample];
-            rawInputBuffer[sample] = float(integerData)/128.f;
+    // Apply binaural effect
+    if (binauralEffect_) {
+        URHO3D_PROFILE("SteamSoundSource Binaural");
+
+        // Lower effect LOD pans instead
+        const bool pan = effectLod != ELOD_FULL;
+        const bool panned = previousEffectLod != ELOD_FULL;
+        IPLAudioBuffer* output = pool.GetNextBuffer();
+        if (!pan || !panned) {
+            IPLBinauralEffectParams binauralEffectParams {
+                .direction = parameters.direction_,
+                .interpolation = parameters.binauralBilinearInterpolation_?IPL_HRTFINTERPOLATION_BILINEAR:IPL_HRTFINTERPOLATION_NEAREST,
+                .spatialBlend = parameters.binauralSpatialBlend_,
+                .hrtf = hrtf
+            };
+            iplBinauralEffectApply(binauralEffect_, &binauralEffectParams, currentBuffer, output);
         }
-        // Apply gain
-        rawInputBuffer[sample] *= gain_*gain;
+        if (pan || panned) {
+            IPLAudioBuffer* monoBuffer = currentBuffer;
+            if (currentBuffer->numChannels > 1) {
+                iplAudioBufferDownmix(phononContext, currentBuffer, &monoBuffer_);
+                monoBuffer = &monoBuffer_;
+            }
+            IPLPanningEffectParams panningEffectParams {
+                .direction = parameters.direction_
+            };
+            iplPanningEffectApply(panningEffect_, &panningEffectParams, monoBuffer, pan == panned?output:&panningBuffer_);
+            if (pan != panned)
+                CrossFade(*output, panningBuffer_, pan);
+        }
+        pool.SwitchToNextBuffer();
+        currentBuffer = pool.GetCurrentBuffer();
     }
 
-    // Get listener node
-    auto listener = audio_->GetListener()->GetNode();
+    // Apply all direct effects
+    if (directEffect_ && simulationSource_ && directEffectFlags_) {
+        URHO3D_PROFILE("SteamSoundSource Direct");
+
+        // Get parameters
+        IPLDirectEffectParams directEffectParams = simulatorOutputs.direct;
+        directEffectParams.flags = directEffectFlags_;
+        if (directEffectFlags_ & IPL_DIRECTEFFECTFLAGS_APPLYTRANSMISSION)
+            directEffectParams.transmissionType = effectLod == ELOD_FULL?IPL_TRANSMISSIONTYPE_FREQDEPENDENT:IPL_TRANSMISSIONTYPE_FREQINDEPENDENT;
+
+        // Apply effect using them, unprocessed input keeps the channel count of the sound
+        if (currentBuffer == input) {
+            iplDirectEffectApply(directEffect_, &directEffectParams, currentBuffer, &directBuffer_);
+            currentBuffer = &directBuffer_;
+        } else {
+            iplDirectEffectApply(directEffect_, &directEffectParams, currentBuffer, pool.GetNextBuffer());
+            pool.SwitchToNextBuffer();
+            currentBuffer = pool.GetCurrentBuffer();
+        }
+    }
 
-    // Get positions
-    const auto lPos = listener->GetWorldPosition();
-    const auto lDir = listener->GetWorldDirection();
-    const auto lUp = listener->GetWorldUp();
-    const auto sPos = GetNode()->GetWorldPosition();
-    const IPLVector3 psPos {sPos.x_, sPos.y_, sPos.z_};
-    const IPLVector3 plPos {lPos.x_, lPos.y_, lPos.z_};
+    // Convert to the output channel layout if necessary, or copy to add decoded reflections without touching the input
+    if (currentBuffer->numChannels != outputBuffer_.numChannels || reflectionsDecoded) {
+        for (IPLint32 channel = 0; channel != outputBuffer_.numChannels; channel++) {
+            // Mono input is copied into every channel, missing channels are silent
+            const IPLint32 inputChannel = currentBuffer->numChannels == 1 ? 0 : channel;
+            if (inputChannel < currentBuffer->numChannels)
+                memcpy(outputBuffer_.data[channel], currentBuffer->data[inputChannel], outputBuffer_.numSamples*sizeof(float));
+            else
+                memset(outputBuffer_.data[channel], 0, outputBuffer_.numSamples*sizeof(float));
+        }
+        currentBuffer = &outputBuffer_;
+    }
+    if (reflectionsDecoded)
+        iplAudioBufferMix(phononContext, &reflectionBuffer_, &outputBuffer_);
 
-    // Deinterleave sound data into buffer
-    iplAudioBufferDeinterleave(phononContext, rawInputBuffer.data(), pool.GetCurrentBuffer());
+    return currentBuffer;
+}
 
-    // Get simulator outputs
-    audio_->GetSimulatorOutputs(source_, simulatorOutputs_);
+void SteamSoundSource::SkipAudioBuffer()
+{
+    if (!effectsReady_.load(std::memory_order_acquire) || rendering_.exchange(true, std::memory_order_acquire))
+        return;
 
-    // Apply reflection effect
-    if (reflection_) {
-        const unsigned ambisonicsChannels = audio_->ChannelCount(reflectionAmbisonicsOrder_);
-
-        // Make sure input is mono
-        IPLAudioBuffer monoBuffer;
-        const bool originalIsMono = pool.GetCurrentBuffer()->numChannels <= 1;
-        if (!originalIsMono) {
-            iplAudioBufferAllocate(phononContext, 1, audioSettings.frameSize, &monoBuffer);
-            iplAudioBufferDownmix(phononContext, pool.GetCurrentBuffer(), &monoBuffer);
-        } else {
-            monoBuffer = *pool.GetCurrentBuffer();
-        }
+    const MixParameters& parameters = parameters_.Read();
+    if (parameters.playing_ && (playingSound_ || streamSource_) && !conversionBuffer_.empty())
+        SkipInputFrame(parameters);
+    rendering_.store(false, std::memory_order_release);
+}
 
-        // Make sure output is ambisonics
-        IPLAudioBuffer ambiBuffer;
-        iplAudioBufferAllocate(phononContext, ambisonicsChannels, audioSettings.frameSize, &ambiBuffer);
+bool SteamSoundSource::ReadSource(float* dest, unsigned numFrames, bool loop)
+{
+    const unsigned channels = inputBuffer_.numChannels;
+    const unsigned numSamples = numFrames*channels;
+
+    if (streamSource_) {
+        // Check for the end first so samples decoded right before it are not dropped
+        const bool finished = streamSource_->finished_.load(std::memory_order_acquire);
+        const unsigned numRead = streamSource_->buffer_.Read(dest, numSamples);
+        if (!numRead && finished)
+            return false;
+
+        // Play silence if the decoder falls behind
+        ea::fill(dest + numRead, dest + numSamples, 0.0f);
+        return true;
+    }
 
-        // Actually apply effect
-        IPLReflectionEffectParams reflectionEffectParams = simulatorOutputs_.reflections;
-        reflectionEffectParams.irSize = audio_->ImpulseResponseDuration() * audioSettings.samplingRate;
-        reflectionEffectParams.numChannels = ambisonicsChannels;
+    // Convert sound data, wrapping around at the end when looping
+    const unsigned totalFrames = playingSound_->GetDataSize()/playingSound_->GetSampleSize();
+    unsigned numRead = 0;
+    while (numRead < numFrames && totalFrames) {
+        if (position_ >= totalFrames) {
+            if (!loop)
+                break;
+            position_ = 0;
+        }
 
-        iplReflectionEffectApply(reflectionEffect_, &reflectionEffectParams, &monoBuffer, &ambiBuffer, nullptr);
-        if (!originalIsMono)
-            iplAudioBufferFree(phononContext, &monoBuffer);
+        const unsigned count = Min(numFrames - numRead, totalFrames - position_);
+        float* output = dest + numRead*channels;
+        if (floatData_) {
+            for (unsigned channel = 0; channel != channels; channel++) {
+                const float* floatData = floatData_->GetChannel(channel) + position_;
+                for (unsigned frame = 0; frame != count; frame++)
+                    output[frame*channels + channel] = floatData[frame];
+            }
+        } else if (playingSound_->IsSixteenBit()) {
+            const auto* integerData = reinterpret_cast<const int16_t*>(playingSound_->GetStart()) + position_*channels;
+            for (unsigned sample = 0; sample != count*channels; sample++)
+                output[sample] = float(integerData[sample])/32767.0f;
+        } else {
+            const auto* integerData = playingSound_->GetStart() + position_*channels;
+            for (unsigned sample = 0; sample != count*channels; sample++)
+                output[sample] = float(integerData[sample])/128.f;
+        }
 
-        // Convert ambisonics back to target channel count
-        IPLAmbisonicsBinauralEffectParams ambisonicsBinauralEffectParams {
-            .hrtf = audio_->GetHRTF(),
-            .order = static_cast<IPLint32>(reflectionAmbisonicsOrder_)
-        };
-        iplAmbisonicsBinauralEffectApply(ambisonicsBinauralEffect_, &ambisonicsBinauralEffectParams, &ambiBuffer, pool.GetNextBuffer());
-        iplAudioBufferFree(phononContext, &ambiBuffer);
-        pool.SwitchToNextBuffer();
+        position_ += count;
+        numRead += count;
     }
+    if (!numRead)
+        return false;
 
-    // Apply binaural effect
-    if (binaural_) {
-        IPLBinauralEffectParams binauralEffectParams {
-            .interpolation = binauralBilinearInterpolation_?IPL_HRTFINTERPOLATION_BILINEAR:IPL_HRTFINTERPOLATION_NEAREST,
-            .spatialBlend = binauralSpatialBlend_,
-            .hrtf = hrtf
-        };
-        binauralEffectParams.direction = iplCalculateRelativeDirection(phononContext, psPos, plPos, {lDir.x_, lDir.y_, lDir.z_}, {lUp.x_, lUp.y_, lUp.z_});
-        binauralEffectParams.direction.x = -binauralEffectParams.direction.x; // Why is this required?
-        iplBinauralEffectApply(binauralEffect_, &binauralEffectParams, pool.GetCurrentBuffer(), pool.GetNextBuffer());
-        pool.SwitchToNextBuffer();
+    // Pad the end of the sound with silence
+    ea::fill(dest + numRead*channels, dest + numSamples, 0.0f);
+    return true;
+}
+
+bool SteamSoundSource::ReadInputFrame(const MixParameters& parameters, float gain)
+{
+    const unsigned frameSize = audio_->GetFrameSize();
+
+    // Let the main thread know once the sound has ended, so it no longer competes for voices
+    if (!parameters.filterBank_) {
+        const bool read = ReadSource(conversionBuffer_.data(), frameSize, parameters.loop_);
+        finished_.store(!read, std::memory_order_relaxed);
+        if (!read)
+            return false;
+    } else {
+        // Feed the resampler exactly as many frames as it needs for one block
+        const unsigned numInputFrames = resampler_.GetNumInputFramesNeeded(frameSize, parameters.step_);
+        const bool read = !numInputFrames || ReadSource(resampleBuffer_.data(), numInputFrames, parameters.loop_);
+        finished_.store(!read, std::memory_order_relaxed);
+        if (!read)
+            return false;
+        resampler_.PushInput(resampleBuffer_.data(), numInputFrames);
+        resampler_.Process(conversionBuffer_.data(), frameSize, parameters.step_, parameters.filterBank_);
     }
 
-    // Apply all direct effects
-    if (UsingDirectEffect()) {
-        // Create direct effect properties
-        IPLDirectEffectParams directEffectParams {};
+    for (float& sample : conversionBuffer_)
+        sample *= gain;
+    return true;
+}
 
-        // Get direct effect flags
-        IPLDirectEffectFlags directEffectFlags {};
-        if (distanceAttenuation_)
-            directEffectFlags = static_cast<IPLDirectEffectFlags>(directEffectFlags | IPL_DIRECTEFFECTFLAGS_APPLYDISTANCEATTENUATION);
-        if (airAbsorption_)
-            directEffectFlags = static_cast<IPLDirectEffectFlags>(directEffectFlags | IPL_DIRECTEFFECTFLAGS_APPLYAIRABSORPTION);
-        if (occlusion_)
-            directEffectFlags = static_cast<IPLDirectEffectFlags>(directEffectFlags | IPL_DIRECTEFFECTFLAGS_APPLYOCCLUSION);
-        if (transmission_)
-            directEffectFlags = static_cast<IPLDirectEffectFlags>(directEffectFlags | IPL_DIRECTEFFECTFLAGS_APPLYTRANSMISSION);
-
-        // Apply direct effect
-        if (source_ && directEffectFlags) {
-            // Get parameters
-            directEffectParams = simulatorOutputs_.direct;
-            directEffectParams.flags = directEffectFlags;
-            if (transmission_)
-                directEffectParams.transmissionType = IPL_TRANSMISSIONTYPE_FREQDEPENDENT;
-
-            // Apply effect using them
-            iplDirectEffectApply(directEffect_, &directEffectParams, pool.GetCurrentBuffer(), pool.GetNextBuffer());
-            pool.SwitchToNextBuffer();
+IPLAudioBuffer* SteamSoundSource::ReadInputBuffer(const MixParameters& parameters, float gain)
+{
+    const unsigned frameSize = audio_->GetFrameSize();
+
+    // Read the float copy of the sound directly unless the block needs resampling or wraps around
+    if (floatData_ && !parameters.filterBank_) {
+        if (position_ >= floatData_->numFrames_ && parameters.loop_)
+            position_ = 0;
+
+        if (position_ + frameSize <= floatData_->numFrames_) {
+            for (unsigned channel = 0; channel != floatData_->numChannels_; channel++) {
+                const float* floatData = floatData_->GetChannel(channel) + position_;
+                if (gain == 1.0f) {
+                    // Effects never write to their input, so the copy can be used without copying
+                    floatDataChannels_[channel] = const_cast<float*>(floatData);
+                } else {
+                    float* dest = inputBuffer_.data[channel];
+                    for (unsigned frame = 0; frame != frameSize; frame++)
+                        dest[frame] = floatData[frame]*gain;
+                }
+            }
+            position_ += frameSize;
+            finished_.store(false, std::memory_order_relaxed);
+
+            if (gain != 1.0f)
+                return &inputBuffer_;
+            floatDataView_ = IPLAudioBuffer {
+                .numChannels = static_cast<IPLint32>(floatData_->numChannels_),
+                .numSamples = static_cast<IPLint32>(frameSize),
+                .data = floatDataChannels_.data()
+            };
+            return &floatDataView_;
         }
     }
 
-    // Increment to next frame
-    frame_++;
+    // Convert to interleaved float and deinterleave
+    if (!ReadInputFrame(parameters, gain))
+        return nullptr;
+    iplAudioBufferDeinterleave(audio_->GetPhononContext(), conversionBuffer_.data(), &inputBuffer_);
+    return &inputBuffer_;
+}
+
+void SteamSoundSource::SkipInputFrame(const MixParameters& parameters)
+{
+    const unsigned numFrames = static_cast<unsigned>(audio_->GetFrameSize()*parameters.step_);
+
+    if (streamSource_) {
+        const bool finished = streamSource_->finished_.load(std::memory_order_acquire);
+        const unsigned numDiscarded = streamSource_->buffer_.Discard(numFrames*inputBuffer_.numChannels);
+        finished_.store(!numDiscarded && finished, std::memory_order_relaxed);
+        return;
+    }
 
-    // Don't process any further for now, just return that buffer as is...
-    return pool.GetCurrentBuffer();
+    const unsigned totalFrames = playingSound_->GetDataSize()/playingSound_->GetSampleSize();
+    if (!totalFrames)
+        return;
+    position_ += numFrames;
+    if (position_ >= totalFrames)
+        position_ = parameters.loop_?position_%totalFrames:totalFrames;
+    finished_.store(position_ >= totalFrames, std::memory_order_relaxed);
 }
 
 IPLSimulationFlags SteamSoundSource::SimulationFlags() const
@@ -272,7 +587,7 @@ IPLSimulationFlags SteamSoundSource::SimulationFlags() const
     return static_cast<IPLSimulationFlags>(fres);
 }
 
-void SteamSoundSource::HandleRenderUpdate(StringHash eventType, VariantMap &eventData)
+void SteamSoundSource::HandleAudioUpdate(StringHash eventType, VariantMap &eventData)
 {
     if (effectsDirty_) {
         UpdateEffects();
@@ -285,6 +600,16 @@ void SteamSoundSource::OnMarkedDirty(Node *)
     UpdateSimulationInputs();
 }
 
+IPLint32 SteamSoundSource::ImpulseResponseSize() const
+{
+    const auto samplingRate = audio_->GetAudioSettings().samplingRate;
+
+    // Hybrid reverb only convolves up to the transition
+    if (effectsReflectionType_ == IPL_REFLECTIONEFFECTTYPE_HYBRID)
+        return static_cast<IPLint32>(effectsHybridTransitionTime_*samplingRate);
+    return static_cast<IPLint32>(audio_->ImpulseResponseDuration()*samplingRate);
+}
+
 bool SteamSoundSource::UsingDirectEffect() const
 {
     return distanceAttenuation_ || airAbsorption_ || occlusion_ || transmission_;
@@ -305,12 +630,28 @@ void SteamSoundSource::UpdateEffects()
     const auto phononContext = audio_->GetPhononContext();
     const auto& audioSettings = audio_->GetAudioSettings();
 
-    // Destroy previous effects
-    MutexLock Lock(effectsMutex_);
-
+    // Destroy previous effects once the audio thread stopped using them
+    SuspendEffects();
     UnlockedDestroyEffects();
 
-    if (!sound_)
+    // Swap sound and stream and restart playback if requested, the audio thread is not using either
+    if (soundStream_)
+        playingSound_.Reset();
+    else
+        playingSound_ = sound_;
+    floatData_ = playingSound_?playingSound_->GetFloatData():nullptr;
+    UnlockedUpdateStreamSource();
+
+    // Name the profiler zone of this source after its node and sound
+    const Node* node = GetNode();
+    profileName_ = Format("{} ({})", node?node->GetName():EMPTY_STRING, sound_?sound_->GetName():EMPTY_STRING);
+    if (restartPending_) {
+        position_ = 0;
+        finished_.store(false, std::memory_order_relaxed);
+        restartPending_ = false;
+    }
+
+    if (!sound_ && !soundStream_)
         return;
 
     // Create new effects
@@ -320,44 +661,97 @@ void SteamSoundSource::UpdateEffects()
             .hrtf = audio_->GetHRTF()
         };
         iplBinauralEffectCreate(phononContext, const_cast<IPLAudioSettings*>(&audioSettings), &binauralEffectSettings, &binauralEffect_);
-    }
 
-    if (UsingDirectEffect()) {
-        // Create source
-        IPLSourceSettings sourceSettings {
-            .flags = SimulationFlags()
+        // Create panning effect for lower effect LOD, it outputs the same layout as the binaural effect
+        IPLPanningEffectSettings panningEffectSettings {
+            .speakerLayout = {.type = IPL_SPEAKERLAYOUTTYPE_STEREO}
         };
-        iplSourceCreate(audio_->GetSimulator(), &sourceSettings, &source_);
-        iplSourceAdd(source_, audio_->GetSimulator());
+        iplPanningEffectCreate(phononContext, const_cast<IPLAudioSettings*>(&audioSettings), &panningEffectSettings, &panningEffect_);
+    }
+
+    // The shared reflection bus dictates ambisonics order, it takes convolution into its mixers and the other algorithms into its lane buffers.
+    // Decoded per source, parametric reverb is omnidirectional
+    effectsReflectionType_ = audio_->ResolveReflectionEffectType(reflectionType_);
+    effectsHybridTransitionTime_ = Clamp(hybridTransitionTime_, 0.0f, audio_->ImpulseResponseDuration());
+    effectsUseReflectionBus_ = audio_->GetReflectionMixMode() == RMM_SHARED_BUS;
+    if (effectsUseReflectionBus_)
+        effectsAmbisonicsOrder_ = audio_->GetReflectionBusOrder();
+    else if (effectsReflectionType_ == IPL_REFLECTIONEFFECTTYPE_PARAMETRIC)
+        effectsAmbisonicsOrder_ = 0;
+    else
+        effectsAmbisonicsOrder_ = reflectionAmbisonicsOrder_;
+
+    if (UsingDirectEffect() || reflection_) {
+        // Create source, it is added to the simulator on the simulation thread
+        simulationSource_ = ea::make_shared<SteamAudioSimulationSource>(SimulationFlags());
         UpdateSimulationInputs();
-        audio_->MarkSimulatorDirty();
+        audio_->AddSimulationSource(simulationSource_);
+    }
 
-        // Create direct effect
+    if (UsingDirectEffect()) {
+        // Create direct effect, it processes the output of the binaural effect if there is one
         IPLDirectEffectSettings directEffectSettings {
-            .numChannels = sound_->IsStereo()?2:1
+            .numChannels = static_cast<IPLint32>(binaural_?audio_->GetChannelCount():(IsStereoInput()?2:1))
         };
         iplDirectEffectCreate(phononContext, const_cast<IPLAudioSettings*>(&audioSettings), &directEffectSettings, &directEffect_);
     }
 
     if (reflection_) {
         IPLReflectionEffectSettings reflectionEffectSettings {};
-        reflectionEffectSettings.type = IPL_REFLECTIONEFFECTTYPE_CONVOLUTION;
-        reflectionEffectSettings.irSize = audio_->ImpulseResponseDuration() * audioSettings.samplingRate; // (IR duration) * (sampling rate)
-        reflectionEffectSettings.numChannels = audio_->ChannelCount(reflectionAmbisonicsOrder_);
+        reflectionEffectSettings.type = effectsReflectionType_;
+        reflectionEffectSettings.irSize = ImpulseResponseSize();
+        reflectionEffectSettings.numChannels = audio_->ChannelCount(effectsAmbisonicsOrder_);
 
         iplReflectionEffectCreate(phononContext, const_cast<IPLAudioSettings*>(&audioSettings), &reflectionEffectSettings, &reflectionEffect_);
 
+        // Create parametric reverb for lower effect LOD, only simulators estimating reverb can drive it
+        if (effectsReflectionType_ != IPL_REFLECTIONEFFECTTYPE_PARAMETRIC && audio_->ResolveReflectionEffectType(RET_PARAMETRIC) == IPL_REFLECTIONEFFECTTYPE_PARAMETRIC) {
+            reflectionEffectSettings.type = IPL_REFLECTIONEFFECTTYPE_PARAMETRIC;
+            iplReflectionEffectCreate(phononContext, const_cast<IPLAudioSettings*>(&audioSettings), &reflectionEffectSettings, &reducedReflectionEffect_);
+        }
+    }
+
+    if (reflection_ && !effectsUseReflectionBus_) {
         IPLAmbisonicsBinauralEffectSettings ambisonicsBinauralEffectSettings {
             .hrtf = audio_->GetHRTF(),
-            .maxOrder = static_cast<IPLint32>(reflectionAmbisonicsOrder_)
+            .maxOrder = static_cast<IPLint32>(effectsAmbisonicsOrder_)
         };
         iplAmbisonicsBinauralEffectCreate(phononContext, const_cast<IPLAudioSettings*>(&audioSettings), &ambisonicsBinauralEffectSettings, &ambisonicsBinauralEffect_);
     }
 
+    // Remember settings the effects were created with, attributes may change before the next rebuild
+    directEffectFlags_ = IPLDirectEffectFlags {};
+    if (directEffect_) {
+        if (distanceAttenuation_)
+            directEffectFlags_ = static_cast<IPLDirectEffectFlags>(directEffectFlags_ | IPL_DIRECTEFFECTFLAGS_APPLYDISTANCEATTENUATION);
+        if (airAbsorption_)
+            directEffectFlags_ = static_cast<IPLDirectEffectFlags>(directEffectFlags_ | IPL_DIRECTEFFECTFLAGS_APPLYAIRABSORPTION);
+        if (occlusion_)
+            directEffectFlags_ = static_cast<IPLDirectEffectFlags>(directEffectFlags_ | IPL_DIRECTEFFECTFLAGS_APPLYOCCLUSION);
+        if (transmission_)
+            directEffectFlags_ = static_cast<IPLDirectEffectFlags>(directEffectFlags_ | IPL_DIRECTEFFECTFLAGS_APPLYTRANSMISSION);
+    }
+
+    // Size scratch buffers so generating audio never has to allocate
+    UnlockedAllocateBuffers();
+    renderedEffectLod_ = effectLod_;
+    effectsLoaded_ = true;
+
+    // Hand everything over to the audio thread
+    PublishParameters();
+    effectsReady_.store(true, std::memory_order_release);
+
     // Start listening
     GetNode()->AddListener(this);
 }
 
+void SteamSoundSource::SuspendEffects()
+{
+    effectsReady_.store(false, std::memory_order_seq_cst);
+    if (audio_)
+        audio_->SynchronizeWithAudioThread();
+}
+
 void SteamSoundSource::UnlockedDestroyEffects()
 {
     if (!effectsLoaded_)
@@ -365,26 +759,112 @@ void SteamSoundSource::UnlockedDestroyEffects()
 
     if (binauralEffect_)
         iplBinauralEffectRelease(&binauralEffect_);
+    if (panningEffect_)
+        iplPanningEffectRelease(&panningEffect_);
     if (directEffect_)
         iplDirectEffectRelease(&directEffect_);
-    if (source_) {
-        // Delete source
-        iplSourceRemove(source_, audio_->GetSimulator());
-        audio_->MarkSimulatorDirty();
-        iplSourceRelease(&source_);
-
-        // Stop listening
-        GetNode()->RemoveListener(this);
+    if (reflectionEffect_)
+        iplReflectionEffectRelease(&reflectionEffect_);
+    if (reducedReflectionEffect_)
+        iplReflectionEffectRelease(&reducedReflectionEffect_);
+    if (ambisonicsBinauralEffect_)
+        iplAmbisonicsBinauralEffectRelease(&ambisonicsBinauralEffect_);
+    if (simulationSource_) {
+        // Delete source, the simulation keeps its own reference until removed
+        audio_->RemoveSimulationSource(simulationSource_);
+        simulationSource_.reset();
     }
+
+    // Stop listening
+    if (node_)
+        node_->RemoveListener(this);
+
+    UnlockedFreeBuffers();
+    effectsLoaded_ = false;
+}
+
+void SteamSoundSource::UnlockedAllocateBuffers()
+{
+    const auto phononContext = audio_->GetPhononContext();
+    const auto& audioSettings = audio_->GetAudioSettings();
+    const IPLint32 soundChannels = IsStereoInput()?2:1;
+
+    conversionBuffer_.resize(audioSettings.frameSize*soundChannels);
+    resampler_.Initialize(soundChannels, audioSettings.frameSize);
+    resampleBuffer_.resize((static_cast<unsigned>(ceil(audioSettings.frameSize*AudioResampler::MaxStep)) + ResamplerFilterBank::NumTaps + 1)*soundChannels);
+    iplAudioBufferAllocate(phononContext, soundChannels, audioSettings.frameSize, &inputBuffer_);
+    iplAudioBufferAllocate(phononContext, audio_->GetChannelCount(), audioSettings.frameSize, &outputBuffer_);
+    if (UsingDirectEffect())
+        iplAudioBufferAllocate(phononContext, soundChannels, audioSettings.frameSize, &directBuffer_);
+    if (reflection_ || binaural_)
+        iplAudioBufferAllocate(phononContext, 1, audioSettings.frameSize, &monoBuffer_);
+    if (reflection_)
+        iplAudioBufferAllocate(phononContext, audio_->ChannelCount(effectsAmbisonicsOrder_), audioSettings.frameSize, &ambisonicsBuffer_);
+    if (reducedReflectionEffect_)
+        iplAudioBufferAllocate(phononContext, audio_->ChannelCount(effectsAmbisonicsOrder_), audioSettings.frameSize, &reducedAmbisonicsBuffer_);
+    if (reflection_ && !effectsUseReflectionBus_)
+        iplAudioBufferAllocate(phononContext, audio_->GetChannelCount(), audioSettings.frameSize, &reflectionBuffer_);
+    if (binaural_)
+        iplAudioBufferAllocate(phononContext, 2, audioSettings.frameSize, &panningBuffer_);
+}
+
+void SteamSoundSource::UnlockedFreeBuffers()
+{
+    const auto phononContext = audio_->GetPhononContext();
+    for (IPLAudioBuffer* buffer : {&inputBuffer_, &outputBuffer_, &directBuffer_, &monoBuffer_, &panningBuffer_, &ambisonicsBuffer_, &reducedAmbisonicsBuffer_, &reflectionBuffer_}) {
+        if (buffer->data)
+            iplAudioBufferFree(phononContext, buffer);
+        *buffer = IPLAudioBuffer {};
+    }
+    conversionBuffer_.clear();
+    resampleBuffer_.clear();
+}
+
+bool SteamSoundSource::IsStereoInput() const
+{
+    return soundStream_?soundStream_->IsStereo():sound_->IsStereo();
+}
+
+void SteamSoundSource::UnlockedUpdateStreamSource()
+{
+    const bool sameStream = streamSource_ && streamSource_->stream_ == soundStream_;
+    if (sameStream && !restartPending_)
+        return;
+
+    // Stop decoding the previous stream
+    if (streamSource_) {
+        audio_->RemoveStreamSource(streamSource_);
+        streamSource_.reset();
+    }
+    if (!soundStream_)
+        return;
+
+    // Playing the same stream again starts it over, streams that cannot seek continue where they are
+    if (sameStream)
+        soundStream_->Seek(0);
+
+    // Buffer a quarter of a second, but at least a few blocks
+    const unsigned channels = soundStream_->IsStereo()?2:1;
+    const unsigned capacity = Max(soundStream_->GetIntFrequency()/4, audio_->GetFrameSize()*4)*channels;
+    streamSource_ = ea::make_shared<SteamAudioStreamSource>(soundStream_, capacity);
+    streamSource_->controlsLoop_ = sound_ != nullptr;
+    streamSource_->loop_.store(loop_, std::memory_order_relaxed);
+    audio_->AddStreamSource(streamSource_);
 }
 
 void SteamSoundSource::UpdateSimulationInputs()
 {
+    if (!simulationSource_)
+        return;
+
     const auto lUp = GetNode()->GetWorldUp();
     const auto lDir = GetNode()->GetWorldDirection();
     const auto lRight = GetNode()->GetWorldRight();
     const auto lPos = GetNode()->GetWorldPosition();
 
+    // A hybrid simulator fades out impulse responses after the transition, which convolution sources must not see
+    const bool hybridTransition = effectsReflectionType_ == IPL_REFLECTIONEFFECTTYPE_HYBRID;
+
     IPLSimulationInputs inputs {
         .flags = SimulationFlags(),
         .directFlags = static_cast<IPLDirectSimulationFlags>(
@@ -405,11 +885,13 @@ void SteamSoundSource::UpdateSimulationInputs()
         .occlusionRadius = 0.25f,
         .numOcclusionSamples = 8,
         .reverbScale = {1.0f, 1.0f, 1.0f},
-        .hybridReverbTransitionTime = 1.0f,
-        .hybridReverbOverlapPercent = 0.25f,
+        .hybridReverbTransitionTime = hybridTransition?effectsHybridTransitionTime_:audio_->ImpulseResponseDuration(),
+        .hybridReverbOverlapPercent = hybridTransition?Clamp(hybridOverlap_, 0.0f, 1.0f):0.0f,
+        .baked = bakedReflections_?IPL_TRUE:IPL_FALSE,
+        .bakedDataIdentifier = SteamAudioProbeVolume::GetReverbIdentifier(),
         .numTransmissionRays = 16
     };
-    iplSourceSetInputs(source_, SimulationFlags(), &inputs);
+    simulationSource_->inputs_.Publish(inputs);
 }
 
 }
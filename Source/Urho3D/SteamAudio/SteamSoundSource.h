@@ -22,16 +22,28 @@
 
 #pragma once
 
+#include "../Audio/AudioResampler.h"
+#include "../SteamAudio/SteamAudioDefs.h"
+#include "../Container/TripleBuffer.h"
 #include "../Scene/Component.h"
 
+#include <EASTL/array.h>
+#include <EASTL/shared_ptr.h>
+
 #include <phonon.h>
 
+#include <atomic>
+
 namespace Urho3D
 {
 
 class SteamAudio;
+struct SteamAudioMixContext;
+struct SteamAudioSimulationSource;
+struct SteamAudioStreamSource;
 class Sound;
 class SoundStream;
+struct SoundFloatData;
 
 /// %Sound source component with stereo position. A sound source needs to be created to a node to be considered "enabled" and be able to play, however that node does not need to belong to a scene.
 class URHO3D_API SteamSoundSource : public Component
@@ -47,12 +59,16 @@ public:
     /// @nobind
     static void RegisterObject(Context* context);
 
-    /// Play a sound.
+    /// Play a sound. Compressed sounds are decoded ahead of playback on the decoder thread.
     void Play(Sound *sound);
+    /// Play a sound stream. It is decoded ahead of playback on the decoder thread.
+    void Play(SoundStream *stream);
 
     /// Return whether is playing.
     /// @property
     bool IsPlaying() const;
+    /// Return whether a sound that does not loop has played to its end. Updated by the audio thread.
+    bool IsFinished() const { return finished_.load(std::memory_order_relaxed); }
 
     /// Set playing attribute.
     void SetPlayingAttr(bool playing);
@@ -62,49 +78,181 @@ public:
     /// Return sound attribute.
     ResourceRef GetSoundAttr() const;
 
-    /// Generate sound.
-    IPLAudioBuffer *GenerateAudioBuffer(float gain);
+    /// Set voice priority. Sources of higher priority stay real first when the voice limit is reached.
+    void SetPriority(int priority) { priority_ = priority; }
+    /// Return voice priority.
+    int GetPriority() const { return priority_; }
+    /// Return estimated loudness at the listener position, used to rank voices.
+    float GetAudibility(const Vector3& listenerPosition) const;
+    /// Set whether the source is virtual. Virtual sources only advance their playback position. Called by the audio subsystem.
+    void SetVirtual(bool isVirtual) { virtual_ = isVirtual; }
+    /// Return whether the source was virtual in the last update.
+    bool IsVirtual() const { return virtual_; }
+    /// Set effect LOD. Called by the audio subsystem.
+    void SetEffectLod(EffectLOD lod) { effectLod_ = lod; }
+    /// Return effect LOD chosen in the last update.
+    EffectLOD GetEffectLod() const { return effectLod_; }
+    /// Set reflection algorithm, default follows the audio subsystem. Only honoured if the audio subsystem uses hybrid reverb.
+    void SetReflectionType(ReflectionEffectType type) { reflectionType_ = type; MarkEffectsDirty(); }
+    /// Return requested reflection algorithm.
+    ReflectionEffectType GetReflectionType() const { return reflectionType_; }
+    /// Set seconds of impulse response convolved before hybrid reverb switches to parametric, and the fraction of it over which both are blended.
+    void SetHybridReverb(float transitionTime, float overlap) { hybridTransitionTime_ = transitionTime; hybridOverlap_ = overlap; MarkEffectsDirty(); }
+    /// Return hybrid reverb transition time.
+    float GetHybridTransitionTime() const { return hybridTransitionTime_; }
+    /// Return hybrid reverb overlap.
+    float GetHybridOverlap() const { return hybridOverlap_; }
+    /// Set frequency multiplier. Changes speed and pitch together.
+    void SetPitch(float pitch) { pitch_ = pitch; }
+    /// Return frequency multiplier.
+    float GetPitch() const { return pitch_; }
+
+    /// Mark effects dirty. They are recreated on next render update.
+    void MarkEffectsDirty() { effectsDirty_ = true; }
+    /// Stop the audio thread from accessing effects and buffers until they are recreated.
+    void SuspendEffects();
+
+    /// Publish parameters to the audio thread. Called by the audio subsystem every update.
+    void PublishParameters();
+    /// Generate sound. Reflections are mixed into the shared reflection bus instead if there is one. Called from an audio thread, never blocks.
+    IPLAudioBuffer *GenerateAudioBuffer(const SteamAudioMixContext& mixContext);
+    /// Advance playback position by one block without generating sound. Called from an audio thread, never blocks.
+    void SkipAudioBuffer();
+    /// Return time spent generating the last block in milliseconds.
+    float GetLastMixTime() const { return lastMixTime_.load(std::memory_order_relaxed); }
 
 private:
+    /// Parameters published to the audio thread.
+    struct MixParameters
+    {
+        /// Direction from listener to source for binaural effect.
+        IPLVector3 direction_{};
+        /// Audio gain.
+        float gain_{1.0f};
+        /// Binaural spatial blend.
+        float binauralSpatialBlend_{1.0f};
+        /// Bilinear interpolation for binaural effect.
+        bool binauralBilinearInterpolation_{};
+        /// Is sound playing and the component enabled?
+        bool playing_{};
+        /// Will playback loop?
+        bool loop_{};
+        /// Is the source virtual?
+        bool virtual_{};
+        /// Effect LOD.
+        EffectLOD effectLod_{ELOD_FULL};
+        /// Input samples per output sample.
+        double step_{1.0};
+        /// Resampling filter, null if the sound plays at the output sampling rate.
+        const ResamplerFilterBank* filterBank_{};
+    };
+
     /// Returns simulation flags.
     IPLSimulationFlags SimulationFlags() const;
+    /// Generate sound once effects are known to be ready. Called from an audio thread.
+    IPLAudioBuffer* RenderAudioBuffer(const SteamAudioMixContext& mixContext);
 
-    /// Handle render update event.
-    void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle audio subsystem update event.
+    void HandleAudioUpdate(StringHash eventType, VariantMap& eventData);
     /// Handle transform change.
     void OnMarkedDirty(Node *) override;
 
-    /// Mark effects dirty.
-    void MarkEffectsDirty() { effectsDirty_ = true; }
-
+    /// Return number of impulse response samples to convolve. Parametric reverb ignores it.
+    IPLint32 ImpulseResponseSize() const;
     /// Returns false if there is no direct effect in use.
     bool UsingDirectEffect() const;
 
     /// Recreate effects
     void UpdateEffects();
-    /// Destroy effects
+    /// Destroy effects. Effects must be suspended.
     void UnlockedDestroyEffects();
+    /// Allocate scratch buffers used while generating audio. Sized for current sound and effects.
+    void UnlockedAllocateBuffers();
+    /// Free scratch buffers.
+    void UnlockedFreeBuffers();
     /// Update simulation inputs.
     void UpdateSimulationInputs();
+    /// Return whether the current sound or stream is stereo.
+    bool IsStereoInput() const;
+    /// Replace the decoded stream if the requested one changed or playback restarts. Effects must be suspended.
+    void UnlockedUpdateStreamSource();
+    /// Read interleaved float samples of the sound or stream and advance, padding with silence. Return false if playback has finished. Called from an audio thread.
+    bool ReadSource(float* dest, unsigned numFrames, bool loop);
+    /// Return one block at the output sampling rate with gain applied, or null if playback has finished. Called from an audio thread.
+    IPLAudioBuffer* ReadInputBuffer(const MixParameters& parameters, float gain);
+    /// Read one block at the output sampling rate into the conversion buffer and apply gain. Return false if playback has finished. Called from an audio thread.
+    bool ReadInputFrame(const MixParameters& parameters, float gain);
+    /// Advance playback position by one block. Called from an audio thread.
+    void SkipInputFrame(const MixParameters& parameters);
 
     /// Steam audio subsystem.
     WeakPtr<SteamAudio> audio_;
-    /// Currently playing sound.
+    /// Current sound.
     SharedPtr<Sound> sound_;
+    /// Current stream, either set directly or decoding a compressed sound.
+    SharedPtr<SoundStream> soundStream_;
+    /// Sound used by the audio thread, changes together with effects. Null while playing a stream.
+    SharedPtr<Sound> playingSound_;
+    /// Decoded stream used by the audio thread, changes together with effects.
+    ea::shared_ptr<SteamAudioStreamSource> streamSource_;
+    /// Float copy of the sound used by the audio thread, changes together with effects.
+    ea::shared_ptr<const SoundFloatData> floatData_;
+    /// Channel pointers into the float copy of the sound.
+    ea::array<float*, 2> floatDataChannels_{};
+    /// Input buffer pointing into the float copy of the sound.
+    IPLAudioBuffer floatDataView_{};
     /// Binaural effect.
     IPLBinauralEffect binauralEffect_;
+    /// Panning effect replacing the binaural effect at lower effect LOD.
+    IPLPanningEffect panningEffect_{};
     /// Ambisonics binaural effect (for reflection).
     IPLAmbisonicsBinauralEffect ambisonicsBinauralEffect_;
     /// Direct effect.
     IPLDirectEffect directEffect_;
     /// Reflection effect.
     IPLReflectionEffect reflectionEffect_;
-    /// Sound source.
-    IPLSource source_;
-    /// Last simulator outputs.
-    IPLSimulationOutputs simulatorOutputs_;
-    /// Mutex for effects.
-    Mutex effectsMutex_;
+    /// Parametric reverb replacing the reflection effect at reduced effect LOD, if the simulator estimates reverb.
+    IPLReflectionEffect reducedReflectionEffect_{};
+    /// Simulation state.
+    ea::shared_ptr<SteamAudioSimulationSource> simulationSource_;
+    /// Direct effect flags the effects were created with.
+    IPLDirectEffectFlags directEffectFlags_{};
+    /// Ambisonics order the reflection effect was created with.
+    unsigned effectsAmbisonicsOrder_{};
+    /// Reflection algorithm the reflection effect was created with.
+    IPLReflectionEffectType effectsReflectionType_{IPL_REFLECTIONEFFECTTYPE_CONVOLUTION};
+    /// Hybrid reverb transition time the reflection effect was created with.
+    float effectsHybridTransitionTime_{};
+    /// Was the reflection effect created for the shared reflection bus?
+    bool effectsUseReflectionBus_{};
+    /// Parameters published to the audio thread.
+    TripleBuffer<MixParameters> parameters_;
+    /// Interleaved float buffer for converted sound data.
+    ea::vector<float> conversionBuffer_;
+    /// Deinterleaved input buffer with the channel count of the sound.
+    IPLAudioBuffer inputBuffer_{};
+    /// Mono downmix buffer (for reflection and panning).
+    IPLAudioBuffer monoBuffer_{};
+    /// Panning output cross-faded with binaural output while effect LOD changes.
+    IPLAudioBuffer panningBuffer_{};
+    /// Ambisonics buffer (for reflection).
+    IPLAudioBuffer ambisonicsBuffer_{};
+    /// Parametric reverb output cross-faded with full reflections while effect LOD changes.
+    IPLAudioBuffer reducedAmbisonicsBuffer_{};
+    /// Reflections decoded to the output channel layout, added to the dry signal once it is processed.
+    IPLAudioBuffer reflectionBuffer_{};
+    /// Direct effect output buffer with the channel count of the sound.
+    IPLAudioBuffer directBuffer_{};
+    /// Output buffer with the channel count of the audio subsystem.
+    IPLAudioBuffer outputBuffer_{};
+    /// Sample rate converter.
+    AudioResampler resampler_;
+    /// Interleaved input of the sample rate converter.
+    ea::vector<float> resampleBuffer_;
+    /// Step the filter bank was looked up for.
+    double filterBankStep_{1.0};
+    /// Resampling filter for the current step.
+    const ResamplerFilterBank* filterBank_{};
     /// Audio gain.
     float gain_;
     /// Is playback paused?
@@ -125,16 +273,46 @@ private:
     bool reflection_;
     /// Ambisonics order for reflection.
     unsigned reflectionAmbisonicsOrder_;
+    /// Look up reflections in baked probe volumes instead of tracing rays.
+    bool bakedReflections_{};
+    /// Requested reflection algorithm.
+    ReflectionEffectType reflectionType_{RET_DEFAULT};
+    /// Seconds of impulse response convolved before hybrid reverb switches to parametric.
+    float hybridTransitionTime_{1.0f};
+    /// Fraction of the hybrid transition time over which convolution and parametric reverb are blended.
+    float hybridOverlap_{0.25f};
     /// Binaural spatial blend.
     float binauralSpatialBlend_;
     /// Bilinear interpolation for binaural effect.
     bool binauralBilinearInterpolation_;
-    /// Playback position.
-    unsigned frame_;
-    // Are the effects loaded?
+    /// Frequency multiplier.
+    float pitch_{1.0f};
+    /// Voice priority.
+    int priority_{};
+    /// Is the source virtual?
+    bool virtual_{};
+    /// Effect LOD.
+    EffectLOD effectLod_{ELOD_FULL};
+    /// Effect LOD of the last generated block. Owned by the audio thread while effects are ready.
+    EffectLOD renderedEffectLod_{ELOD_FULL};
+    /// Playback position in sample frames. Owned by the audio thread while effects are ready.
+    unsigned position_{};
+    /// Should playback restart once effects are recreated?
+    bool restartPending_{};
+    /// Has the sound played to its end? Set by the audio thread, cleared on restart.
+    std::atomic<bool> finished_{};
+    /// Are the effects loaded?
     bool effectsLoaded_;
     /// Are effects dirty?
     bool effectsDirty_;
+    /// May the audio thread access effects and buffers?
+    std::atomic<bool> effectsReady_{};
+    /// Is a mix lane generating this block? A mix worker late for one block may still be when the next starts.
+    std::atomic<bool> rendering_{};
+    /// Profiler zone name, changes together with effects.
+    ea::string profileName_;
+    /// Time spent generating the last block in milliseconds.
+    std::atomic<float> lastMixTime_{};
 };
 
 }
@@ -34,6 +34,9 @@
 #include "../Graphics/Renderer.h"
 #include "../IO/Log.h"
 #include "../RenderAPI/RenderDevice.h"
+#ifdef URHO3D_STEAM_AUDIO
+#include "../SteamAudio/SteamAudio.h"
+#endif
 #include "../SystemUI/SystemUI.h"
 #include "../UI/UI.h"
 
@@ -170,6 +173,22 @@ void DebugHud::RenderUI(DebugHudModeFlags mode)
         ui::Text("Animations %u(%u)", stats.animations_, numChangedAnimations_[0]);
         ui::SetCursorPosX(left_offset);
 
+#ifdef URHO3D_STEAM_AUDIO
+        auto audio = GetSubsystem<SteamAudio>();
+        if (audio && audio->GetPhononContext())
+        {
+            const SteamAudioStats audioStats = audio->GetStats();
+            ui::Text("Audio mix %.2f/%.2f ms (max %.2f)", audioStats.lastMixTime_, audioStats.blockDuration_, audioStats.maxMixTime_);
+            ui::SetCursorPosX(left_offset);
+            ui::Text("Audio sources %u (%u virtual)", audioStats.numActiveSources_, audio->GetNumVirtualVoices());
+            ui::SetCursorPosX(left_offset);
+            ui::Text("Audio late blocks %u/%u, skipped sources %u", audioStats.numLateBlocks_, audioStats.numBlocks_, audioStats.numSkippedSourceBlocks_);
+            ui::SetCursorPosX(left_offset);
+            ui::Text("Audio lock contention %u", audioStats.numSimulationLockContentions_);
+            ui::SetCursorPosX(left_offset);
+        }
+#endif
+
         for (auto i = appStats_.begin(); i != appStats_.end(); ++i)
         {
             ui::Text("%s %s", i->first.c_str(), i->second.c_str());